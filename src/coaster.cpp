@@ -12,11 +12,13 @@
 #include <cmath>
 #include "stdafx.h"
 #include "sprite_store.h"
+#include "sprite_data.h"
 #include "coaster.h"
 #include "fileio.h"
 #include "memory.h"
 #include "map.h"
 #include "viewport.h"
+#include "gamecontrol.h"
 
 #include "generated/coasters_strings.cpp"
 
@@ -214,14 +216,30 @@ bool LoadCoasterPlatform(RcdFileReader *rcdfile, const ImageMap &sprites)
 	return true;
 }
 
-DisplayCoasterCar::DisplayCoasterCar() : VoxelObject(), yaw(0xff) // Mark everything as invalid.
+DisplayCoasterCar::DisplayCoasterCar() : VoxelObject(), yaw(0xff), move(0, 0, 0), move_tick(0) // Mark everything as invalid.
 {
 }
 
 const ImageData *DisplayCoasterCar::GetSprite(const SpriteStorage *sprites, ViewOrientation orient, const Recolouring **recolour) const
 {
 	*recolour = nullptr;
-	return this->car_type->GetCar(this->pitch, this->roll, (this->yaw + orient * 4) & 0xF);
+	const ImageData *car = this->car_type->GetCar(this->pitch, this->roll, (this->yaw + orient * 4) & 0xF);
+	return (car != nullptr) ? car->GetZoomed(sprites->size) : nullptr;
+}
+
+/**
+ * Get the offset of the car between ticks. The car is drawn between its previous and its current position, which
+ * delays the displayed movement by one tick.
+ * @param progress Number of milliseconds of game time since the last tick.
+ * @return Offset to add to the #pix_pos of the car.
+ */
+XYZPoint16 DisplayCoasterCar::GetRenderOffset(uint32 progress) const
+{
+	if (this->move_tick + 1 != _game_clock.GetTickCount()) return XYZPoint16(0, 0, 0); // Car did not move in the last tick.
+
+	int32 remaining = TICK_LENGTH - std::min(progress, TICK_LENGTH);
+	return XYZPoint16(-this->move.x * remaining / (int32)TICK_LENGTH, -this->move.y * remaining / (int32)TICK_LENGTH,
+			-this->move.z * remaining / (int32)TICK_LENGTH);
 }
 
 /**
@@ -247,6 +265,17 @@ void DisplayCoasterCar::Set(const XYZPoint16 &vox_pos, const XYZPoint16 &pix_pos
 		this->RemoveSelf(v);
 	}
 
+	/* Remember the movement for drawing the car between ticks, unless it jumps (for example at the start of the ride). */
+	XYZPoint16 move(0, 0, 0);
+	if (this->yaw != 0xff) {
+		int32 dx = (vox_pos.x - this->vox_pos.x) * 256 + pix_pos.x - this->pix_pos.x;
+		int32 dy = (vox_pos.y - this->vox_pos.y) * 256 + pix_pos.y - this->pix_pos.y;
+		int32 dz = (vox_pos.z - this->vox_pos.z) * 256 + pix_pos.z - this->pix_pos.z;
+		if (abs(dx) < 512 && abs(dy) < 512 && abs(dz) < 512) move = XYZPoint16(dx, dy, dz);
+	}
+	this->move = move;
+	this->move_tick = _game_clock.GetTickCount();
+
 	/* Update voxel and orientation. */
 	this->vox_pos = vox_pos;
 	this->pix_pos = pix_pos;
@@ -510,6 +539,7 @@ CoasterInstance::CoasterInstance(const CoasterType *ct, const CarType *car_type)
 	for (int i = 0; i < NUMBER_ITEM_TYPES_SOLD; i++) this->item_price[i] = ct->item_cost[i] * 2;
 	this->pieces = new PositionedTrackPiece[MAX_PLACED_TRACK_PIECES]();
 	this->capacity = MAX_PLACED_TRACK_PIECES;
+	this->coaster_length = 0;
 	for (uint i = 0; i < lengthof(this->trains); i++) {
 		CoasterTrain &train = this->trains[i];
 		train.coaster = this;
@@ -601,6 +631,90 @@ void CoasterInstance::RemoveAllPeople()
 	assert(false); // Not yet implemented.
 }
 
+void CoasterInstance::Load(Loader &ldr)
+{
+	this->RideInstance::Load(ldr);
+
+	const CoasterType *ct = this->GetCoasterType();
+	int count = ldr.GetWord();
+	if (count > this->capacity) {
+		ldr.SetFailMessage("Too many coaster track pieces");
+		return;
+	}
+	for (int i = 0; i < count && !ldr.IsFail(); i++) {
+		PositionedTrackPiece &ptp = this->pieces[i];
+		uint16 piece = ldr.GetWord();
+		ptp.base_voxel.x = ldr.GetWord();
+		ptp.base_voxel.y = ldr.GetWord();
+		ptp.base_voxel.z = ldr.GetWord();
+		ptp.distance_base = ldr.GetLong();
+		if (piece == 0xFFFF) continue;
+
+		if (piece >= ct->pieces.size()) {
+			ldr.SetFailMessage("Unknown coaster track piece");
+			return;
+		}
+		ptp.piece = ct->pieces[piece];
+		/* The world saves the voxels of the coaster as empty, put the track piece back. */
+		if (!ptp.CanBePlaced()) {
+			ptp.piece = nullptr;
+			ldr.SetFailMessage("Incorrect coaster track piece position");
+			return;
+		}
+		for (const auto &tvx : ptp.piece->track_voxels) {
+			Voxel *vx = _world.GetCreateVoxel(ptp.base_voxel + tvx->dxyz, true);
+			vx->SetInstance((SmallRideInstance)this->GetIndex());
+			vx->SetInstanceData(ct->GetTrackVoxelIndex(tvx));
+		}
+	}
+	this->coaster_length = ldr.GetLong();
+
+	for (uint i = 0; i < lengthof(this->trains) && !ldr.IsFail(); i++) {
+		CoasterTrain &train = this->trains[i];
+		int number_cars = ldr.GetByte();
+		train.back_position = ldr.GetLong();
+		train.speed = ldr.GetLong();
+		int cur_piece = ldr.GetWord();
+		if (number_cars == 0) continue;
+
+		if (cur_piece >= count || this->pieces[cur_piece].piece == nullptr || train.back_position >= this->coaster_length ||
+				(int)i >= this->GetMaxNumberOfTrains() || number_cars > this->GetMaxNumberOfCars() || this->car_type == nullptr) {
+			ldr.SetFailMessage("Incorrect coaster train");
+			return;
+		}
+		train.cur_piece = this->pieces + cur_piece;
+		train.SetLength(number_cars);
+	}
+}
+
+void CoasterInstance::Save(Saver &svr) const
+{
+	this->RideInstance::Save(svr);
+
+	const CoasterType *ct = this->GetCoasterType();
+	int count = this->capacity;
+	while (count > 0 && this->pieces[count - 1].piece == nullptr) count--;
+	svr.PutWord(count);
+	for (int i = 0; i < count; i++) {
+		const PositionedTrackPiece &ptp = this->pieces[i];
+		uint16 piece = 0xFFFF;
+		if (ptp.piece != nullptr) piece = std::find(ct->pieces.begin(), ct->pieces.end(), ptp.piece) - ct->pieces.begin();
+		svr.PutWord(piece);
+		svr.PutWord(ptp.base_voxel.x);
+		svr.PutWord(ptp.base_voxel.y);
+		svr.PutWord(ptp.base_voxel.z);
+		svr.PutLong(ptp.distance_base);
+	}
+	svr.PutLong(this->coaster_length);
+
+	for (const CoasterTrain &train : this->trains) {
+		svr.PutByte(train.cars.size());
+		svr.PutLong(train.back_position);
+		svr.PutLong(train.speed);
+		svr.PutWord(train.cur_piece - this->pieces);
+	}
+}
+
 /**
  * Check the state of the coaster ride, and set the #state flag.
  * @return The new coaster instance state.
@@ -121,6 +121,7 @@ public:
 	DisplayCoasterCar();
 
 	virtual const ImageData *GetSprite(const SpriteStorage *sprites, ViewOrientation orient, const Recolouring **recolour) const override;
+	XYZPoint16 GetRenderOffset(uint32 progress) const override;
 
 	void Set(const XYZPoint16 &vox_pos, const XYZPoint16 &pix_pos, uint8 pitch, uint8 roll, uint8 yaw);
 	void PreRemove();
@@ -129,6 +130,9 @@ public:
 	uint8 pitch;             ///< Pitch of the car.
 	uint8 roll;              ///< Roll of the car.
 	uint8 yaw;               ///< Yaw of the car (\c 0xff means all data is invalid).
+
+	XYZPoint16 move;         ///< Movement of the car (in 1/256 voxel) in tick #move_tick.
+	uint32 move_tick;        ///< Tick of the last movement of the car.
 };
 
 /** Coaster car drawn at the front and the back position. */
@@ -196,6 +200,9 @@ public:
 	XYZPoint32 GetExit(int guest, TileEdge entry_edge) override;
 	void RemoveAllPeople() override;
 
+	void Load(Loader &ldr) override;
+	void Save(Saver &svr) const override;
+
 	RideInstanceState DecideRideState();
 
 	bool MakePositionedPiecesLooping(bool *modified);
@@ -0,0 +1,242 @@
+/* $Id$ */
+
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file compress.cpp Fast compression of data, for saved games.
+ *
+ * The data is split in chunks that are compressed independently, so a chunk can be decoded as soon as it is available.
+ * A chunk starts with the number of stored bytes and the number of decoded bytes (both 4 bytes, little endian).
+ * If both numbers are equal, the chunk is stored uncompressed, else it is a sequence of LZ77 matches:
+ * - A token byte, the upper 4 bits are the number of literal bytes, the lower 4 bits the length of the match minus #MIN_MATCH.
+ *   A value of 15 means more bytes follow with the remainder of the length, until a byte is not 255.
+ * - The literal bytes.
+ * - The distance back to the start of the match in the decoded data (2 bytes, little endian), and the remainder of the match length.
+ * The last sequence of a chunk has only literal bytes.
+ */
+
+#include "stdafx.h"
+#include "compress.h"
+
+static const size_t CHUNK_SIZE = 256 * 1024; ///< Maximal number of decoded bytes in a chunk.
+static const size_t MIN_MATCH = 4;           ///< Minimal length of a match.
+static const size_t MAX_OFFSET = 0xFFFF;     ///< Maximal distance back to the start of a match.
+static const int HASH_BITS = 14;             ///< Number of bits of the hash of 4 bytes.
+
+/**
+ * Read 4 bytes in machine byte order, for comparing and hashing them.
+ * @param data Bytes to read.
+ * @return The read bytes.
+ */
+static inline uint32 Read4Bytes(const uint8 *data)
+{
+	uint32 value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+/**
+ * Write a long word in little endian order.
+ * @param data [out] Destination of the long word.
+ * @param value Value to write.
+ */
+static inline void WriteLong(uint8 *data, uint32 value)
+{
+	for (int i = 0; i < 4; i++) data[i] = value >> (8 * i);
+}
+
+/**
+ * Read a long word in little endian order.
+ * @param data Source of the long word.
+ * @return The read value.
+ */
+static inline uint32 ReadLong(const uint8 *data)
+{
+	return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32)data[3] << 24);
+}
+
+/**
+ * Write the remainder of a length that does not fit in the token byte.
+ * @param length Remainder of the length.
+ * @param out [inout] Compressed data.
+ */
+static void PutLength(size_t length, std::vector<uint8> *out)
+{
+	while (length >= 255) {
+		out->push_back(255);
+		length -= 255;
+	}
+	out->push_back(length);
+}
+
+/**
+ * Write a sequence of literal bytes followed by a match.
+ * @param literals First literal byte.
+ * @param lit_length Number of literal bytes.
+ * @param offset Distance back to the start of the match.
+ * @param match_length Length of the match, \c 0 for the last sequence of a chunk.
+ * @param out [inout] Compressed data.
+ */
+static void PutSequence(const uint8 *literals, size_t lit_length, size_t offset, size_t match_length, std::vector<uint8> *out)
+{
+	size_t match_code = (match_length == 0) ? 0 : match_length - MIN_MATCH;
+	out->push_back((std::min<size_t>(lit_length, 15) << 4) | std::min<size_t>(match_code, 15));
+	if (lit_length >= 15) PutLength(lit_length - 15, out);
+	out->insert(out->end(), literals, literals + lit_length);
+	if (match_length == 0) return;
+
+	out->push_back(offset & 0xFF);
+	out->push_back(offset >> 8);
+	if (match_code >= 15) PutLength(match_code - 15, out);
+}
+
+/**
+ * Compress a chunk of data.
+ * @param data Data to compress.
+ * @param size Length of the data.
+ * @param table [inout] Hash table with the most recent position of 4 bytes.
+ * @param out [inout] Compressed data.
+ */
+static void CompressChunk(const uint8 *data, size_t size, std::vector<uint32> *table, std::vector<uint8> *out)
+{
+	std::fill(table->begin(), table->end(), 0);
+
+	size_t anchor = 0; // Start of the pending literal bytes.
+	size_t pos = 0;
+	while (pos + MIN_MATCH <= size) {
+		uint32 bytes = Read4Bytes(data + pos);
+		uint32 &entry = (*table)[(bytes * 2654435761u) >> (32 - HASH_BITS)];
+		size_t candidate = entry;
+		entry = pos;
+		if (candidate < pos && pos - candidate <= MAX_OFFSET && Read4Bytes(data + candidate) == bytes) {
+			size_t length = MIN_MATCH;
+			while (pos + length < size && data[candidate + length] == data[pos + length]) length++;
+
+			PutSequence(data + anchor, pos - anchor, pos - candidate, length, out);
+			pos += length;
+			anchor = pos;
+		} else {
+			pos++;
+		}
+	}
+	PutSequence(data + anchor, size - anchor, 0, 0, out);
+}
+
+/**
+ * Read the remainder of a length that does not fit in the token byte.
+ * @param data [inout] Position in the compressed data.
+ * @param end End of the compressed data.
+ * @param length [inout] Length to increase.
+ * @return Whether the length could be read.
+ */
+static bool GetLength(const uint8 **data, const uint8 *end, size_t *length)
+{
+	for (;;) {
+		if (*data == end) return false;
+		uint8 value = *(*data)++;
+		*length += value;
+		if (value != 255) return true;
+	}
+}
+
+/**
+ * Decompress a chunk of data.
+ * @param data Compressed data of the chunk.
+ * @param size Length of the compressed data.
+ * @param dest [out] Destination of the decompressed data.
+ * @param dest_size Length of the decompressed data.
+ * @return Whether the chunk was decompressed correctly.
+ */
+static bool DecompressChunk(const uint8 *data, size_t size, uint8 *dest, size_t dest_size)
+{
+	const uint8 *end = data + size;
+	size_t pos = 0;
+	for (;;) {
+		if (data == end) return false;
+		uint8 token = *data++;
+
+		size_t lit_length = token >> 4;
+		if (lit_length == 15 && !GetLength(&data, end, &lit_length)) return false;
+		if ((size_t)(end - data) < lit_length || dest_size - pos < lit_length) return false;
+		memcpy(dest + pos, data, lit_length);
+		data += lit_length;
+		pos += lit_length;
+		if (data == end) return pos == dest_size; // Last sequence of the chunk.
+
+		if (end - data < 2) return false;
+		size_t offset = data[0] | (data[1] << 8);
+		data += 2;
+		size_t length = token & 15;
+		if (length == 15 && !GetLength(&data, end, &length)) return false;
+		length += MIN_MATCH;
+		if (offset == 0 || offset > pos || dest_size - pos < length) return false;
+
+		if (offset >= length) {
+			memcpy(dest + pos, dest + pos - offset, length);
+		} else {
+			for (size_t i = 0; i < length; i++) dest[pos + i] = dest[pos + i - offset]; // Overlapping copy repeats the data.
+		}
+		pos += length;
+	}
+}
+
+/**
+ * Compress data.
+ * @param data Data to compress.
+ * @param size Length of the data.
+ * @param out [inout] Compressed data is appended to it.
+ */
+void CompressData(const uint8 *data, size_t size, std::vector<uint8> *out)
+{
+	std::vector<uint32> table(1 << HASH_BITS);
+	out->reserve(out->size() + size / 2);
+
+	for (size_t start = 0; start < size; start += CHUNK_SIZE) {
+		size_t length = std::min(size - start, CHUNK_SIZE);
+		size_t header = out->size();
+		out->resize(header + 8);
+		CompressChunk(data + start, length, &table, out);
+
+		size_t stored = out->size() - (header + 8);
+		if (stored >= length) { // Compression did not help, store the chunk as-is.
+			out->resize(header + 8);
+			out->insert(out->end(), data + start, data + start + length);
+			stored = length;
+		}
+		WriteLong(out->data() + header, stored);
+		WriteLong(out->data() + header + 4, length);
+	}
+}
+
+/**
+ * Decompress data compressed by #CompressData.
+ * @param data Compressed data.
+ * @param size Length of the compressed data.
+ * @param out [inout] Decompressed data is appended to it.
+ * @return Whether the data was decompressed correctly.
+ */
+bool DecompressData(const uint8 *data, size_t size, std::vector<uint8> *out)
+{
+	const uint8 *end = data + size;
+	while (data != end) {
+		if (end - data < 8) return false;
+		size_t stored = ReadLong(data);
+		size_t length = ReadLong(data + 4);
+		data += 8;
+		if (length == 0 || length > CHUNK_SIZE || stored > length || stored > (size_t)(end - data)) return false;
+
+		size_t offset = out->size();
+		out->resize(offset + length);
+		if (stored == length) {
+			memcpy(out->data() + offset, data, length);
+		} else if (!DecompressChunk(data, stored, out->data() + offset, length)) {
+			return false;
+		}
+		data += stored;
+	}
+	return true;
+}
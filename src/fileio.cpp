@@ -20,9 +20,11 @@
 	#include "unix/fileio_unix.h"
 	#include <dirent.h>
 	#include <unistd.h>
+	#include <sys/mman.h>
 #elif WINDOWS
 	#include "windows/fileio_windows.h"
 	#include <direct.h> // contains chdir in windows
+	#include <io.h>
 #endif
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -112,28 +114,117 @@ DirectoryReader *MakeDirectoryReader()
 #endif
 }
 
+FileContents::FileContents() : data(nullptr), size(0), buffer(nullptr), mapped(false)
+{
+}
+
+FileContents::~FileContents()
+{
+#ifdef LINUX
+	if (this->mapped) munmap(const_cast<uint8 *>(this->data), this->size);
+#elif WINDOWS
+	if (this->mapped) UnmapViewOfFile(this->data);
+#endif
+	delete[] this->buffer;
+}
+
+/**
+ * Load the contents of a file into memory. A memory mapping is tried first, if that fails the file is read into a buffer.
+ * @param fname Name of the file to load.
+ * @return Whether the contents of the file are available.
+ * @pre No file has been loaded yet.
+ */
+bool FileContents::Load(const char *fname)
+{
+	assert(this->data == nullptr);
+
+	FILE *fp = fopen(fname, "rb");
+	if (fp == nullptr) return false;
+
+	fseek(fp, 0L, SEEK_END);
+	long size = ftell(fp);
+	fseek(fp, 0L, SEEK_SET);
+	if (size < 0) {
+		fclose(fp);
+		return false;
+	}
+	this->size = size;
+
+	if (this->size > 0) {
+#ifdef LINUX
+		void *address = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+		if (address != MAP_FAILED) {
+			this->data = static_cast<const uint8 *>(address);
+			this->mapped = true;
+		}
+#elif WINDOWS
+		HANDLE mapping = CreateFileMapping((HANDLE)_get_osfhandle(_fileno(fp)), nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping != nullptr) {
+			void *address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			CloseHandle(mapping); // The view keeps the mapping alive.
+			if (address != nullptr) {
+				this->data = static_cast<const uint8 *>(address);
+				this->mapped = true;
+			}
+		}
+#endif
+	}
+
+	if (!this->mapped) {
+		/* No memory mapping, read the file instead. */
+		this->buffer = new uint8[std::max(this->size, (size_t)1)];
+		if (this->size > 0 && fread(this->buffer, this->size, 1, fp) != 1) {
+			delete[] this->buffer;
+			this->buffer = nullptr;
+			fclose(fp);
+			return false;
+		}
+		this->data = this->buffer;
+	}
+	fclose(fp);
+	return true;
+}
+
 /**
  * RCD file reader constructor, loading data from a file.
  * @param fname Name of the file to load.
  */
 RcdFileReader::RcdFileReader(const char *fname)
 {
+	this->data = nullptr;
 	this->file_pos = 0;
 	this->file_size = 0;
 	this->name[4] = '\0';
 
-	this->fp = fopen(fname, "rb");
-	if (this->fp == nullptr) return;
+	std::shared_ptr<FileContents> contents = std::make_shared<FileContents>();
+	if (!contents->Load(fname)) return;
 
-	fseek(this->fp, 0L, SEEK_END);
-	this->file_size = ftell(this->fp);
-	fseek(this->fp, 0L, SEEK_SET);
+	this->contents = contents;
+	this->data = contents->data;
+	this->file_size = contents->size;
+}
+
+/**
+ * RCD file reader constructor, reading data of a file that has already been loaded.
+ * @param contents Contents of the file, may be \c nullptr if the file could not be loaded.
+ */
+RcdFileReader::RcdFileReader(const FileContentsPtr &contents)
+{
+	this->data = nullptr;
+	this->file_pos = 0;
+	this->file_size = 0;
+	this->name[4] = '\0';
+
+	if (contents == nullptr) return;
+
+	this->contents = contents;
+	this->data = contents->data;
+	this->file_size = contents->size;
 }
 
 /** Destructor. */
 RcdFileReader::~RcdFileReader()
 {
-	if (this->fp != nullptr) fclose(fp);
 }
 
 /**
@@ -147,19 +238,17 @@ size_t RcdFileReader::GetRemaining()
 
 /**
  * Read an 8 bits unsigned number.
- * @return Loaded number.
- * @pre File must be open, data must be available.
+ * @return Loaded number, \c 0 if no data is available.
  */
 uint8 RcdFileReader::GetUInt8()
 {
-	this->file_pos++;
-	return fgetc(this->fp);
+	if (this->GetRemaining() < 1) return 0;
+	return this->data[this->file_pos++];
 }
 
 /**
  * Read an 8 bits signed number.
- * @return Loaded number.
- * @pre File must be open, data must be available.
+ * @return Loaded number, \c 0 if no data is available.
  */
 int8 RcdFileReader::GetInt8()
 {
@@ -168,46 +257,50 @@ int8 RcdFileReader::GetInt8()
 
 /**
  * Read an 16 bits unsigned number.
- * @return Loaded number.
- * @pre File must be open, data must be available.
+ * @return Loaded number, \c 0 if not enough data is available.
  */
 uint16 RcdFileReader::GetUInt16()
 {
-	uint16 val = this->GetUInt8();
-	return val | (this->GetUInt8() << 8);
+	if (this->GetRemaining() < 2) {
+		this->file_pos = this->file_size;
+		return 0;
+	}
+	const uint8 *ptr = this->data + this->file_pos;
+	this->file_pos += 2;
+	return ptr[0] | (ptr[1] << 8);
 }
 
 /**
  * Read an 16 bits signed number.
- * @return Loaded number.
- * @pre File must be open, data must be available.
+ * @return Loaded number, \c 0 if not enough data is available.
  */
 int16 RcdFileReader::GetInt16()
 {
-	uint16 val = this->GetUInt8();
-	return val | (this->GetUInt8() << 8);
+	return this->GetUInt16();
 }
 
 /**
  * Read an 32 bits unsigned number.
- * @return Loaded number.
- * @pre File must be open, data must be available.
+ * @return Loaded number, \c 0 if not enough data is available.
  */
 uint32 RcdFileReader::GetUInt32()
 {
-	uint32 val = this->GetUInt16();
-	return val | (this->GetUInt16() << 16);
+	if (this->GetRemaining() < 4) {
+		this->file_pos = this->file_size;
+		return 0;
+	}
+	const uint8 *ptr = this->data + this->file_pos;
+	this->file_pos += 4;
+	return ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | ((uint32)ptr[3] << 24);
 }
 
 /**
  * Read an 32 bits signed number.
- * @return Loaded number.
- * @pre File must be open, data must be available.
+ * @return Loaded number, \c 0 if not enough data is available.
  */
 int32 RcdFileReader::GetInt32()
 {
-	uint32 val = this->GetUInt16();
-	return val | (this->GetUInt16() << 16);
+	return this->GetUInt32();
 }
 
 /**
@@ -218,7 +311,7 @@ int32 RcdFileReader::GetInt32()
  */
 bool RcdFileReader::CheckFileHeader(const char *hdr_name, uint32 version)
 {
-	if (this->fp == nullptr) return false;
+	if (this->data == nullptr) return false;
 	if (this->GetRemaining() < 8) return false;
 
 	char name[5];
@@ -242,6 +335,18 @@ bool RcdFileReader::ReadBlockHeader()
 	return this->file_pos + (size_t)this->size <= this->file_size;
 }
 
+/**
+ * Move to a position in the file.
+ * @param pos Offset of the next byte to read.
+ * @return Whether the position exists in the file.
+ */
+bool RcdFileReader::SetPosition(size_t pos)
+{
+	if (this->data == nullptr || pos > this->file_size) return false;
+	this->file_pos = pos;
+	return true;
+}
+
 /**
  * Skip a number of bytes in the file.
  * @param count Number of bytes to move forward.
@@ -251,7 +356,7 @@ bool RcdFileReader::SkipBytes(uint32 count)
 {
 	this->file_pos += count;
 	if (this->file_pos > this->file_size) this->file_pos = this->file_size;
-	return fseek(this->fp, this->file_pos, SEEK_SET) == 0;
+	return this->data != nullptr;
 }
 
 /**
@@ -262,8 +367,48 @@ bool RcdFileReader::SkipBytes(uint32 count)
  */
 bool RcdFileReader::GetBlob(void *address, size_t length)
 {
+	const uint8 *blob = this->GetBlobAddress(length);
+	if (blob == nullptr) return false;
+	memcpy(address, blob, length);
+	return true;
+}
+
+/**
+ * Get the address of a blob of data in the file, without copying it.
+ * @param length Length of the data.
+ * @return Address of the data, or \c nullptr if not enough data is available.
+ *         The data stays available as long as the reader or a copy of its #GetContents exists.
+ */
+const uint8 *RcdFileReader::GetBlobAddress(size_t length)
+{
+	if (this->GetRemaining() < length) {
+		this->file_pos = this->file_size;
+		return nullptr;
+	}
+	const uint8 *blob = this->data + this->file_pos;
 	this->file_pos += length;
-	return fread(address, length, 1, this->fp) == 1;
+	return blob;
+}
+
+/**
+ * Get the size and the time of the last modification of a file.
+ * @param path Path of the file.
+ * @param size [out] Size of the file in bytes.
+ * @param mtime [out] Time of the last modification of the file, only useful for detecting changes.
+ * @return Whether the file exists.
+ */
+bool GetFileStatus(const char *path, uint64 *size, uint64 *mtime)
+{
+	struct stat st;
+	if (stat(path, &st) != 0) return false;
+
+	*size = st.st_size;
+#ifdef LINUX
+	*mtime = (uint64)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#else
+	*mtime = st.st_mtime;
+#endif
+	return true;
 }
 
 /**
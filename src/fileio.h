@@ -12,6 +12,8 @@
 #ifndef FILEIO_H
 #define FILEIO_H
 
+#include <memory>
+
 /**
  * Base class for reading the contents of a directory.
  * Intended use:
@@ -40,13 +42,36 @@ public:
 	const char dir_sep; ///< Directory separator character.
 };
 
+/**
+ * Read-only contents of an entire file in memory. The file is memory mapped if the operating system allows it, else it is read into a buffer.
+ * @ingroup fileio_group
+ */
+class FileContents {
+public:
+	FileContents();
+	~FileContents();
+
+	bool Load(const char *fname);
+
+	const uint8 *data; ///< Contents of the file, \c nullptr if no file is loaded.
+	size_t size;       ///< Size of the file in bytes.
+
+private:
+	uint8 *buffer; ///< Buffer holding the contents if the file is not memory mapped.
+	bool mapped;   ///< Whether #data is a memory mapping of the file.
+};
+
+typedef std::shared_ptr<const FileContents> FileContentsPtr; ///< Shared contents of a file, released when the last user is gone.
+
 /**
  * Class for reading an RCD file.
+ * Data is read directly from the contents of the file in memory, which can also be referenced after reading it (see #GetBlobAddress).
  * @ingroup fileio_group
  */
 class RcdFileReader {
 public:
 	RcdFileReader(const char *fname);
+	RcdFileReader(const FileContentsPtr &contents);
 	~RcdFileReader();
 
 	bool CheckFileHeader(const char *hdr_name, uint32 version);
@@ -54,6 +79,16 @@ public:
 	bool SkipBytes(uint32 count);
 
 	bool GetBlob(void *address, size_t length);
+	const uint8 *GetBlobAddress(size_t length);
+
+	/**
+	 * Get the contents of the file, to keep data returned by #GetBlobAddress available after the reader is gone.
+	 * @return Contents of the file, \c nullptr if the file could not be loaded.
+	 */
+	inline const FileContentsPtr &GetContents() const
+	{
+		return this->contents;
+	}
 
 	uint8  GetUInt8();
 	uint16 GetUInt16();
@@ -64,18 +99,31 @@ public:
 
 	size_t GetRemaining();
 
+	/**
+	 * Get the position in the file.
+	 * @return Offset of the next byte to read.
+	 */
+	inline size_t GetPosition() const
+	{
+		return this->file_pos;
+	}
+
+	bool SetPosition(size_t pos);
+
 	char name[5];   ///< Name of the last found block (with #ReadBlockHeader).
 	uint32 version; ///< Version number of the last found block (with #ReadBlockHeader).
 	uint32 size;    ///< Data size of the last found block (with #ReadBlockHeader).
 
 private:
-	FILE *fp;         ///< File handle of the opened file.
-	size_t file_pos;  ///< Position in the opened file.
-	size_t file_size; ///< Size of the opened file.
+	FileContentsPtr contents; ///< Contents of the opened file.
+	const uint8 *data;        ///< Data of the opened file, \c nullptr if the file could not be loaded.
+	size_t file_pos;          ///< Position in the opened file.
+	size_t file_size;         ///< Size of the opened file.
 };
 
 bool PathIsFile(const char *path);
 bool PathIsDirectory(const char *path);
+bool GetFileStatus(const char *path, uint64 *size, uint64 *mtime);
 
 DirectoryReader *MakeDirectoryReader();
 
@@ -206,7 +206,7 @@ void FinancesManager::Load(Loader &ldr)
 		this->current = ldr.GetByte();
 		this->cash = ldr.GetLongLong();
 		for (int i = 0; i < this->num_used; i++) this->finances[i].Load(ldr, version);
-	} else {
+	} else if (!ldr.SkipBlock()) {
 		ldr.SetFailMessage("Unknown block in finances manager.");
 	}
 	ldr.CloseBlock();
@@ -22,6 +22,11 @@
 #include "getoptdata.h"
 #include "fileio.h"
 #include "gamecontrol.h"
+#include "worker_pool.h"
+#include "profiler.h"
+#include "park_render.h"
+#include "loadsave.h"
+#include "map.h"
 
 void InitMouseModes();
 
@@ -44,6 +49,18 @@ void error(const char *str, ...)
 /** Command-line options of the program. */
 static const OptionData _options[] = {
 	GETOPT_NOVAL('h', "--help"),
+	GETOPT_VALUE('s', "--speed"),
+	GETOPT_VALUE('l', "--load"),
+	GETOPT_VALUE('r', "--render"),
+	GETOPT_VALUE('o', "--orientation"),
+	GETOPT_VALUE('z', "--zoom"),
+	GETOPT_VALUE('b', "--benchmark"),
+	GETOPT_VALUE('S', "--save-benchmark"),
+	GETOPT_VALUE('T', "--text-benchmark"),
+	GETOPT_NOVAL('c', "--check-bands"),
+#ifdef ENABLE_PROFILER
+	GETOPT_VALUE('t', "--trace"),
+#endif
 	GETOPT_END()
 };
 
@@ -52,7 +69,21 @@ static void PrintUsage()
 {
 	printf("Usage: freerct [options]\n");
 	printf("Options:\n");
-	printf("  -h, --help     Display this help text and exit\n");
+	printf("  -h, --help             Display this help text and exit\n");
+	printf("  -s, --speed SPEED      Start the game at the given speed (1, 2, 4, 16, or max)\n");
+	printf("  -l, --load FILE        Load the saved game FILE at the start\n");
+	printf("  -r, --render FILE      Render the entire park to the PNG file FILE without opening a window, and exit\n");
+	printf("  -o, --orientation DIR  View direction of rendering (north, east, south, west, or all; default north)\n");
+	printf("  -z, --zoom WIDTH       Tile width in pixels of rendering (64, 32, or 16; default 64)\n");
+	printf("  -b, --benchmark COUNT  Render the park COUNT times without opening a window, print the speed, and exit\n");
+	printf("  -S, --save-benchmark COUNT\n");
+	printf("                         Save and load the park (without -l, the largest flat world) COUNT times, print the speed, and exit\n");
+	printf("  -c, --check-bands      Check that drawing the park in bands gives the same pixels as drawing it in one thread without the sprite cache, and exit\n");
+	printf("  -T, --text-benchmark COUNT\n");
+	printf("                         Format COUNT times strings with numbers, money, and dates, print the speed, and exit\n");
+#ifdef ENABLE_PROFILER
+	printf("  -t, --trace FILE       Write the profiled parts of the frames to FILE (in Chrome trace format)\n");
+#endif
 }
 
 /** Show that there are missing sprites. */
@@ -72,6 +103,14 @@ void ShowGraphicsErrorMessage()
 int freerct_main(int argc, char **argv)
 {
 	GetOptData opt_data(argc - 1, argv + 1, _options);
+	const char *load_file = nullptr;
+	const char *render_file = nullptr;
+	ViewOrientation render_orient = VOR_NORTH;
+	int render_width = 64;
+	int benchmark_count = 0;
+	int save_benchmark_count = 0;
+	int text_benchmark_count = 0;
+	bool check_bands = false;
 
 	int opt_id;
 	do {
@@ -81,6 +120,76 @@ int freerct_main(int argc, char **argv)
 				PrintUsage();
 				return 0;
 
+			case 's': {
+				GameSpeed speed;
+				if (opt_data.opt == nullptr || !GetGameSpeedFromText(opt_data.opt, &speed)) {
+					fprintf(stderr, "ERROR: Unknown game speed (use 1, 2, 4, 16, or max)\n");
+					return 1;
+				}
+				_game_clock.SetSpeed(speed);
+				break;
+			}
+
+			case 'l':
+				load_file = opt_data.opt;
+				break;
+
+			case 'r':
+				render_file = opt_data.opt;
+				break;
+
+			case 'o':
+				if (opt_data.opt == nullptr || !GetRenderOrientationFromText(opt_data.opt, &render_orient)) {
+					fprintf(stderr, "ERROR: Unknown orientation (use north, east, south, west, or all)\n");
+					return 1;
+				}
+				break;
+
+			case 'z':
+				render_width = (opt_data.opt == nullptr) ? 0 : atoi(opt_data.opt);
+				if (render_width != 16 && render_width != 32 && render_width != 64) {
+					fprintf(stderr, "ERROR: Unknown zoom (use 64, 32, or 16)\n");
+					return 1;
+				}
+				break;
+
+			case 'b':
+				benchmark_count = (opt_data.opt == nullptr) ? 0 : atoi(opt_data.opt);
+				if (benchmark_count <= 0) {
+					fprintf(stderr, "ERROR: The benchmark needs a positive number of renderings\n");
+					return 1;
+				}
+				break;
+
+			case 'S':
+				save_benchmark_count = (opt_data.opt == nullptr) ? 0 : atoi(opt_data.opt);
+				if (save_benchmark_count <= 0) {
+					fprintf(stderr, "ERROR: The save benchmark needs a positive number of savings\n");
+					return 1;
+				}
+				break;
+
+			case 'c':
+				check_bands = true;
+				break;
+
+			case 'T':
+				text_benchmark_count = (opt_data.opt == nullptr) ? 0 : atoi(opt_data.opt);
+				if (text_benchmark_count <= 0) {
+					fprintf(stderr, "ERROR: The text benchmark needs a positive number of formattings\n");
+					return 1;
+				}
+				break;
+
+#ifdef ENABLE_PROFILER
+			case 't':
+				if (opt_data.opt == nullptr || !_profiler.StartTrace(opt_data.opt)) {
+					fprintf(stderr, "ERROR: Cannot open the trace file\n");
+					return 1;
+				}
+				break;
+#endif
+
 			case -1:
 				break;
 
@@ -95,8 +204,10 @@ int freerct_main(int argc, char **argv)
 
 	ChangeWorkingDirectoryToExecutable(argv[0]);
 
+	cfg_file.Load("freerct.cfg");
+	_worker_pool.SetThreadCount(std::max(cfg_file.GetNum("video", "draw-threads"), 0));
+
 	/* Load RCD files. */
-	InitImageStorage();
 	_rcd_collection.ScanDirectories();
 	_sprite_manager.LoadRcdFiles();
 
@@ -107,7 +218,45 @@ int freerct_main(int argc, char **argv)
 		return 1;
 	}
 
-	cfg_file.Load("freerct.cfg");
+	if (text_benchmark_count > 0) {
+		int exit_code = RunTextBenchmark(text_benchmark_count);
+		UninitLanguage();
+		return exit_code;
+	}
+
+	int cache_size = cfg_file.GetNum("video", "sprite-cache-size"); // In KiB.
+	if (cache_size >= 0) _video.sprite_cache.SetBudget((size_t)cache_size * 1024);
+	int zoomed_size = cfg_file.GetNum("video", "zoomed-sprite-memory"); // In KiB.
+	if (zoomed_size >= 0) SetDownsampledImagesBudget((size_t)zoomed_size * 1024);
+	if (cfg_file.GetNum("savegame", "compress") == 0) _compress_savegames = false;
+	_autosave_interval = std::max(cfg_file.GetNum("savegame", "autosave-months"), 0);
+
+	if (render_file != nullptr || benchmark_count > 0 || save_benchmark_count > 0 || check_bands) {
+		/* Draw or save the park off-screen, no window or font is needed. */
+		InitNewGame();
+		int exit_code = 0;
+		if (load_file != nullptr && !LoadGame(load_file)) {
+			fprintf(stderr, "ERROR: Cannot load the saved game \"%s\"\n", load_file);
+			exit_code = 1;
+		}
+		if (exit_code == 0 && save_benchmark_count > 0) {
+			if (load_file == nullptr) {
+				/* Measure with the largest world that can be saved and loaded. */
+				_world.SetWorldSize(WORLD_X_SIZE - 1, WORLD_Y_SIZE - 1);
+				_world.MakeFlatWorld(8);
+			}
+			exit_code = RunSaveBenchmark(save_benchmark_count);
+		}
+		if (exit_code == 0 && (render_file != nullptr || benchmark_count > 0)) {
+			exit_code = RunParkRenderer(render_file, render_orient, render_width, benchmark_count);
+		}
+		if (exit_code == 0 && check_bands) exit_code = RunBandCheck(render_orient, render_width);
+
+		UninitLanguage();
+		DestroyImageStorage();
+		return exit_code;
+	}
+
 	const char *font_path = cfg_file.GetValue("font", "medium-path");
 	int font_size = cfg_file.GetNum("font", "medium-size");
 	if (font_path == nullptr || *font_path == '\0' || font_size == -1) {
@@ -120,20 +269,28 @@ int freerct_main(int argc, char **argv)
 	}
 
 	/* Initialize video. */
+	_video.direct_texture = cfg_file.GetNum("video", "direct-texture") > 0; // The texture memory is read back while drawing, see VideoSystem::StartRepaint.
 	std::string err = _video.Initialize(font_path, font_size);
 	if (!err.empty()) {
 		fprintf(stderr, "Failed to initialize window or the font (%s), aborting\n", err.c_str());
 		return 1;
 	}
 
+	_video.interpolate = cfg_file.GetNum("video", "interpolate") != 0;
+	_video.show_rates = cfg_file.GetNum("video", "show-rates") > 0;
+
 	InitMouseModes();
 
 	StartNewGame();
+	if (load_file != nullptr && !LoadGame(load_file)) fprintf(stderr, "Loading the saved game \"%s\" failed, starting a new game\n", load_file);
 
 	/* Loops until told not to. */
 	_video.MainLoop();
 
 	/* Closing down. */
+#ifdef ENABLE_PROFILER
+	_profiler.StopTrace();
+#endif
 	ShutdownGame();
 	UninitLanguage();
 	DestroyImageStorage();
@@ -22,9 +22,13 @@
 #include "viewport.h"
 #include "weather.h"
 #include "freerct.h"
+#include "profiler.h"
+#include <chrono>
 
-/** Initialize all game data structures for playing a new game. */
-void StartNewGame()
+GameClock _game_clock; ///< Clock of the game.
+
+/** Initialize all game data structures for a new game, without opening any window. */
+void InitNewGame()
 {
 	/// \todo We blindly assume game data structures are all clean.
 	_world.SetWorldSize(20, 21);
@@ -39,6 +43,12 @@ void StartNewGame()
 	_weather.Initialize();
 
 	_game_mode_mgr.SetGameMode(GM_PLAY);
+}
+
+/** Initialize all game data structures for playing a new game, and open the main windows. */
+void StartNewGame()
+{
+	InitNewGame();
 
 	XYZPoint32 view_pos(_world.GetXSize() * 256 / 2, _world.GetYSize() * 256 / 2, 8 * 256);
 	ShowMainDisplay(view_pos);
@@ -51,6 +61,7 @@ void ShutdownGame()
 {
 	/// \todo Clean out the game data structures.
 
+	FinishBackgroundSave(true);
 	_game_mode_mgr.SetGameMode(GM_NONE);
 	_mouse_modes.SetMouseMode(MM_INACTIVE);
 	_window_manager.CloseAllWindows();
@@ -67,6 +78,7 @@ void OnNewMonth()
 {
 	_finances_manager.AdvanceMonth();
 	_rides_manager.OnNewMonth();
+	AutosaveOnNewMonth();
 }
 
 /** Runs various procedures that have to be done daily. */
@@ -84,9 +96,148 @@ void OnNewDay()
 */
 void OnNewFrame(uint32 frame_delay)
 {
+	PROFILE_SCOPE(PFS_NEW_FRAME);
 	_window_manager.Tick();
 	_guests.DoTick();
 	DateOnTick();
 	_guests.OnAnimate(frame_delay);
 	_rides_manager.OnAnimate(frame_delay);
+	FinishBackgroundSave(false);
+}
+
+/** Speed factors and names of the game speeds. */
+static const struct {
+	uint32 factor;    ///< Game time per unit of real time, \c 0 means as fast as possible.
+	const char *name; ///< Name of the speed.
+} _game_speeds[GSP_COUNT] = {
+	{ 1, "1"},
+	{ 2, "2"},
+	{ 4, "4"},
+	{16, "16"},
+	{ 0, "max"},
+};
+
+/**
+ * Get the amount of game time that passes in a unit of real time at the given game speed.
+ * @param speed Game speed to examine.
+ * @return Game speed factor, \c 0 means as fast as possible.
+ */
+uint32 GetGameSpeedFactor(GameSpeed speed)
+{
+	assert(speed < GSP_COUNT);
+	return _game_speeds[speed].factor;
+}
+
+/**
+ * Find the game speed with a given name.
+ * @param text Name of the game speed (\c "1", \c "2", \c "4", \c "16", or \c "max").
+ * @param speed [out] Game speed with the given name.
+ * @return Whether the name is a known game speed.
+ */
+bool GetGameSpeedFromText(const char *text, GameSpeed *speed)
+{
+	for (int i = 0; i < GSP_COUNT; i++) {
+		if (strcmp(text, _game_speeds[i].name) == 0) {
+			*speed = (GameSpeed)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Get the name of a game speed.
+ * @param speed Game speed to name.
+ * @return Name of the game speed.
+ */
+const char *GetGameSpeedText(GameSpeed speed)
+{
+	assert(speed < GSP_COUNT);
+	return _game_speeds[speed].name;
+}
+
+GameClock::GameClock()
+{
+	this->speed = GSP_1X;
+	this->tick_count = 0;
+	this->Reset();
+}
+
+/**
+ * Change the speed of the game.
+ * @param speed New speed of the game.
+ */
+void GameClock::SetSpeed(GameSpeed speed)
+{
+	assert(speed < GSP_COUNT);
+	this->speed = speed;
+	this->accumulated = 0;
+}
+
+/** Start counting time from scratch, for example after a long pause in running the game. */
+void GameClock::Reset()
+{
+	this->accumulated = 0;
+	this->tick_rate = 0;
+	this->frame_rate = 0;
+	this->measure_time = 0;
+	this->measure_ticks = 0;
+	this->measure_frames = 0;
+}
+
+/**
+ * Execute a single simulation tick.
+ * @note Nothing is drawn, that is done once after all ticks of a frame.
+ */
+void GameClock::RunTick()
+{
+	OnNewFrame(TICK_LENGTH);
+	this->tick_count++;
+}
+
+/**
+ * Real time has passed, run the simulation ticks that fit in it.
+ * The real time is scaled by the game speed. At most #MAX_CATCH_UP_TICKS ticks are executed for each unit of game speed,
+ * if more time has passed, it is dropped. At #GSP_MAX speed, ticks are executed for #MAX_SPEED_FRAME_TIME milliseconds.
+ * @param real_time Number of milliseconds of real time since the previous call.
+ * @return Number of executed ticks.
+ */
+uint32 GameClock::Advance(uint32 real_time)
+{
+	uint32 factor = GetGameSpeedFactor(this->speed);
+	uint32 ticks = 0;
+	if (factor == 0) {
+		typedef std::chrono::steady_clock Clock;
+		Clock::time_point end = Clock::now() + std::chrono::milliseconds(MAX_SPEED_FRAME_TIME);
+		do {
+			this->RunTick();
+			ticks++;
+		} while (Clock::now() < end);
+		this->accumulated = 0;
+	} else {
+		this->accumulated += real_time * factor;
+		while (this->accumulated >= TICK_LENGTH && ticks < MAX_CATCH_UP_TICKS * factor) {
+			this->RunTick();
+			this->accumulated -= TICK_LENGTH;
+			ticks++;
+		}
+		if (this->accumulated >= TICK_LENGTH) this->accumulated %= TICK_LENGTH; // Too slow to catch up.
+	}
+
+	this->measure_ticks += ticks;
+	this->measure_time += real_time;
+	if (this->measure_time >= 1000) {
+		this->tick_rate = (this->measure_ticks * 1000 + this->measure_time / 2) / this->measure_time;
+		this->frame_rate = (this->measure_frames * 1000 + this->measure_time / 2) / this->measure_time;
+		this->measure_time = 0;
+		this->measure_ticks = 0;
+		this->measure_frames = 0;
+	}
+	return ticks;
+}
+
+/** A frame has been drawn at the display. */
+void GameClock::OnFrameDrawn()
+{
+	this->measure_frames++;
 }
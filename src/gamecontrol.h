@@ -12,6 +12,7 @@
 #ifndef GAMECONTROL_H
 #define GAMECONTROL_H
 
+void InitNewGame();
 void StartNewGame();
 void ShutdownGame();
 
@@ -20,5 +21,93 @@ void OnNewMonth();
 void OnNewYear();
 void OnNewFrame(uint32 frame_delay);
 
+static const uint32 TICK_LENGTH = 30;       ///< Number of milliseconds of game time simulated in a single tick.
+static const uint32 MAX_CATCH_UP_TICKS = 4; ///< Maximal number of ticks to run before drawing a frame (at normal speed), a slower machine makes the game slower.
+static const uint32 MAX_SPEED_FRAME_TIME = 40; ///< Number of milliseconds of real time to spend on running ticks before drawing a frame at #GSP_MAX speed.
+
+/** Speed of the game. */
+enum GameSpeed {
+	GSP_1X,  ///< Real time.
+	GSP_2X,  ///< Twice as fast as real time.
+	GSP_4X,  ///< Four times as fast as real time.
+	GSP_16X, ///< Sixteen times as fast as real time.
+	GSP_MAX, ///< As fast as the machine can run the simulation.
+
+	GSP_COUNT, ///< Number of game speeds.
+};
+
+uint32 GetGameSpeedFactor(GameSpeed speed);
+bool GetGameSpeedFromText(const char *text, GameSpeed *speed);
+const char *GetGameSpeedText(GameSpeed speed);
+
+/**
+ * Clock of the game. The simulation runs in ticks of fixed length (#TICK_LENGTH), independent of how often the display is drawn.
+ * Real time is accumulated, and as many ticks as fit in it are executed. The remainder of the time is used to
+ * interpolate the positions of moving objects while drawing.
+ */
+class GameClock {
+public:
+	GameClock();
+
+	void Reset();
+	uint32 Advance(uint32 real_time);
+	void OnFrameDrawn();
+
+	void SetSpeed(GameSpeed speed);
+
+	/**
+	 * Get the speed of the game.
+	 * @return The current speed of the game.
+	 */
+	inline GameSpeed GetSpeed() const
+	{
+		return this->speed;
+	}
+
+	/**
+	 * Get the amount of game time since the last tick.
+	 * @return Number of milliseconds of game time since the last tick (less than #TICK_LENGTH, \c 0 at #GSP_MAX speed).
+	 */
+	inline uint32 GetTickProgress() const
+	{
+		return this->accumulated;
+	}
+
+	/**
+	 * Get the amount of real time until the next tick should be executed.
+	 * @return Number of milliseconds of real time until the next tick.
+	 */
+	inline uint32 GetTimeToNextTick() const
+	{
+		uint32 factor = GetGameSpeedFactor(this->speed);
+		if (factor == 0) return 0;
+		return (TICK_LENGTH - std::min(this->accumulated, TICK_LENGTH) + factor - 1) / factor;
+	}
+
+	/**
+	 * Get the number of executed ticks.
+	 * @return Number of ticks executed since the start of the program (wraps around).
+	 */
+	inline uint32 GetTickCount() const
+	{
+		return this->tick_count;
+	}
+
+	uint32 tick_rate;  ///< Number of ticks per second, measured over the last second.
+	uint32 frame_rate; ///< Number of drawn frames per second, measured over the last second.
+
+private:
+	GameSpeed speed;        ///< Speed of the game.
+	uint32 accumulated;     ///< Amount of game time (in milliseconds) not simulated yet.
+	uint32 tick_count;      ///< Number of executed ticks.
+	uint32 measure_time;    ///< Amount of real time (in milliseconds) in the current measurement of the rates.
+	uint32 measure_ticks;   ///< Number of ticks in the current measurement of the rates.
+	uint32 measure_frames;  ///< Number of drawn frames in the current measurement of the rates.
+
+	void RunTick();
+};
+
+extern GameClock _game_clock;
+
 #endif
 
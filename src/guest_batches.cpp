@@ -165,3 +165,55 @@ void OnRideGuests::OnAnimate(int delay)
 		this->batches.at(start).OnAnimate(delay);
 	}
 }
+
+/**
+ * Load the guests in the ride from the save game.
+ * @param ldr Input stream to load from.
+ * @note The batches should have been configured already, the saved configuration must match.
+ */
+void OnRideGuests::Load(Loader &ldr)
+{
+	int num_batches = ldr.GetWord();
+	int batch_size = ldr.GetWord();
+	if (num_batches != this->num_batches || batch_size != this->batch_size) {
+		ldr.SetFailMessage("Incorrect batches of the ride");
+		return;
+	}
+
+	for (GuestBatch &gb : this->batches) {
+		uint8 state = ldr.GetByte();
+		gb.state = (state <= BST_UNLOADING) ? (BatchState)state : BST_EMPTY;
+		gb.remaining = ldr.GetLong();
+		gb.gate = ldr.GetLong();
+		for (GuestData &gd : gb.guests) {
+			gd.Clear();
+			int guest = ldr.GetWord();
+			uint8 entry = ldr.GetByte();
+			if (entry < EDGE_COUNT) {
+				gd.Set(guest, (TileEdge)entry);
+			} else if (entry != INVALID_EDGE) {
+				ldr.SetFailMessage("Incorrect guest entry of the ride");
+			}
+		}
+		if (state > BST_UNLOADING) ldr.SetFailMessage("Incorrect batch state of the ride");
+	}
+}
+
+/**
+ * Save the guests in the ride to the save game.
+ * @param svr Output stream to save to.
+ */
+void OnRideGuests::Save(Saver &svr) const
+{
+	svr.PutWord(this->num_batches);
+	svr.PutWord(this->batch_size);
+	for (const GuestBatch &gb : this->batches) {
+		svr.PutByte(gb.state);
+		svr.PutLong(gb.remaining);
+		svr.PutLong(gb.gate);
+		for (const GuestData &gd : gb.guests) {
+			svr.PutWord(gd.IsEmpty() ? 0 : gd.guest);
+			svr.PutByte(gd.entry);
+		}
+	}
+}
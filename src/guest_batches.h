@@ -126,6 +126,9 @@ public:
 
 	void OnAnimate(int delay);
 
+	void Load(Loader &ldr);
+	void Save(Saver &svr) const;
+
 	std::vector<GuestBatch> batches; ///< Batches of guests.
 	int batch_size;  ///< Size of a batch of guests.
 	int num_batches; ///< Number of batches in the ride.
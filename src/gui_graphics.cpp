@@ -15,6 +15,10 @@
 #include "sprite_data.h"
 #include "math_func.h"
 #include "video.h"
+#include "language.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
 
 /**
  * Draw the same sprite repeatedly over a (potentially) large area. The function recognizes a single-pixel
@@ -210,34 +214,117 @@ static uint8 *GetSingleLine(uint8 *text, int max_width, int *width)
 	}
 }
 
+/** Lines of a text after breaking it at a maximal width. */
+struct TextLayout {
+	std::vector<std::string> lines; ///< Lines of the text, without line break characters.
+	int width;                      ///< Width of the widest line, may be larger than the maximal width in case of long words.
+};
+
+/** Key of a #TextLayout in the #TextLayoutCache. */
+struct TextLayoutKey {
+	std::string text; ///< Text before breaking it into lines.
+	int max_width;    ///< Longest allowed length of a line.
+
+	/**
+	 * Compare two keys for equality.
+	 * @param other Key to compare with.
+	 * @return Both keys denote the same layout.
+	 */
+	inline bool operator==(const TextLayoutKey &other) const
+	{
+		return this->max_width == other.max_width && this->text == other.text;
+	}
+};
+
+/** Hash function of a #TextLayoutKey. */
+struct TextLayoutKeyHash {
+	/**
+	 * Compute the hash of a key.
+	 * @param key Key to hash.
+	 * @return Hash value of the key.
+	 */
+	inline size_t operator()(const TextLayoutKey &key) const
+	{
+		return std::hash<std::string>()(key.text) * 31 + key.max_width;
+	}
+};
+
+static const size_t MAX_CACHED_LAYOUTS = 256; ///< Maximal number of text layouts in the #TextLayoutCache.
+
 /**
- * Get the size of a text when printed in multi-line format.
- * @param strid Text to 'print'.
+ * Cache of line breaks of multi-line texts, shared between computing the size of a text and drawing it.
+ * The cache is dropped when the language or the font changes.
+ */
+class TextLayoutCache {
+public:
+	TextLayoutCache() : language(-1), font(nullptr)
+	{
+	}
+
+	const TextLayout &GetLayout(StringID strid, int max_width);
+
+private:
+	typedef std::unordered_map<TextLayoutKey, TextLayout, TextLayoutKeyHash> LayoutMap; ///< Layouts by their key.
+
+	LayoutMap layouts;    ///< Layouts computed so far.
+	int language;         ///< Language of the cached layouts.
+	const TTF_Font *font; ///< Font of the cached layouts.
+};
+
+static TextLayoutCache _text_layouts; ///< Line breaks of the multi-line texts.
+
+/**
+ * Get the lines of a string when printed in multi-line format.
+ * @param strid String to break into lines.
  * @param max_width Longest allowed length of a line.
- * @param width [out]  Actual width of the text.
- * @param height [out] Actual height of the text.
- * @note After the call, NL characters have been inserted at line break points.
- * @note Actual width (returned in \c *width) may be larger than \a max_width in case of long words.
+ * @return Layout of the string, valid until the next call.
  */
-void GetMultilineTextSize(StringID strid, int max_width, int *width, int *height)
+const TextLayout &TextLayoutCache::GetLayout(StringID strid, int max_width)
 {
+	if (this->language != _current_language || this->font != _video.text_cache.GetFont()) {
+		this->layouts.clear();
+		this->language = _current_language;
+		this->font = _video.text_cache.GetFont();
+	}
+
 	uint8 buffer[1024]; // Arbitrary max size.
 	DrawText(strid, buffer, lengthof(buffer));
 
-	*width = 0;
-	*height = 0;
+	TextLayoutKey key = {std::string((const char *)buffer), max_width};
+	auto iter = this->layouts.find(key);
+	if (iter != this->layouts.end()) return iter->second;
+
+	if (this->layouts.size() >= MAX_CACHED_LAYOUTS) this->layouts.clear();
+	TextLayout &layout = this->layouts[key];
+	layout.width = 0;
 
 	uint8 *text = buffer;
 	for (;;) {
 		int line_width;
-		text = GetSingleLine(text, max_width, &line_width);
-		*width = std::max(*width, line_width);
-		*height += _video.GetTextHeight();
+		uint8 *end = GetSingleLine(text, max_width, &line_width);
+		layout.width = std::max(layout.width, line_width);
+		layout.lines.emplace_back((const char *)text, end - text);
 
-		if (*text == '\0') break;
-		assert(*text == '\n');
-		text++;
+		if (*end == '\0') break;
+		assert(*end == '\n');
+		text = end + 1;
 	}
+	return layout;
+}
+
+/**
+ * Get the size of a text when printed in multi-line format.
+ * @param strid Text to 'print'.
+ * @param max_width Longest allowed length of a line.
+ * @param width [out]  Actual width of the text.
+ * @param height [out] Actual height of the text.
+ * @note Actual width (returned in \c *width) may be larger than \a max_width in case of long words.
+ */
+void GetMultilineTextSize(StringID strid, int max_width, int *width, int *height)
+{
+	const TextLayout &layout = _text_layouts.GetLayout(strid, max_width);
+	*width = layout.width;
+	*height = layout.lines.size() * _video.GetTextHeight();
 }
 
 /**
@@ -252,24 +339,16 @@ void GetMultilineTextSize(StringID strid, int max_width, int *width, int *height
  */
 bool DrawMultilineString(StringID strid, int x, int y, int max_width, int max_height, uint8 colour)
 {
-	uint8 buffer[1024]; // Arbitrary max size.
-	DrawText(strid, buffer, lengthof(buffer));
+	const TextLayout &layout = _text_layouts.GetLayout(strid, max_width);
+	for (size_t i = 0; i < layout.lines.size(); i++) {
+		/* An empty last line is only counted in the size, there is nothing to draw. */
+		if (i + 1 == layout.lines.size() && layout.lines[i].empty()) break;
 
-	uint8 *text = buffer;
-	while (*text != '\0') {
 		if (max_height < _video.GetTextHeight()) return false;
 		max_height -= _video.GetTextHeight();
 
-		int line_width;
-		uint8 *end = GetSingleLine(text, max_width, &line_width);
-		if (*end == '\0') {
-			_video.BlitText(text, _palette[colour], x, y, max_width);
-			break;
-		}
-		*end = '\0';
-		_video.BlitText(text, _palette[colour], x, y, max_width);
+		_video.BlitText((const uint8 *)layout.lines[i].c_str(), _palette[colour], x, y, max_width);
 		y += _video.GetTextHeight();
-		text = end + 1;
 	}
 	return true;
 }
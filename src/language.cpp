@@ -14,10 +14,10 @@
 #include "fileio.h"
 #include "sprite_store.h"
 #include "video.h"
-#include "string_func.h"
 #include "math_func.h"
 #include "dates.h"
 #include "money.h"
+#include <chrono>
 
 assert_compile((int)GUI_STRING_TABLE_END < STR_END_FREE_SPACE); ///< Ensure there are not too many GUI strings.
 assert_compile((int)SHOPS_STRING_TABLE_END < STR_GENERIC_END);  ///< Ensure there are not too many shops strings.
@@ -189,8 +189,51 @@ void StringParameters::Clear()
 	this->set_mode = true;
 }
 
+/**
+ * Parse the "%n%" patterns of a text, and store the text as a sequence of literal text and parameters.
+ * @param text Text to compile, \c nullptr is treated as empty text.
+ */
+void StringTemplate::Compile(const uint8 *text)
+{
+	if (text == nullptr) text = (const uint8 *)"";
+	this->text = text;
+	this->parts.clear();
+
+	const uint8 *ptr = text;
+	for (;;) {
+		const uint8 *start = ptr;
+		while (*ptr != '\0' && *ptr != '%') ptr++;
+		if (ptr > start) this->parts.push_back({(uint16)(start - text), (uint16)(ptr - start), 0});
+		if (*ptr == '\0') break;
+		ptr++;
+		if (*ptr == '%') {
+			this->parts.push_back({(uint16)(ptr - text), 1, 0});
+			ptr++;
+			continue;
+		}
+		int n = 0;
+		while (*ptr >= '0' && *ptr <= '9') {
+			n = n * 10 + *ptr - '0';
+			ptr++;
+		}
+		if (n >= 1 && n <= (int)lengthof(_str_params.parms)) this->parts.push_back({0, 0, (uint8)n});
+		while (*ptr != '\0' && *ptr != '%') ptr++; // Skip to the next '%'
+		if (*ptr == '\0') break;
+		ptr++;
+	}
+	this->parts.shrink_to_fit();
+}
+
+/** Texts of the strings that exist without loading them. */
+static const uint8 *_default_strings[] = {
+	nullptr,              // STR_NULL
+	(const uint8 *)"",    // STR_EMPTY
+	(const uint8 *)"%1%", // STR_ARG1
+};
+
 Language::Language()
 {
+	this->invalid_template.Compile((const uint8 *)"<Invalid string>");
 	this->Clear();
 }
 
@@ -199,6 +242,18 @@ void Language::Clear()
 {
 	std::fill_n(this->registered, lengthof(this->registered), nullptr);
 	this->first_free = GUI_STRING_TABLE_END;
+
+	for (uint number = 0; number < lengthof(this->templates); number++) {
+		for (int lang = 0; lang < LANGUAGE_COUNT; lang++) {
+			StringTemplate &tmpl = this->templates[number][lang];
+			if (number < lengthof(_default_strings)) {
+				tmpl.Compile(_default_strings[number]);
+			} else {
+				tmpl.text = nullptr;
+				tmpl.parts.clear();
+			}
+		}
+	}
 }
 
 /**
@@ -243,6 +298,16 @@ uint16 Language::RegisterStrings(const TextData &td, const char * const names[],
 				break;
 			}
 		}
+		for (int lang = 0; lang < LANGUAGE_COUNT; lang++) {
+			StringTemplate &tmpl = this->templates[number][lang];
+			if (this->registered[number] == nullptr) {
+				tmpl.text = nullptr;
+				tmpl.parts.clear();
+				continue;
+			}
+			const uint8 *text = this->registered[number]->GetString(lang);
+			tmpl.Compile((*text == '\0') ? (const uint8 *)"<empty text>" : text);
+		}
 		number++;
 		str++;
 	}
@@ -256,13 +321,7 @@ uint16 Language::RegisterStrings(const TextData &td, const char * const names[],
  */
 const uint8 *Language::GetText(StringID number)
 {
-	static const uint8 *default_strings[] = {
-		nullptr,              // STR_NULL
-		(const uint8 *)"",    // STR_EMPTY
-		(const uint8 *)"%1%", // STR_ARG1
-	};
-
-	if (number < lengthof(default_strings)) return default_strings[number];
+	if (number < lengthof(_default_strings)) return _default_strings[number];
 
 	if (number < lengthof(this->registered) && this->registered[number] != nullptr) {
 		const uint8 *text = this->registered[number]->GetString();
@@ -273,6 +332,19 @@ const uint8 *Language::GetText(StringID number)
 	return (const uint8 *)"<Invalid string>";
 }
 
+/**
+ * Get the compiled text of string number \a number in the current language.
+ * @param number String number to get.
+ * @return Compiled text of the string (not owned by the caller).
+ */
+const StringTemplate *Language::GetTemplate(StringID number) const
+{
+	if (number >= lengthof(this->templates) || _current_language < 0 || _current_language >= LANGUAGE_COUNT) return &this->invalid_template;
+
+	const StringTemplate *tmpl = &this->templates[number][_current_language];
+	return (tmpl->text != nullptr) ? tmpl : &this->invalid_template;
+}
+
 /**
  * Get the (native) name of a language.
  * @param lang_index The language to look in.
@@ -303,85 +375,93 @@ static uint8 *CopyString(uint8 *dest, const uint8 *last, const uint8 *src)
 }
 
 /**
- * Converts a double value into a utf-8 string with the appropriate separators.
- * @param dest [out] A provided buffer to write the output into.
- * @param size The size of the provided buffer.
- * @param amt The double value to be converted.
+ * Copy the decimal notation of a number to the destination, as far as it fits. Does not allocate memory.
+ * @param dest [out] Destination address.
+ * @param last Last byte of the destination (not written).
+ * @param number Number to copy.
+ * @param min_digits Minimal number of digits, shorter numbers get leading zeroes.
+ * @return Updated destination.
  */
-static void MoneyStrFmt(uint8 *dest, size_t size, double amt)
+static uint8 *CopyNumber(uint8 *dest, const uint8 *last, int64 number, int min_digits = 1)
 {
-	const uint8 *curr_sym = _language.GetText(GUI_MONEY_CURRENCY_SYMBOL);
-	size_t curr_sym_len = StrBytesLength(curr_sym);
+	uint8 digits[20]; // Enough for any 64 bit number.
+	uint64 value = (number < 0) ? -(uint64)number : number;
+	int count = 0;
+	do {
+		digits[count++] = '0' + value % 10;
+		value /= 10;
+	} while (value > 0);
+	while (count < min_digits && count < (int)lengthof(digits)) digits[count++] = '0';
+
+	if (number < 0 && dest < last) *dest++ = '-';
+	while (count > 0 && dest < last) *dest++ = digits[--count];
+	return dest;
+}
 
+/**
+ * Copy an amount of money to the destination with the currency symbol and the separators of the current language, as far as it fits.
+ * @param dest [out] Destination address.
+ * @param last Last byte of the destination (not written).
+ * @param amount Amount of money in cents.
+ * @return Updated destination.
+ */
+static uint8 *CopyMoney(uint8 *dest, const uint8 *last, int64 amount)
+{
+	const uint8 *curr_sym = _language.GetText(GUI_MONEY_CURRENCY_SYMBOL);
 	const uint8 *tho_sep  = _language.GetText(GUI_MONEY_THOUSANDS_SEPARATOR);
-	size_t tho_sep_len  = StrBytesLength(tho_sep);
-
 	const uint8 *dec_sep  = _language.GetText(GUI_MONEY_DECIMAL_SEPARATOR);
-	size_t dec_sep_len  = StrBytesLength(dec_sep);
-
-	char *buf = new char[size];
-
-	/* Convert double into a numeric string (with '.' as the decimal separator). */
-	uint len = snprintf(buf, size, "%.2f", amt);
-
-	/* Compute the offset of where we should begin counting for thousand separators. */
-	uint comma_start = (len - 3) % 3;
-
-	/* What is the max number of characters we might append in a single loop?
-	 * This is used to prevent a potential buffer overflow. */
-	/* max_append_size = 'a "special" symbol plus a single digit [0-9]'. */
-	int max_append_size = std::max(std::max(curr_sym_len, tho_sep_len), dec_sep_len) + 1;
-
-	uint j = 0;
-	uint curpos = 0;
-
-	/* Also has the added bonus of 'removing' the
-	 * automagically included '-' symbol by snprintf */
-	if (amt < 0) {
-		dest[j++] = '-';
-		curpos++;
-	}
-
-	/* Copy currency symbol next */
-	SafeStrncpy(dest + j, curr_sym, curr_sym_len + 1);
-	j += curr_sym_len;
-	dest[j++] = buf[curpos++];
-
-	for (uint i = curpos; i < len && j + max_append_size < size; i++) {
-		if (len - i > 3 && (int)(i - comma_start) % 3 == 0) {
-			SafeStrncpy(dest + j, tho_sep, tho_sep_len + 1);
-			j += tho_sep_len;
-			dest[j++] = buf[i];
-
-		} else if (buf[i] == '.') { // Decimal separator produced by 'snprintf'.
-			SafeStrncpy(dest + j, dec_sep, dec_sep_len + 1);
-			j += dec_sep_len;
 
-		} else {
-			dest[j++] = buf[i];
-		}
+	uint64 value = (amount < 0) ? -(uint64)amount : amount;
+	uint64 whole = value / 100;
+	uint8 digits[20]; // Enough for any 64 bit number.
+	int count = 0;
+	do {
+		digits[count++] = '0' + whole % 10;
+		whole /= 10;
+	} while (whole > 0);
+
+	if (amount < 0 && dest < last) *dest++ = '-';
+	dest = CopyString(dest, last, curr_sym);
+	while (count > 0 && dest < last) {
+		count--;
+		*dest++ = digits[count];
+		if (count > 0 && count % 3 == 0) dest = CopyString(dest, last, tho_sep);
 	}
-
-	assert((size_t)j < size);
-	dest[j] = '\0';
-	delete[] buf;
+	dest = CopyString(dest, last, dec_sep);
+	return CopyNumber(dest, last, value % 100, 2);
 }
 
 /**
- * Convert a temperature in 1/10 degrees Celcius to text.
- * @param dest [out] A provided buffer to write the output into.
- * @param size The size of the provided buffer.
- * @param temp Temperature in 1/10 degrees Celcius to convert.
+ * Copy a temperature in 1/10 degrees Celcius to the destination, as far as it fits.
+ * @param dest [out] Destination address.
+ * @param last Last byte of the destination (not written).
+ * @param temp Temperature in 1/10 degrees Celcius to copy.
+ * @return Updated destination.
  */
-static void TemperatureStrFormat(uint8 *dest, size_t size, int temp)
+static uint8 *CopyTemperature(uint8 *dest, const uint8 *last, int temp)
 {
 	static const uint8 SUFFIX[] = {' ', 0xE2, 0x84, 0x83, 0}; // " " + degrees Celcius, U+2103
 
 	temp = ((temp < 0) ? temp - 5 : temp + 5) / 10; // Round to degrees Celcius.
-	int len = snprintf((char *)dest, size, "%d", temp);
-	dest += len;
-	size -= len;
-	if (size >= lengthof(SUFFIX)) StrECpy(dest, dest + size, SUFFIX);
+	dest = CopyNumber(dest, last, temp);
+	if (dest + lengthof(SUFFIX) - 1 > last) return dest; // Do not write a partial UTF-8 sequence.
+	return CopyString(dest, last, SUFFIX);
+}
+
+/**
+ * Copy a date to the destination as day, month name, and year (for example "03-Apr-01"), as far as it fits.
+ * @param dest [out] Destination address.
+ * @param last Last byte of the destination (not written).
+ * @param d %Date to copy.
+ * @return Updated destination.
+ */
+static uint8 *CopyDate(uint8 *dest, const uint8 *last, const Date &d)
+{
+	dest = CopyNumber(dest, last, d.day, 2);
+	if (dest < last) *dest++ = '-';
+	dest = CopyString(dest, last, _language.GetText(GetMonthName(d.month)));
+	if (dest < last) *dest++ = '-';
+	return CopyNumber(dest, last, d.year, 2);
 }
 
 /**
@@ -393,72 +473,52 @@ static void TemperatureStrFormat(uint8 *dest, size_t size, int temp)
  */
 void DrawText(StringID strid, uint8 *buffer, uint length, StringParameters *params)
 {
-	static uint8 textbuf[64];
-
-	const uint8 *txt = _language.GetText(strid);
+	const StringTemplate *tmpl = _language.GetTemplate(strid);
 	const uint8 *last = buffer + ((int)length - 1);
-	const uint8 *ptr = txt;
-	for (;;) {
-		while (*ptr != '\0' && *ptr != '%' && buffer < last) {
-			*buffer = *ptr;
-			buffer++;
-			ptr++;
-		}
-		if (*ptr == '\0' || buffer >= last) break;
-		ptr++;
-		if (*ptr == '%') {
-			*buffer = '%';
-			buffer++;
-			ptr++;
+	for (const TemplatePart &part : tmpl->parts) {
+		if (buffer >= last) break;
+
+		if (part.param == 0) {
+			size_t count = std::min<size_t>(part.length, last - buffer);
+			memcpy(buffer, tmpl->text + part.start, count);
+			buffer += count;
 			continue;
 		}
-		int n = 0;
-		while (*ptr >= '0' && *ptr <= '9') {
-			n = n * 10 + *ptr - '0';
-			ptr++;
-		}
-		if (params != nullptr && n >= 1 && n <= (int)lengthof(params->parms)) {
-			/* Expand parameter 'n-1'. */
-			switch (params->parms[n - 1].parm_type) {
-				case SPT_NONE:
-					buffer = CopyString(buffer, last, (uint8 *)"NONE");
-					break;
-
-				case SPT_STRID:
-					buffer = CopyString(buffer, last, _language.GetText(params->parms[n - 1].u.str));
-					break;
-
-				case SPT_UINT8:
-					buffer = CopyString(buffer, last, params->parms[n - 1].u.text);
-					break;
-
-				case SPT_NUMBER:
-					snprintf((char *)textbuf, lengthof(textbuf), "%lld", params->parms[n - 1].u.number);
-					buffer = CopyString(buffer, last, textbuf);
-					break;
-
-				case SPT_MONEY:
-					MoneyStrFmt(textbuf, lengthof(textbuf), params->parms[n - 1].u.number / 100.0);
-					buffer = CopyString(buffer, last, textbuf);
-					break;
-
-				case SPT_TEMPERATURE:
-					TemperatureStrFormat(textbuf, lengthof(textbuf), params->parms[n - 1].u.number);
-					buffer = CopyString(buffer, last, textbuf);
-					break;
-
-				case SPT_DATE: {
-					Date d(params->parms[n - 1].u.dmy);
-					buffer = CopyString(buffer, last, GetDateString(d));
-					break;
-				}
-
-				default: NOT_REACHED();
-			}
+		if (params == nullptr) continue;
+
+		/* Expand parameter 'param - 1'. */
+		const StringParameterData &parm = params->parms[part.param - 1];
+		switch (parm.parm_type) {
+			case SPT_NONE:
+				buffer = CopyString(buffer, last, (uint8 *)"NONE");
+				break;
+
+			case SPT_STRID:
+				buffer = CopyString(buffer, last, _language.GetText(parm.u.str));
+				break;
+
+			case SPT_UINT8:
+				buffer = CopyString(buffer, last, parm.u.text);
+				break;
+
+			case SPT_NUMBER:
+				buffer = CopyNumber(buffer, last, parm.u.number);
+				break;
+
+			case SPT_MONEY:
+				buffer = CopyMoney(buffer, last, parm.u.number);
+				break;
+
+			case SPT_TEMPERATURE:
+				buffer = CopyTemperature(buffer, last, parm.u.number);
+				break;
+
+			case SPT_DATE:
+				buffer = CopyDate(buffer, last, Date(parm.u.dmy));
+				break;
+
+			default: NOT_REACHED();
 		}
-		while (*ptr != '\0' && *ptr != '%') ptr++; // Skip to the next '%'
-		if (*ptr == '\0') break;
-		ptr++;
 	}
 	*buffer = '\0';
 	if (params != nullptr) params->set_mode = false; // Clean parameters on next Set.
@@ -507,15 +567,13 @@ void GetTextSize(StringID strid, int *width, int *height)
 /**
  * Convert the date to a Unicode string.
  * @param d %Date to format.
- * @param format C-Style format code.
- * @return The formatted string.
- * @todo Allow variable number of format parameters, e.g. "mm-yy".
+ * @return The formatted string (see #CopyDate for the format).
+ * @todo Allow other date formats, e.g. "mm-yy".
  */
-const uint8 *GetDateString(const Date &d, const char *format)
+const uint8 *GetDateString(const Date &d)
 {
 	static uint8 textbuf[64];
-	const uint8 *month = _language.GetText(GetMonthName(d.month));
-	snprintf((char *)textbuf, lengthof(textbuf), format, d.day, month, d.year);
+	*CopyDate(textbuf, lastof(textbuf), d) = '\0';
 	return textbuf;
 }
 
@@ -548,7 +606,7 @@ Point32 GetMaxDateSize()
 Point32 GetMoneyStringSize(const Money &amount)
 {
 	uint8 textbuf[64];
-	MoneyStrFmt(textbuf, lengthof(textbuf), (int64)amount / 100.0);
+	*CopyMoney(textbuf, lastof(textbuf), (int64)amount) = '\0';
 	Point32 p;
 	_video.GetTextSize(textbuf, &p.x, &p.y);
 	return p;
@@ -566,3 +624,43 @@ void UninitLanguage()
 {
 	_language.Clear();
 }
+
+/**
+ * Format strings with numbers, amounts of money, and dates a number of times, and print how fast it was done.
+ * @param repeat Number of times to format the strings.
+ * @return Exit code of the program.
+ */
+int RunTextBenchmark(int repeat)
+{
+	uint8 buffer[256];
+	StringParameters params;
+	uint64 length = 0; // Total length of the formatted strings, so they are not optimized away.
+	uint64 count = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < repeat; i++) {
+		params.SetNumber(1, i * 7919LL - 1000000);
+		DrawText(STR_ARG1, buffer, lengthof(buffer), &params);
+		length += strlen((const char *)buffer);
+
+		params.SetMoney(1, Money(i * 12347LL - 5000000));
+		DrawText(STR_ARG1, buffer, lengthof(buffer), &params);
+		length += strlen((const char *)buffer);
+
+		params.SetDate(1, Date(1 + i % 28, 1 + i % 12, 1 + i % 100));
+		DrawText(STR_ARG1, buffer, lengthof(buffer), &params);
+		length += strlen((const char *)buffer);
+
+		params.SetStrID(1, GUI_MONTH_JANUARY + i % 12);
+		params.SetNumber(2, i);
+		DrawText(GUI_NUMBERED_INSTANCE_NAME, buffer, lengthof(buffer), &params);
+		length += strlen((const char *)buffer);
+		count += 4;
+	}
+	int64 total_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+	double seconds = std::max(total_time, (int64)1) / 1000000.0;
+	printf("%llu strings, %llu bytes, %.1f ns per string, %.0f strings/s\n", (unsigned long long)count, (unsigned long long)length,
+			seconds * 1000000000.0 / count, count / seconds);
+	return 0;
+}
@@ -13,6 +13,7 @@
 #define LANGUAGE_H
 
 #include "geometry.h"
+#include <vector>
 
 class TextData;
 class Money;
@@ -83,16 +84,26 @@ public:
 
 	void Clear();
 
+	/**
+	 * Get the string in a language.
+	 * @param lang Index of the language.
+	 * @return Text of this string in the given language, or in the default language if it has no translation.
+	 */
+	const uint8 *GetString(int lang) const
+	{
+		if (lang < 0 || lang >= LANGUAGE_COUNT) return (uint8 *)"<out of bounds>";
+		if (this->languages[lang] != nullptr) return this->languages[lang];
+		if (this->languages[LANG_EN_GB] != nullptr) return this->languages[LANG_EN_GB];
+		return (uint8 *)"<no-text>";
+	}
+
 	/**
 	 * Get the string in the currently selected language.
 	 * @return Text of this string in the currently selected language.
 	 */
 	const uint8 *GetString() const
 	{
-		if (_current_language < 0 || _current_language >= LANGUAGE_COUNT) return (uint8 *)"<out of bounds>";
-		if (this->languages[_current_language] != nullptr) return this->languages[_current_language];
-		if (this->languages[LANG_EN_GB] != nullptr) return this->languages[LANG_EN_GB];
-		return (uint8 *)"<no-text>";
+		return this->GetString(_current_language);
 	}
 
 	const char *name;                       ///< Name of the string.
@@ -139,6 +150,23 @@ struct StringParameters {
 	StringParameterData parms[16]; ///< Parameters of the string, arbitrary limit.
 };
 
+/** Part of a compiled string template, either literal text or a parameter. */
+struct TemplatePart {
+	uint16 start;  ///< Offset of the literal text in the text of the template.
+	uint16 length; ///< Length of the literal text in bytes.
+	uint8 param;   ///< Parameter to expand (1-based), \c 0 means the part is literal text.
+};
+
+/** Text of a string in one language, with its "%n%" patterns parsed beforehand. */
+struct StringTemplate {
+	const uint8 *text;               ///< Text of the string, \c nullptr if not compiled.
+	std::vector<TemplatePart> parts; ///< Parts of the text, in order.
+
+	void Compile(const uint8 *text);
+};
+
+static const uint MAX_REGISTERED_STRINGS = 2048; ///< Maximal number of strings known by the #Language (arbitrary size).
+
 /**
  * Class for retrieving language strings.
  * @todo Implement me.
@@ -152,12 +180,16 @@ public:
 	uint16 RegisterStrings(const TextData &td, const char * const names[], uint16 base = STR_GENERIC_END);
 
 	const uint8 *GetText(StringID number);
+	const StringTemplate *GetTemplate(StringID number) const;
 	const uint8 *GetLanguageName(int lang_index);
 
 private:
 	/** Registered strings. Entries may be \c nullptr for unregistered or non-existing strings. */
-	const TextString *registered[2048]; // Arbitrary size.
+	const TextString *registered[MAX_REGISTERED_STRINGS];
 	uint first_free; ///< 'First' string index that is not allocated yet.
+
+	StringTemplate templates[MAX_REGISTERED_STRINGS][LANGUAGE_COUNT]; ///< Compiled texts of the strings in every language.
+	StringTemplate invalid_template; ///< Compiled text of strings that do not exist.
 };
 
 int GetLanguageIndex(const char *lang_name);
@@ -172,8 +204,10 @@ extern StringParameters _str_params;
 
 void DrawText(StringID num, uint8 *buffer, uint length, StringParameters *params = &_str_params);
 
-const uint8 *GetDateString(const Date &d, const char *format = "%02d-%s-%02d");
+const uint8 *GetDateString(const Date &d);
 Point32 GetMaxDateSize();
 Point32 GetMoneyStringSize(const Money &amount);
 
+int RunTextBenchmark(int repeat);
+
 #endif
@@ -14,17 +14,80 @@
 #include "random.h"
 #include "finances.h"
 #include "map.h"
+#include "ride_type.h"
+#include "person.h"
+#include "people.h"
+#include "fileio.h"
+#include "compress.h"
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
 
 /**
  * Constructor of the loader class.
- * @param fp Input file stream. Use \c nullptr for initialization to default.
+ * @param data Data to load. Use \c nullptr for initialization to default.
+ * @param size Size of the data.
  */
-Loader::Loader(FILE *fp)
+Loader::Loader(const uint8 *data, size_t size)
 {
 	this->fail_msg = nullptr;
 	this->blk_name = nullptr;
-	this->fp = fp;
-	this->cache_count = 0;
+	this->data = data;
+	this->size = (data == nullptr) ? 0 : size;
+	this->pos = 0;
+	this->skippable = false;
+	this->blk_end = 0;
+}
+
+/**
+ * The following blocks store the length of their data, and can be skipped.
+ * @see Saver::SetSkippableBlocks
+ */
+void Loader::SetSkippableBlocks()
+{
+	this->skippable = true;
+}
+
+/**
+ * The remaining data is compressed, decompress it and continue loading from the decompressed data.
+ * @return Whether decompressing succeeded.
+ * @see Saver::CompressFrom
+ */
+bool Loader::DecompressRemainder()
+{
+	if (this->data == nullptr || this->IsFail()) return false;
+
+	assert(this->blk_name == nullptr);
+	std::vector<uint8> buffer;
+	if (!DecompressData(this->data + this->pos, this->size - this->pos, &buffer)) {
+		this->SetFailMessage("Corrupt compressed data");
+		return false;
+	}
+	if (buffer.empty()) {
+		this->pos = this->size;
+		return true;
+	}
+
+	this->decompressed.swap(buffer);
+	this->data = this->decompressed.data();
+	this->size = this->decompressed.size();
+	this->pos = 0;
+	return true;
+}
+
+/**
+ * Test whether enough data is available for loading, and fail loading if not.
+ * @param count Number of bytes that should be available.
+ * @return Whether the data is available.
+ */
+bool Loader::HasBytes(size_t count)
+{
+	if (this->data == nullptr || this->IsFail()) return false;
+	if (this->size - this->pos >= count) return true;
+
+	this->SetFailMessage("EOF encountered");
+	return false;
 }
 
 /**
@@ -32,46 +95,59 @@ Loader::Loader(FILE *fp)
  * @param name Name of the expected block.
  * @param may_fail Whether it is allowed not to find the expected block.
  * @return Version number of the found block, \c 0 for default initialization, #UINT32_MAX for failing to find the block (only if \a may_fail was set).
- * @note If the block was not found, bytes already read of the block name are pushed back onto the stream.
+ * @note If the block was not found, nothing of the block is loaded.
  */
 uint32 Loader::OpenBlock(const char *name, bool may_fail)
 {
 	assert(strlen(name) == 4);
 
-	if (this->fp == nullptr || this->IsFail()) return 0;
+	if (this->data == nullptr || this->IsFail()) return 0;
 
 	assert(this->blk_name == nullptr);
-	this->blk_name = name;
-	int i = 0;
-	while (i < 4) {
-		uint8 val = this->GetByte();
-		if (val != this->blk_name[i]) {
-			this->PutByte(val);
-			while (i > 0) {
-				i--;
-				this->PutByte(this->blk_name[i]);
-			}
-			if (may_fail) return UINT32_MAX;
-			this->SetFailMessage("Missing block name");
-			return 0;
-		}
-		i++;
+	if (this->size - this->pos < 4 || memcmp(this->data + this->pos, name, 4) != 0) {
+		if (may_fail) return UINT32_MAX;
+		this->SetFailMessage("Missing block name");
+		return 0;
 	}
+	this->blk_name = name;
+	this->pos += 4;
 
 	uint32 version = this->GetLong();
 	if (version == 0 || version == UINT32_MAX) {
 		this->SetFailMessage("Incorrect version number");
 		return 0;
 	}
+	if (this->skippable) {
+		uint32 length = this->GetLong();
+		if (!this->HasBytes(length)) return 0;
+		this->blk_end = this->pos + length;
+	}
 	return version;
 }
 
+/**
+ * Skip the remaining data of the current block without loading it, for example when its version is unknown.
+ * @return Whether the block was skipped. Blocks can only be skipped if they store their length, see #SetSkippableBlocks.
+ */
+bool Loader::SkipBlock()
+{
+	if (this->data == nullptr || this->IsFail() || !this->skippable) return false;
+
+	assert(this->blk_name != nullptr);
+	if (this->pos <= this->blk_end) this->pos = this->blk_end;
+	return true;
+}
+
 /** Test whether the current block is closed. */
 void Loader::CloseBlock()
 {
-	if (this->fp == nullptr || this->IsFail()) return;
+	if (this->data == nullptr || this->IsFail()) return;
 
 	assert(this->blk_name != nullptr);
+	if (this->skippable && this->pos != this->blk_end) {
+		this->SetFailMessage("Block has an unexpected length");
+		return;
+	}
 	if (this->GetByte() != this->blk_name[3] || this->GetByte() != this->blk_name[2] ||
 			this->GetByte() != this->blk_name[1] || this->GetByte() != this->blk_name[0]) {
 		this->SetFailMessage("CloseBlock got unexpected data");
@@ -80,61 +156,41 @@ void Loader::CloseBlock()
 }
 
 /**
- * Get the next byte from the stream (or the cache).
+ * Get the next byte from the data.
  * @return The read next byte.
  */
 uint8 Loader::GetByte()
 {
-	if (this->fp == nullptr || this->IsFail()) return 0;
-	
-	if (this->cache_count > 0) {
-		this->cache_count--;
-		return this->cache[this->cache_count];
-	}
-	int k = getc(this->fp);
-	if (k == EOF) {
-		this->SetFailMessage("EOF encountered");
-		return 0;
-	}
-	return k;
-}
-
-/**
- * Put a byte in the temporary cache.
- * @param val Value to save.
- */
-void Loader::PutByte(uint8 val)
-{
-	if (this->IsFail()) return;
-	assert(this->cache_count < (int)lengthof(this->cache));
-	this->cache[this->cache_count] = val;
-	this->cache_count++;
+	if (!this->HasBytes(1)) return 0;
+	return this->data[this->pos++];
 }
 
 /**
- * Get the next word from the stream (or the cache).
+ * Get the next word from the data.
  * @return The read next word.
  */
 uint16 Loader::GetWord()
 {
-	uint16 v = this->GetByte();
-	uint16 w = this->GetByte();
-	return v | (w << 8);
+	if (!this->HasBytes(2)) return 0;
+	const uint8 *p = this->data + this->pos;
+	this->pos += 2;
+	return p[0] | (p[1] << 8);
 }
 
 /**
- * Get the next long word from the stream (or the cache).
+ * Get the next long word from the data.
  * @return The read next long word.
  */
 uint32 Loader::GetLong()
 {
-	uint32 v = this->GetWord();
-	uint32 w = this->GetWord();
-	return v | (w << 16);
+	if (!this->HasBytes(4)) return 0;
+	const uint8 *p = this->data + this->pos;
+	this->pos += 4;
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32)p[3] << 24);
 }
 
 /**
- * Get the next long long word from the stream (or the cache).
+ * Get the next long long word from the data.
  * @return The read next long long word.
  */
 uint64 Loader::GetLongLong()
@@ -144,6 +200,21 @@ uint64 Loader::GetLongLong()
 	return v | (w << 32);
 }
 
+/**
+ * Get a number of bytes from the data.
+ * @param address [out] Memory to store the bytes. On failure, the memory is cleared.
+ * @param length Number of bytes to get.
+ */
+void Loader::GetBlob(void *address, size_t length)
+{
+	if (!this->HasBytes(length)) {
+		memset(address, 0, length);
+		return;
+	}
+	memcpy(address, this->data + this->pos, length);
+	this->pos += length;
+}
+
 /**
  * Denote loading as being failed.
  * @param fail_msg Message to explain what failed. Caller must preserve the message text.
@@ -174,14 +245,38 @@ bool Loader::IsFail() const
 	return this->fail_msg != nullptr;
 }
 
+static const size_t INITIAL_SAVE_SIZE = 64 * 1024; ///< Initial size of the memory for the saved data, in bytes.
+
+/** Constructor for the saver. */
+Saver::Saver()
+{
+	this->blk_name = nullptr;
+	this->skippable = false;
+	this->blk_length_pos = 0;
+	this->data.reserve(INITIAL_SAVE_SIZE);
+}
+
 /**
- * Constructor for the saver.
- * @param fp Output file stream to write to.
+ * Store the length of the data of the following blocks, so a loader can skip them.
+ * @see Loader::SetSkippableBlocks
  */
-Saver::Saver(FILE *fp)
+void Saver::SetSkippableBlocks()
 {
-	this->fp = fp;
-	this->blk_name = nullptr;
+	this->skippable = true;
+}
+
+/**
+ * Compress the data saved from a position until now, the data saved after it is not compressed.
+ * @param start Position in the saved data to start compressing.
+ * @see Loader::DecompressRemainder
+ */
+void Saver::CompressFrom(size_t start)
+{
+	assert(this->blk_name == nullptr && start <= this->data.size());
+
+	std::vector<uint8> buffer(this->data.begin(), this->data.begin() + start);
+	CompressData(this->data.data() + start, this->data.size() - start, &buffer);
+	this->data.swap(buffer);
 }
 
 /**
@@ -194,50 +289,59 @@ void Saver::StartBlock(const char *name, uint32 version)
 	assert(strlen(name) == 4);
 	assert(this->blk_name == nullptr);
 	this->blk_name = name;
-	for (int i = 0; i < 4; i++) this->PutByte(name[i]);
+	this->PutBlob(name, 4);
 	assert(version != 0 && version != UINT32_MAX);
 	this->PutLong(version);
+	if (this->skippable) {
+		this->blk_length_pos = this->data.size();
+		this->PutLong(0); // Length of the block, filled in by #EndBlock.
+	}
 }
 
 /** Write the end of the block to the output. */
 void Saver::EndBlock()
 {
 	assert(this->blk_name != nullptr);
+	if (this->skippable) {
+		size_t length = this->data.size() - (this->blk_length_pos + 4);
+		assert(length < UINT32_MAX);
+		for (int i = 0; i < 4; i++) this->data[this->blk_length_pos + i] = length >> (8 * i);
+	}
 	for (int i = 3; i >= 0; i--) this->PutByte(this->blk_name[i]);
 	this->blk_name = nullptr;
 }
 
 /**
- * Write a byte to the output stream.
+ * Write a byte to the output.
  * @param val Value to write.
  */
 void Saver::PutByte(uint8 val)
 {
-	putc(val, this->fp);
+	this->data.push_back(val);
 }
 
 /**
- * Write a word to the output stream.
+ * Write a word to the output.
  * @param val Value to write.
  */
 void Saver::PutWord(uint16 val)
 {
-	this->PutByte(val);
-	this->PutByte(val >> 8);
+	uint8 bytes[2] = {(uint8)val, (uint8)(val >> 8)};
+	this->data.insert(this->data.end(), bytes, bytes + 2);
 }
 
 /**
- * Write a long word to the output stream.
+ * Write a long word to the output.
  * @param val Value to write.
  */
 void Saver::PutLong(uint32 val)
 {
-	this->PutWord(val);
-	this->PutWord(val >> 16);
+	uint8 bytes[4] = {(uint8)val, (uint8)(val >> 8), (uint8)(val >> 16), (uint8)(val >> 24)};
+	this->data.insert(this->data.end(), bytes, bytes + 4);
 }
 
 /**
- * Write a long long word to the output stream.
+ * Write a long long word to the output.
  * @param val Value to write.
  */
 void Saver::PutLongLong(uint64 val)
@@ -246,6 +350,41 @@ void Saver::PutLongLong(uint64 val)
 	this->PutLong(val >> 32);
 }
 
+/**
+ * Write a number of bytes to the output.
+ * @param address First byte to write.
+ * @param length Number of bytes to write.
+ */
+void Saver::PutBlob(const void *address, size_t length)
+{
+	const uint8 *bytes = static_cast<const uint8 *>(address);
+	this->data.insert(this->data.end(), bytes, bytes + length);
+}
+
+/**
+ * Write the saved data to a file.
+ * @param fname Name of the file to write.
+ * @return Whether writing was successful.
+ */
+bool Saver::WriteFile(const char *fname) const
+{
+	FILE *fp = fopen(fname, "wb");
+	if (fp == nullptr) return false;
+
+	bool ok = this->data.empty() || fwrite(this->data.data(), this->data.size(), 1, fp) == 1;
+	return fclose(fp) == 0 && ok;
+}
+
+bool _compress_savegames = true; ///< Whether to compress the game elements when saving a game.
+int _autosave_interval = 0;      ///< Number of months between two autosaves, \c 0 disables autosaving.
+
+static const char *AUTOSAVE_FILE = "autosave.fct"; ///< File written by autosaving.
+
+/** Flags of the file header of a saved game. */
+enum SaveGameFlags {
+	SGF_COMPRESSED = 1 << 0, ///< The data after the file header is compressed.
+};
+
 /**
  * Load the game elements from the input stream.
  * @param ldr Input stream to load from.
@@ -253,20 +392,50 @@ void Saver::PutLongLong(uint64 val)
  */
 static void LoadElements(Loader &ldr)
 {
+	/* Remove the guests and rides of the current game, while the world they are in still exists. */
+	_guests.RemoveAllGuests();
+	_rides_manager.DeleteAllRideInstances();
+
 	uint32 version = ldr.OpenBlock("FCTS");
-	if (version > 3) ldr.SetFailMessage("Bad file header");
+	uint32 flags = 0;
+	if (version > 6) {
+		ldr.SetFailMessage("Bad file header");
+	} else if (version >= 5) {
+		flags = ldr.GetLong();
+		if ((flags & ~SGF_COMPRESSED) != 0) ldr.SetFailMessage("Unknown file header flags");
+	}
 	ldr.CloseBlock();
+	if ((flags & SGF_COMPRESSED) != 0) ldr.DecompressRemainder();
+	if (version >= 4) ldr.SetSkippableBlocks();
 
 	Loader reset_loader(nullptr);
 
 	LoadDate(ldr);
 	_world.Load((version >= 3) ? ldr : reset_loader);
-	Random::Load(ldr);
+	if (version < 6) Random::Load(ldr);
 	_finances_manager.Load((version >= 2) ? ldr : reset_loader);
+	_rides_manager.Load((version >= 6) ? ldr : reset_loader);
+	_guests.Load((version >= 6) ? ldr : reset_loader);
+	if (version >= 6) Random::Load(ldr); // Creating the rides and guests draws random numbers.
 
 	if (reset_loader.IsFail()) ldr.SetFailMessage(reset_loader.GetFailMessage());
 }
 
+/**
+ * Write the file header.
+ * @param svr Output stream to write to.
+ * @param compress Whether the data after the file header will be compressed.
+ * @return Position of the data after the file header.
+ */
+static size_t SaveFileHeader(Saver &svr, bool compress)
+{
+	svr.StartBlock("FCTS", 6);
+	svr.PutLong(compress ? SGF_COMPRESSED : 0);
+	svr.EndBlock();
+	svr.SetSkippableBlocks();
+	return svr.GetData().size();
+}
+
 /**
  * Write the game elements to the output stream.
  * @param svr Output stream to write to.
@@ -274,13 +443,16 @@ static void LoadElements(Loader &ldr)
  */
 static void SaveElements(Saver &svr)
 {
-	svr.StartBlock("FCTS", 3);
-	svr.EndBlock();
+	size_t start = SaveFileHeader(svr, _compress_savegames);
 
 	SaveDate(svr);
 	_world.Save(svr);
-	Random::Save(svr);
 	_finances_manager.Save(svr);
+	_rides_manager.Save(svr);
+	_guests.Save(svr);
+	Random::Save(svr);
+
+	if (_compress_savegames) svr.CompressFrom(start);
 }
 
 /**
@@ -290,17 +462,13 @@ static void SaveElements(Saver &svr)
  */
 bool LoadGame(const char *fname)
 {
-	FILE *fp;
+	FinishBackgroundSave(true);
 
-	if (fname == nullptr) {
-		fp = nullptr;
-	} else {
-		fp = fopen(fname, "rb");
-		if (fp == nullptr) return false;
-	}
-	Loader ldr(fp);
+	FileContents contents;
+	if (fname != nullptr && (!contents.Load(fname) || contents.data == nullptr)) return false;
+
+	Loader ldr(contents.data, contents.size);
 	LoadElements(ldr);
-	if (fp != nullptr) fclose(fp);
 	if (!ldr.IsFail()) return true;
 
 	Loader reset(nullptr);
@@ -315,11 +483,133 @@ bool LoadGame(const char *fname)
  */
 bool SaveGame(const char *fname)
 {
-	FILE *fp = fopen(fname, "wb");
-	if (fp == nullptr) return false;
-	Saver svr(fp);
+	FinishBackgroundSave(true);
+
+	Saver svr;
 	SaveElements(svr);
-	fclose(fp);
+	return svr.WriteFile(fname);
+}
+
+/** Game being saved in a background thread, while the game continues. */
+struct BackgroundSave {
+	std::string fname;         ///< Name of the file to write.
+	bool compress;             ///< Whether to compress the data after the file header.
+	size_t compress_start;     ///< Position of the data after the file header in #head.
+	Saver head;                ///< File header and the game elements before the world, followed by the rest of the file.
+	Saver tail;                ///< Game elements after the world.
+	WorldSnapshot *snapshot;   ///< Snapshot of the world to save.
+	std::thread thread;        ///< Thread saving the game.
+	std::atomic<bool> done;    ///< Whether the thread has finished.
+	bool result;               ///< Whether writing the file succeeded, valid after the thread has finished.
+};
+
+static std::unique_ptr<BackgroundSave> _background_save; ///< Game being saved in the background, if any.
+static int _months_since_autosave = 0; ///< Number of months since the previous autosave.
+
+/**
+ * Save the world of a background save, and write the file (runs in the background thread).
+ * @param bs Game being saved.
+ */
+static void RunBackgroundSave(BackgroundSave *bs)
+{
+	bs->snapshot->Save(bs->head);
+	bs->head.PutBlob(bs->tail.GetData().data(), bs->tail.GetData().size());
+	if (bs->compress) bs->head.CompressFrom(bs->compress_start);
+	bs->result = bs->head.WriteFile(bs->fname.c_str());
+	bs->done = true;
+}
+
+/**
+ * Save the game to a file while the game continues.
+ * The small game elements are saved immediately, the world is saved from a snapshot in a background thread.
+ * @param fname Name of the file to write.
+ * @return Whether saving started, it fails if a previous background save is still running.
+ * @note Call #FinishBackgroundSave regularly to clean up after the save.
+ */
+bool StartBackgroundSave(const char *fname)
+{
+	FinishBackgroundSave(false);
+	if (_background_save != nullptr) return false;
+
+	BackgroundSave *bs = new BackgroundSave;
+	_background_save.reset(bs);
+	bs->fname = fname;
+	bs->compress = _compress_savegames;
+	bs->done = false;
+	bs->result = false;
+
+	/* Save in the same order as #SaveElements. */
+	bs->compress_start = SaveFileHeader(bs->head, bs->compress);
+	SaveDate(bs->head);
+	bs->snapshot = _world.StartSnapshot();
+	bs->tail.SetSkippableBlocks();
+	_finances_manager.Save(bs->tail);
+	_rides_manager.Save(bs->tail);
+	_guests.Save(bs->tail);
+	Random::Save(bs->tail);
+
+	bs->thread = std::thread(RunBackgroundSave, bs);
 	return true;
 }
 
+/**
+ * Clean up after a finished background save.
+ * @param wait Wait for a running background save to finish.
+ */
+void FinishBackgroundSave(bool wait)
+{
+	BackgroundSave *bs = _background_save.get();
+	if (bs == nullptr || (!wait && !bs->done)) return;
+
+	bs->thread.join();
+	_world.EndSnapshot();
+	if (!bs->result) fprintf(stderr, "Saving the game to \"%s\" failed\n", bs->fname.c_str());
+	_background_save.reset();
+}
+
+/** A month has passed, save the game in the background if it is time to autosave. */
+void AutosaveOnNewMonth()
+{
+	if (_autosave_interval <= 0) return;
+	_months_since_autosave++;
+	if (_months_since_autosave < _autosave_interval) return;
+
+	if (StartBackgroundSave(AUTOSAVE_FILE)) _months_since_autosave = 0;
+}
+
+/**
+ * Measure the speed of saving the current game state to memory, and of loading it again.
+ * @param repeat Number of times to save and load the game.
+ * @return Exit code of the program.
+ */
+int RunSaveBenchmark(int repeat)
+{
+	int64 save_time = 0; // In microseconds.
+	int64 load_time = 0; // In microseconds.
+	size_t size = 0;
+	for (int i = 0; i < std::max(repeat, 1); i++) {
+		auto start = std::chrono::steady_clock::now();
+		Saver svr;
+		SaveElements(svr);
+		auto middle = std::chrono::steady_clock::now();
+		size = svr.GetData().size();
+
+		Loader ldr(svr.GetData().data(), size);
+		LoadElements(ldr);
+		auto end = std::chrono::steady_clock::now();
+		if (ldr.IsFail()) {
+			fprintf(stderr, "ERROR: Loading the saved game failed: %s\n", ldr.GetFailMessage());
+			return 1;
+		}
+		save_time += std::chrono::duration_cast<std::chrono::microseconds>(middle - start).count();
+		load_time += std::chrono::duration_cast<std::chrono::microseconds>(end - middle).count();
+	}
+
+	repeat = std::max(repeat, 1);
+	double megabytes = size / 1000000.0;
+	printf("%ux%u tiles, %lu bytes, save %.2f ms (%.1f MB/s), load %.2f ms (%.1f MB/s)\n",
+			_world.GetXSize(), _world.GetYSize(), (unsigned long)size,
+			save_time / 1000.0 / repeat, megabytes * repeat * 1000000.0 / std::max(save_time, (int64)1),
+			load_time / 1000.0 / repeat, megabytes * repeat * 1000000.0 / std::max(load_time, (int64)1));
+	return 0;
+}
@@ -12,39 +12,51 @@
 #ifndef LOADSAVE_H
 #define LOADSAVE_H
 
-/** Class for loading a save game. */
+#include <vector>
+
+/** Class for loading a save game from memory. */
 class Loader {
 public:
-	Loader(FILE *fp);
+	Loader(const uint8 *data, size_t size = 0);
 
+	void SetSkippableBlocks();
+	bool DecompressRemainder();
 	uint32 OpenBlock(const char *name, bool may_fail = false);
+	bool SkipBlock();
 	void CloseBlock();
 
 	uint8 GetByte();
 	uint16 GetWord();
 	uint32 GetLong();
 	uint64 GetLongLong();
+	void GetBlob(void *address, size_t length);
 
 	void SetFailMessage(const char *fail_msg);
 	const char *GetFailMessage() const;
 	bool IsFail() const;
 
 private:
-	void PutByte(uint8 val);
+	bool HasBytes(size_t count);
 
 	const char *fail_msg; ///< If not \c nullptr, message of failure.
 	const char *blk_name; ///< Name of the current block.
 
-	FILE *fp;             ///< Data stream being loaded.
-	int cache_count;      ///< Number of values in #cache.
-	uint8 cache[8];       ///< Stack with temporary values to return on next read.
+	const uint8 *data; ///< Data being loaded, \c nullptr for initialization to default.
+	size_t size;       ///< Size of #data.
+	size_t pos;        ///< Position of the next byte to load in #data.
+	bool skippable;    ///< Whether blocks store the length of their data, so they can be skipped.
+	size_t blk_end;    ///< End of the data of the current block, if #skippable.
+
+	std::vector<uint8> decompressed; ///< Decompressed data, if the data was compressed.
 };
 
-/** Class for saving a savegame. */
+/** Class for saving a save game into memory. */
 class Saver {
 public:
-	Saver(FILE *fp);
+	Saver();
 
+	void SetSkippableBlocks();
+	void CompressFrom(size_t start);
 	void StartBlock(const char *name, uint32 version);
 	void EndBlock();
 
@@ -52,13 +64,34 @@ public:
 	void PutWord(uint16 val);
 	void PutLong(uint32 val);
 	void PutLongLong(uint64 val);
+	void PutBlob(const void *address, size_t length);
+
+	bool WriteFile(const char *fname) const;
+
+	/**
+	 * Get the saved data.
+	 * @return The data saved until now.
+	 */
+	inline const std::vector<uint8> &GetData() const
+	{
+		return this->data;
+	}
 
 private:
-	FILE *fp; ///< Output file stream.
-	const char *blk_name; ///< Name of the current block.
+	std::vector<uint8> data; ///< Saved data.
+	const char *blk_name;    ///< Name of the current block.
+	bool skippable;          ///< Whether blocks store the length of their data, so they can be skipped.
+	size_t blk_length_pos;   ///< Position of the length of the current block in #data, if #skippable.
 };
 
+extern bool _compress_savegames;
+extern int _autosave_interval;
+
 bool LoadGame(const char *fname);
 bool SaveGame(const char *fname);
+bool StartBackgroundSave(const char *fname);
+void FinishBackgroundSave(bool wait);
+void AutosaveOnNewMonth();
+int RunSaveBenchmark(int repeat);
 
 #endif
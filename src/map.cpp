@@ -19,6 +19,7 @@
 #include "viewport.h"
 #include "math_func.h"
 #include "sprite_store.h"
+#include "minimap.h"
 
 /**
  * The game world.
@@ -77,7 +78,7 @@ static void CopyStackData(Voxel *dest, Voxel *src, int count, bool copy_voxel_ob
 void Voxel::Load(Loader &ldr, uint32 version)
 {
 	this->ClearVoxel();
-	if (version == 1) {
+	if (version == 1 || version == 2) {
 		this->ground = ldr.GetLong(); /// \todo Check sanity of the data.
 		this->instance = ldr.GetByte();
 		if (this->instance == SRI_FREE) {
@@ -93,6 +94,21 @@ void Voxel::Load(Loader &ldr, uint32 version)
 	}
 }
 
+/**
+ * Test whether two voxels are saved with the same data.
+ * @param other Voxel to compare with.
+ * @return Whether both voxels are saved as the same data.
+ */
+bool Voxel::HasSameSaveData(const Voxel &other) const
+{
+	if (this->ground != other.ground) return false;
+
+	bool small_ride = this->instance >= SRI_RIDES_START && this->instance < SRI_FULL_RIDES;
+	bool other_small_ride = other.instance >= SRI_RIDES_START && other.instance < SRI_FULL_RIDES;
+	if (small_ride != other_small_ride) return false;
+	return !small_ride || (this->instance == other.instance && this->instance_data == other.instance_data);
+}
+
 /**
  * Write a voxel to the save game.
  * @param svr Output stream to write.
@@ -139,10 +155,21 @@ VoxelObject::~VoxelObject()
  * @return Sprite to display for the voxel object.
  */
 
+/**
+ * Get the offset of the object relative to its #pix_pos at the last tick, for drawing it at the position between ticks.
+ * By default, the object does not move between ticks.
+ * @param progress Number of milliseconds of game time since the last tick (less than #TICK_LENGTH).
+ * @return Offset to add to the #pix_pos of the object.
+ */
+XYZPoint16 VoxelObject::GetRenderOffset(uint32 progress) const
+{
+	return XYZPoint16(0, 0, 0);
+}
+
 /** Mark the voxel containing the voxel object as dirty, so it is repainted. */
 void VoxelObject::MarkDirty()
 {
-	MarkVoxelDirty(this->vox_pos);
+	MarkVoxelDirty(this->vox_pos, 0, false);
 }
 
 /** Default constructor. */
@@ -254,6 +281,7 @@ VoxelWorld::VoxelWorld()
 {
 	this->x_size = 64;
 	this->y_size = 64;
+	this->change_count = 0;
 }
 
 /**
@@ -271,8 +299,28 @@ void VoxelWorld::SetWorldSize(uint16 xs, uint16 ys)
 
 	/* Clear the world. */
 	for (uint pos = 0; pos < WORLD_X_SIZE * WORLD_Y_SIZE; pos++) {
+		if (this->snapshot != nullptr) this->snapshot->PreserveStack(pos, this->stacks[pos]);
 		this->stacks[pos].Clear();
 	}
+	this->NotifyChange();
+}
+
+/** Notify that the contents of the world changed in a way that may be visible at the screen (moving voxel objects excluded). */
+void VoxelWorld::NotifyChange()
+{
+	this->change_count++;
+	_minimap.MarkAllDirty();
+}
+
+/**
+ * Notify that the contents of a single voxel stack changed in a way that may be visible at the screen (moving voxel objects excluded).
+ * @param x X coordinate of the stack.
+ * @param y Y coordinate of the stack.
+ */
+void VoxelWorld::NotifyChange(uint16 x, uint16 y)
+{
+	this->change_count++;
+	_minimap.MarkTileDirty(x, y);
 }
 
 /**
@@ -319,6 +367,7 @@ void VoxelWorld::MakeFlatWorld(int16 z)
 		AddFoundations(this, 0, ypos, z, 0x03);
 		AddFoundations(this, this->x_size - 1, ypos, z, 0x30);
 	}
+	this->NotifyChange();
 }
 
 /**
@@ -392,12 +441,15 @@ int VoxelStack::GetGroundOffset() const
 /**
  * Load a voxel stack from the save game file.
  * @param ldr Input stream to read.
+ * @return Number of consecutive voxel stacks with the loaded contents, \c 0 if loading failed.
  */
-void VoxelStack::Load(Loader &ldr)
+uint VoxelStack::Load(Loader &ldr)
 {
 	this->Clear();
+	uint repeat = 0;
 	uint32 version = ldr.OpenBlock("VSTK");
-	if (version == 1) {
+	if (version == 1 || version == 2) {
+		repeat = (version == 1) ? 1 : ldr.GetWord();
 		int16 base = ldr.GetWord();
 		uint16 height = ldr.GetWord();
 		uint8 owner = ldr.GetByte();
@@ -411,17 +463,53 @@ void VoxelStack::Load(Loader &ldr)
 			this->voxels = (height > 0) ? MakeNewVoxels(height) : nullptr;
 			for (uint i = 0; i < height; i++) this->voxels[i].Load(ldr, version);
 		}
+	} else if (version != 0) {
+		ldr.SetFailMessage("Unknown voxel stack version");
 	}
 	ldr.CloseBlock();
+	return ldr.IsFail() ? 0 : repeat;
+}
+
+/**
+ * Test whether two voxel stacks are saved with the same data.
+ * @param other Voxel stack to compare with.
+ * @return Whether both stacks are saved as the same data.
+ */
+bool VoxelStack::HasSameSaveData(const VoxelStack &other) const
+{
+	if (this->base != other.base || this->height != other.height || this->owner != other.owner) return false;
+	for (uint i = 0; i < this->height; i++) {
+		if (!this->voxels[i].HasSameSaveData(other.voxels[i])) return false;
+	}
+	return true;
+}
+
+/**
+ * Copy the saved data of another voxel stack, to restore stacks that were saved as a repetition.
+ * @param other Voxel stack to copy.
+ */
+void VoxelStack::CopySaveData(const VoxelStack &other)
+{
+	this->Clear();
+	this->base = other.base;
+	this->height = other.height;
+	this->owner = other.owner;
+	if (this->height > 0) {
+		this->voxels = MakeNewVoxels(this->height);
+		CopyStackData(this->voxels, other.voxels, this->height, false);
+	}
 }
 
 /**
  * Save a voxel stack to the save game file.
  * @param svr Output stream to write.
+ * @param repeat Number of consecutive voxel stacks (in the order of saving) with the same contents, at most \c 0xFFFF.
  */
-void VoxelStack::Save(Saver &svr) const
+void VoxelStack::Save(Saver &svr, uint repeat) const
 {
-	svr.StartBlock("VSTK", 1);
+	assert(repeat > 0 && repeat <= 0xFFFF);
+	svr.StartBlock("VSTK", 2);
+	svr.PutWord(repeat);
 	svr.PutWord(this->base);
 	svr.PutWord(this->height);
 	svr.PutByte(this->owner);
@@ -441,7 +529,9 @@ VoxelStack *VoxelWorld::GetModifyStack(uint16 x, uint16 y)
 	assert(x < WORLD_X_SIZE && x < this->x_size);
 	assert(y < WORLD_Y_SIZE && y < this->y_size);
 
-	return &this->stacks[x + y * WORLD_X_SIZE];
+	uint index = x + y * WORLD_X_SIZE;
+	if (this->snapshot != nullptr) this->snapshot->PreserveStack(index, this->stacks[index]);
+	return &this->stacks[index];
 }
 
 /**
@@ -555,6 +645,7 @@ void VoxelWorld::SetTileOwner(uint16 x, uint16 y, TileOwner owner)
 	this->GetModifyStack(x, y)->owner = owner;
 
 	UpdateLandBorderFence(x, y, 1, 1);
+	this->NotifyChange(x, y);
 }
 
 /**
@@ -570,6 +661,7 @@ void VoxelWorld::SetTileOwnerRect(uint16 x, uint16 y, uint16 width, uint16 heigh
 	for (uint16 ix = x; ix < x + width; ix++) {
 		for (uint16 iy = y; iy < y + height; iy++) {
 			this->GetModifyStack(ix, iy)->owner = owner;
+			this->NotifyChange(ix, iy);
 		}
 	}
 
@@ -609,14 +701,45 @@ void VoxelWorld::Load(Loader &ldr)
 
 	this->SetWorldSize(xsize, ysize);
 	if (!ldr.IsFail() && version != 0) {
-		for (uint16 x = 0; x < xsize; x++) {
-			for (uint16 y = 0; y < ysize; y++) {
-				VoxelStack *vs = this->GetModifyStack(x, y);
-				vs->Load(ldr);
+		/* Stacks are stored with the y coordinate running fastest, identical consecutive stacks are stored once. */
+		uint count = xsize * ysize;
+		uint index = 0;
+		while (index < count && !ldr.IsFail()) {
+			VoxelStack *vs = this->GetModifyStack(index / ysize, index % ysize);
+			uint repeat = vs->Load(ldr);
+			if (repeat == 0 || repeat > count - index) {
+				ldr.SetFailMessage("Incorrect number of voxel stacks");
+				break;
+			}
+			for (uint i = 1; i < repeat; i++) {
+				this->GetModifyStack((index + i) / ysize, (index + i) % ysize)->CopySaveData(*vs);
 			}
+			index += repeat;
 		}
 	}
 	if (version == 0 || ldr.IsFail()) this->MakeFlatWorld(8);
+	this->NotifyChange();
+}
+
+/**
+ * Save voxel stacks in the order of the world (the y coordinate running fastest), with identical consecutive stacks saved once.
+ * @tparam GetStack Type of the function to get a voxel stack.
+ * @param svr Output stream to save to.
+ * @param count Number of voxel stacks to save.
+ * @param get_stack Function that returns the stack with the given index in saving order, for a slot (\c 0 or \c 1).
+ *                  The stack returned for slot \c 0 must stay valid while getting stacks for slot \c 1.
+ */
+template <typename GetStack>
+static void SaveVoxelStacks(Saver &svr, uint count, GetStack get_stack)
+{
+	uint index = 0;
+	while (index < count) {
+		const VoxelStack *vs = get_stack(index, 0);
+		uint repeat = 1;
+		while (repeat < 0xFFFF && index + repeat < count && vs->HasSameSaveData(*get_stack(index + repeat, 1))) repeat++;
+		vs->Save(svr, repeat);
+		index += repeat;
+	}
 }
 
 /**
@@ -630,12 +753,90 @@ void VoxelWorld::Save(Saver &svr) const
 	svr.PutWord(this->GetXSize());
 	svr.PutWord(this->GetYSize());
 	svr.EndBlock();
-	for (uint16 x = 0; x < this->GetXSize(); x++) {
-		for (uint16 y = 0; y < this->GetYSize(); y++) {
-			const VoxelStack *vs = this->GetStack(x, y);
-			vs->Save(svr);
-		}
-	}
+
+	uint16 ysize = this->GetYSize();
+	SaveVoxelStacks(svr, this->GetXSize() * ysize, [this, ysize](uint index, int slot) {
+		return this->GetStack(index / ysize, index % ysize);
+	});
+}
+
+/**
+ * Take a snapshot of the voxel stacks of the world, for saving them while the game continues.
+ * @return The snapshot, which stays valid until #EndSnapshot.
+ * @pre No snapshot exists.
+ */
+WorldSnapshot *VoxelWorld::StartSnapshot()
+{
+	assert(this->snapshot == nullptr);
+	this->snapshot.reset(new WorldSnapshot(this->stacks, this->x_size, this->y_size));
+	return this->snapshot.get();
+}
+
+/** The snapshot of the world is not used any more, delete it. */
+void VoxelWorld::EndSnapshot()
+{
+	this->snapshot.reset();
+}
+
+/**
+ * Constructor of the snapshot of the world.
+ * @param stacks Voxel stacks of the world.
+ * @param x_size Length of the world in X direction.
+ * @param y_size Length of the world in Y direction.
+ */
+WorldSnapshot::WorldSnapshot(const VoxelStack *stacks, uint16 x_size, uint16 y_size) : copies(WORLD_X_SIZE * WORLD_Y_SIZE)
+{
+	this->stacks = stacks;
+	this->x_size = x_size;
+	this->y_size = y_size;
+}
+
+/**
+ * Copy a voxel stack of the world before it gets modified.
+ * @param index Index of the stack in the world.
+ * @param vs The voxel stack of the world.
+ */
+void WorldSnapshot::CopyStack(uint index, const VoxelStack &vs)
+{
+	std::unique_ptr<VoxelStack> copy(new VoxelStack);
+	copy->CopySaveData(vs);
+
+	std::lock_guard<std::mutex> guard(this->lock);
+	this->copies[index] = std::move(copy);
+}
+
+/**
+ * Get a voxel stack of the snapshot for saving it.
+ * @param index Index of the stack in saving order.
+ * @param slot Slot to use for a stack that is not modified (\c 0 or \c 1).
+ * @return The stack at the time of the snapshot.
+ */
+const VoxelStack *WorldSnapshot::GetSavedStack(uint index, int slot)
+{
+	uint pos = index / this->y_size + (index % this->y_size) * WORLD_X_SIZE;
+
+	/* Copied stacks do not change, stacks of the world are copied while holding the lock to prevent modifying them. */
+	std::lock_guard<std::mutex> guard(this->lock);
+	if (this->copies[pos] != nullptr) return this->copies[pos].get();
+	this->saving[slot].CopySaveData(this->stacks[pos]);
+	return &this->saving[slot];
+}
+
+/**
+ * Save the world as it was at the time of the snapshot. May be called from another thread than the one modifying the world.
+ * @param svr Output stream to save to.
+ * @note The saved data is the same as #VoxelWorld::Save would have saved at the time of the snapshot.
+ */
+void WorldSnapshot::Save(Saver &svr)
+{
+	svr.StartBlock("WRLD", 1);
+	svr.PutWord(this->x_size);
+	svr.PutWord(this->y_size);
+	svr.EndBlock();
+
+	SaveVoxelStacks(svr, this->x_size * this->y_size, [this](uint index, int slot) {
+		return this->GetSavedStack(index, slot);
+	});
 }
 
 WorldAdditions::WorldAdditions()
@@ -707,6 +908,6 @@ void WorldAdditions::MarkDirty(Viewport *vp)
 	for (const auto &iter : this->modified_stacks) {
 		const Point32 pt = iter.first;
 		const VoxelStack *vstack = iter.second;
-		if (vstack != nullptr) vp->MarkVoxelDirty(XYZPoint16(pt.x, pt.y, vstack->base), vstack->height);
+		if (vstack != nullptr) vp->MarkVoxelDirty(XYZPoint16(pt.x, pt.y, vstack->base), vstack->height, false); // The world itself is not changed.
 	}
 }
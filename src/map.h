@@ -19,6 +19,9 @@
 #include "bitmath.h"
 
 #include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 class Viewport;
 
@@ -303,6 +306,7 @@ public:
 
 	void Save(Saver &svr) const;
 	void Load(Loader &ldr, uint32 version);
+	bool HasSameSaveData(const Voxel &other) const;
 };
 
 /** Base class for (moving) objects that are stored at a voxel position for easy retrieval during drawing. */
@@ -315,6 +319,7 @@ public:
 	virtual ~VoxelObject();
 
 	virtual const ImageData *GetSprite(const SpriteStorage *sprites, ViewOrientation orient, const Recolouring **recolour) const = 0;
+	virtual XYZPoint16 GetRenderOffset(uint32 progress) const;
 
 	/**
 	 * Add itself to the voxel objects chain.
@@ -469,8 +474,10 @@ public:
 
 	int GetGroundOffset() const;
 
-	void Save(Saver &svr) const;
-	void Load(Loader &ldr);
+	void Save(Saver &svr, uint repeat) const;
+	uint Load(Loader &ldr);
+	bool HasSameSaveData(const VoxelStack &other) const;
+	void CopySaveData(const VoxelStack &other);
 
 	Voxel *voxels;   ///< %Voxel array at this stack.
 	int16 base;      ///< Height of the bottom voxel.
@@ -480,6 +487,40 @@ protected:
 	bool MakeVoxelStack(int16 new_base, uint16 new_height);
 };
 
+/**
+ * Copy-on-write copy of the voxel stacks of the world, for saving the world in the background while the game continues.
+ * The snapshot uses the stacks of the world, until a stack is about to be modified. At that moment the stack is copied into the snapshot.
+ * @ingroup map_group
+ */
+class WorldSnapshot {
+public:
+	WorldSnapshot(const VoxelStack *stacks, uint16 x_size, uint16 y_size);
+
+	/**
+	 * A voxel stack of the world is about to be modified, make sure the snapshot has a copy of it.
+	 * @param index Index of the stack in the world.
+	 * @param vs The voxel stack of the world.
+	 */
+	inline void PreserveStack(uint index, const VoxelStack &vs)
+	{
+		if (this->copies[index] == nullptr) this->CopyStack(index, vs);
+	}
+
+	void Save(Saver &svr);
+
+private:
+	void CopyStack(uint index, const VoxelStack &vs);
+	const VoxelStack *GetSavedStack(uint index, int slot);
+
+	const VoxelStack *stacks; ///< Voxel stacks of the world.
+	uint16 x_size;            ///< Length of the world in X direction at the time of the snapshot.
+	uint16 y_size;            ///< Length of the world in Y direction at the time of the snapshot.
+
+	std::mutex lock;                                 ///< Lock protecting #copies against adding a copy while the stack is being saved.
+	std::vector<std::unique_ptr<VoxelStack>> copies; ///< Copies of the modified stacks, indexed like the stacks of the world.
+	VoxelStack saving[2];                            ///< Copies of not modified stacks, for saving them.
+};
+
 /**
  * A world of voxels.
  * @ingroup map_group
@@ -504,6 +545,19 @@ public:
 	void MoveStack(uint16 x, uint16 y, VoxelStack *old_stack)
 	{
 		this->GetModifyStack(x, y)->MoveStack(old_stack);
+		this->NotifyChange(x, y);
+	}
+
+	void NotifyChange();
+	void NotifyChange(uint16 x, uint16 y);
+
+	/**
+	 * Get the number of visible changes of the world, to find out whether a cached display of the world is still valid.
+	 * @return Number of changes of the world since the start of the program.
+	 */
+	inline uint32 GetChangeCount() const
+	{
+		return this->change_count;
 	}
 
 	/**
@@ -567,9 +621,14 @@ public:
 	void Save(Saver &svr) const;
 	void Load(Loader &ldr);
 
+	WorldSnapshot *StartSnapshot();
+	void EndSnapshot();
+
 private:
 	uint16 x_size; ///< Current max x size (in voxels).
 	uint16 y_size; ///< Current max y size (in voxels).
+	uint32 change_count; ///< Number of visible changes of the world contents. @see NotifyChange
+	std::unique_ptr<WorldSnapshot> snapshot; ///< Snapshot of the world being saved, if any.
 
 	VoxelStack stacks[WORLD_X_SIZE * WORLD_Y_SIZE]; ///< All voxel stacks in the world.
 };
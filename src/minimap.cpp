@@ -0,0 +1,159 @@
+/* $Id$ */
+
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file minimap.cpp Small overview image of the park. */
+
+#include "stdafx.h"
+#include "minimap.h"
+#include "palette.h"
+#include "ride_type.h"
+
+Minimap _minimap; ///< Overview image of the park.
+
+Minimap::Minimap() : colours(WORLD_X_SIZE * WORLD_Y_SIZE, 0), guests(WORLD_X_SIZE * WORLD_Y_SIZE, 0), dirty(WORLD_X_SIZE * WORLD_Y_SIZE, false)
+{
+	this->all_dirty = true;
+	this->change_count = 0;
+}
+
+/**
+ * Notify that the contents of a tile changed.
+ * @param x X coordinate of the tile.
+ * @param y Y coordinate of the tile.
+ */
+void Minimap::MarkTileDirty(uint16 x, uint16 y)
+{
+	if (x >= WORLD_X_SIZE || y >= WORLD_Y_SIZE) return;
+
+	this->change_count++;
+	if (this->all_dirty) return;
+
+	uint16 index = x + y * WORLD_X_SIZE;
+	if (this->dirty[index]) return;
+	this->dirty[index] = true;
+	this->dirty_tiles.push_back(index);
+}
+
+/** Notify that the contents of (possibly) every tile changed. */
+void Minimap::MarkAllDirty()
+{
+	this->change_count++;
+	this->all_dirty = true;
+}
+
+/**
+ * Get the colour of a ride at the minimap.
+ * @param kind Kind of the ride.
+ * @return Colour of the ride.
+ */
+static uint32 GetRideColour(RideTypeKind kind)
+{
+	switch (kind) {
+		case RTK_SHOP:    return MakeRGBA(230, 140,  40, OPAQUE);
+		case RTK_GENTLE:  return MakeRGBA(200,  70, 200, OPAQUE);
+		case RTK_WET:     return MakeRGBA( 60, 110, 230, OPAQUE);
+		case RTK_COASTER: return MakeRGBA(220,  40,  40, OPAQUE);
+		default:          return MakeRGBA(200, 200, 200, OPAQUE);
+	}
+}
+
+/**
+ * Compute the colour of a tile, from the highest voxel with visible contents.
+ * Higher ground is drawn lighter, tiles not owned by the park are drawn darker.
+ * @param vs %Voxel stack of the tile.
+ * @return Colour of the tile.
+ */
+static uint32 ComputeTileColour(const VoxelStack *vs)
+{
+	uint32 colour = MakeRGBA(0, 0, 0, OPAQUE);
+	int16 z = vs->base + vs->height - 1;
+	for (; z >= vs->base; z--) {
+		const Voxel *v = vs->Get(z);
+		SmallRideInstance number = v->GetInstance();
+		if (number >= SRI_FULL_RIDES) {
+			const RideInstance *ri = _rides_manager.GetRideInstance(number);
+			if (ri != nullptr) {
+				colour = GetRideColour(ri->GetKind());
+				break;
+			}
+		} else if (number >= SRI_SAME_AS_NORTH && number <= SRI_SAME_AS_SOUTH) {
+			colour = GetRideColour(RTK_RIDE_KIND_COUNT);
+			break;
+		} else if (HasValidPath(v)) {
+			colour = MakeRGBA(150, 150, 150, OPAQUE);
+			break;
+		}
+
+		uint8 ground = v->GetGroundType();
+		if (ground == GTP_DESERT) {
+			colour = MakeRGBA(220, 200, 120, OPAQUE);
+			break;
+		} else if (ground == GTP_UNDERGROUND) {
+			colour = MakeRGBA(120, 90, 60, OPAQUE);
+			break;
+		} else if (ground != GTP_INVALID) {
+			colour = MakeRGBA(60, 150, 50, OPAQUE);
+			break;
+		}
+	}
+
+	int scale = 176 + std::min(std::max(z, (int16)0), (int16)20) * 4; // Out of 256.
+	if (vs->owner != OWN_PARK) scale /= 2;
+	return MakeRGBA(GetR(colour) * scale / 256, GetG(colour) * scale / 256, GetB(colour) * scale / 256, OPAQUE);
+}
+
+/** Compute the colours of all tiles that changed since the previous call. */
+void Minimap::UpdateDirtyTiles()
+{
+	if (this->all_dirty) {
+		for (uint16 y = 0; y < _world.GetYSize(); y++) {
+			for (uint16 x = 0; x < _world.GetXSize(); x++) {
+				this->colours[x + y * WORLD_X_SIZE] = ComputeTileColour(_world.GetStack(x, y));
+			}
+		}
+		for (uint16 index : this->dirty_tiles) this->dirty[index] = false;
+		this->dirty_tiles.clear();
+		this->all_dirty = false;
+		return;
+	}
+
+	for (uint16 index : this->dirty_tiles) {
+		this->dirty[index] = false;
+		this->colours[index] = ComputeTileColour(_world.GetStack(index % WORLD_X_SIZE, index / WORLD_X_SIZE));
+	}
+	this->dirty_tiles.clear();
+}
+
+/**
+ * A guest arrived at a tile.
+ * @param x X coordinate of the tile.
+ * @param y Y coordinate of the tile.
+ */
+void Minimap::AddGuest(uint16 x, uint16 y)
+{
+	if (x >= WORLD_X_SIZE || y >= WORLD_Y_SIZE) return;
+
+	uint16 &count = this->guests[x + y * WORLD_X_SIZE];
+	if (count < 0xFFFF) count++;
+	this->change_count++;
+}
+
+/**
+ * A guest left a tile.
+ * @param x X coordinate of the tile.
+ * @param y Y coordinate of the tile.
+ */
+void Minimap::RemoveGuest(uint16 x, uint16 y)
+{
+	if (x >= WORLD_X_SIZE || y >= WORLD_Y_SIZE) return;
+
+	uint16 &count = this->guests[x + y * WORLD_X_SIZE];
+	if (count > 0) count--;
+	this->change_count++;
+}
@@ -0,0 +1,79 @@
+/* $Id$ */
+
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file minimap.h Small overview image of the park. */
+
+#ifndef MINIMAP_H
+#define MINIMAP_H
+
+#include "map.h"
+#include <vector>
+
+static const uint32 MINIMAP_UPDATE_INTERVAL = 10; ///< Number of frames between two updates of the minimap window.
+
+/**
+ * Overview of the park with one pixel per tile, and the number of guests at each tile.
+ * The world and the guests report their changes, only changed tiles are computed again.
+ */
+class Minimap {
+public:
+	Minimap();
+
+	void MarkTileDirty(uint16 x, uint16 y);
+	void MarkAllDirty();
+	void UpdateDirtyTiles();
+
+	void AddGuest(uint16 x, uint16 y);
+	void RemoveGuest(uint16 x, uint16 y);
+
+	/**
+	 * Get the colour of a tile.
+	 * @param x X coordinate of the tile.
+	 * @param y Y coordinate of the tile.
+	 * @return Colour of the tile at the time of the last #UpdateDirtyTiles call.
+	 */
+	inline uint32 GetColour(uint16 x, uint16 y) const
+	{
+		return this->colours[x + y * WORLD_X_SIZE];
+	}
+
+	/**
+	 * Get the number of guests at a tile.
+	 * @param x X coordinate of the tile.
+	 * @param y Y coordinate of the tile.
+	 * @return Number of guests at the tile.
+	 */
+	inline uint16 GetGuestCount(uint16 x, uint16 y) const
+	{
+		return this->guests[x + y * WORLD_X_SIZE];
+	}
+
+	/**
+	 * Get the number of changes of the minimap, to find out whether a displayed minimap is still valid.
+	 * @return Number of changes of the tiles or the guests since the start of the program.
+	 */
+	inline uint32 GetChangeCount() const
+	{
+		return this->change_count;
+	}
+
+private:
+	std::vector<uint32> colours;     ///< Colour of each tile, indexed like the voxel stacks of the world.
+	std::vector<uint16> guests;      ///< Number of guests at each tile, indexed like the voxel stacks of the world.
+	std::vector<bool> dirty;         ///< For each tile, whether its colour must be computed again.
+	std::vector<uint16> dirty_tiles; ///< Indices of the tiles that have their #dirty flag set.
+	bool all_dirty;                  ///< All tiles must be computed again (#dirty and #dirty_tiles are not used).
+	uint32 change_count;             ///< Number of changes of the minimap. @see GetChangeCount
+};
+
+extern Minimap _minimap;
+
+void ShowMinimapGui();
+
+#endif
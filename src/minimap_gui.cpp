@@ -0,0 +1,295 @@
+/* $Id$ */
+
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file minimap_gui.cpp Window displaying an overview of the park. */
+
+#include "stdafx.h"
+#include "minimap.h"
+#include "window.h"
+#include "viewport.h"
+#include "video.h"
+#include "palette.h"
+
+/**
+ * Window displaying the #Minimap. Tiles are drawn as 2x1 pixels, in the orientation of the main display.
+ * Clicking in the map moves the main display to the clicked tile.
+ * @ingroup gui_group
+ */
+class MinimapGui : public GuiWindow {
+public:
+	MinimapGui();
+
+	void UpdateWidgetSize(WidgetNumber wid_num, BaseWidget *wid) override;
+	void OnDraw() override;
+	void DrawWidget(WidgetNumber wid_num, const BaseWidget *wid) const override;
+	void OnClick(WidgetNumber wid_num, const Point16 &pos) override;
+	void OnChange(ChangeCode code, uint32 parameter) override;
+
+private:
+	uint32 drawn_count;                ///< Change count of the #_minimap when the map was last marked for drawing.
+	XYZPoint32 drawn_view_pos;         ///< Position of the main display when the map was last marked for drawing.
+	ViewOrientation drawn_orientation; ///< Orientation of the main display when the map was last marked for drawing.
+	uint16 drawn_tile_width;           ///< Tile width of the main display when the map was last marked for drawing.
+};
+
+/**
+ * Widget numbers of the minimap GUI.
+ * @ingroup gui_group
+ */
+enum MinimapWidgets {
+	MM_GUI_MAP,    ///< The map itself.
+	MM_GUI_GUESTS, ///< Button to toggle display of the guests.
+};
+
+/** Widget parts of the #MinimapGui window. */
+static const WidgetPart _minimap_gui_parts[] = {
+	Intermediate(0, 1),
+		Intermediate(1, 0),
+			Widget(WT_TITLEBAR, INVALID_WIDGET_INDEX, COL_RANGE_GREEN), SetData(GUI_MINIMAP_TITLE, GUI_TITLEBAR_TIP),
+			Widget(WT_CLOSEBOX, INVALID_WIDGET_INDEX, COL_RANGE_GREEN),
+		EndContainer(),
+		Widget(WT_PANEL, INVALID_WIDGET_INDEX, COL_RANGE_GREEN),
+			Intermediate(2, 1),
+				Widget(WT_EMPTY, MM_GUI_MAP, COL_RANGE_GREEN),
+				Widget(WT_TEXT_BUTTON, MM_GUI_GUESTS, COL_RANGE_GREEN),
+						SetData(GUI_MINIMAP_GUESTS, GUI_MINIMAP_GUESTS_TOOLTIP), SetPadding(3, 3, 3, 3),
+			EndContainer(),
+	EndContainer(),
+};
+
+/**
+ * Get the length of the first minimap axis in the given orientation.
+ * @param orient Direction of view.
+ * @return Number of tiles along the first axis.
+ * @see WorldToMinimapAxes
+ */
+static int32 GetFirstAxisLength(ViewOrientation orient)
+{
+	return (orient == VOR_NORTH || orient == VOR_SOUTH) ? _world.GetXSize() : _world.GetYSize();
+}
+
+/**
+ * Convert a world position to the axes of the minimap. The first axis goes down to the left at the screen, the second
+ * axis goes down to the right.
+ * @param orient Direction of view.
+ * @param xpos X position in the world, in 1/256 of a tile.
+ * @param ypos Y position in the world, in 1/256 of a tile.
+ * @param apos [out] Position along the first axis, in 1/256 of a tile.
+ * @param bpos [out] Position along the second axis, in 1/256 of a tile.
+ */
+static void WorldToMinimapAxes(ViewOrientation orient, int32 xpos, int32 ypos, int32 *apos, int32 *bpos)
+{
+	int32 xmax = _world.GetXSize() * 256 - 1;
+	int32 ymax = _world.GetYSize() * 256 - 1;
+	switch (orient) {
+		case VOR_NORTH: *apos = xpos;        *bpos = ypos;        break;
+		case VOR_EAST:  *apos = ymax - ypos; *bpos = xpos;        break;
+		case VOR_SOUTH: *apos = xmax - xpos; *bpos = ymax - ypos; break;
+		case VOR_WEST:  *apos = ypos;        *bpos = xmax - xpos; break;
+		default: NOT_REACHED();
+	}
+}
+
+/**
+ * Convert a tile at the axes of the minimap back to a world tile.
+ * @param orient Direction of view.
+ * @param apos Tile position along the first axis.
+ * @param bpos Tile position along the second axis.
+ * @return Tile in the world.
+ * @see WorldToMinimapAxes
+ */
+static Point16 MinimapAxesToWorld(ViewOrientation orient, int32 apos, int32 bpos)
+{
+	int32 xmax = _world.GetXSize() - 1;
+	int32 ymax = _world.GetYSize() - 1;
+	switch (orient) {
+		case VOR_NORTH: return Point16(apos, bpos);
+		case VOR_EAST:  return Point16(bpos, ymax - apos);
+		case VOR_SOUTH: return Point16(xmax - apos, ymax - bpos);
+		case VOR_WEST:  return Point16(xmax - bpos, apos);
+		default: NOT_REACHED();
+	}
+}
+
+/**
+ * Get the offset of the map in the map widget, to centre the map if the widget is bigger.
+ * @param wid Map widget.
+ * @return Position of the top-left corner of the map, relative to the widget.
+ */
+static Point16 GetMapOffset(const BaseWidget *wid)
+{
+	int map_size = _world.GetXSize() + _world.GetYSize();
+	return Point16(std::max(0, (wid->pos.width - map_size) / 2), std::max(0, (wid->pos.height - map_size + 1) / 2));
+}
+
+/**
+ * Mix the colour of a tile with the colour of the guests.
+ * @param colour Colour of the tile.
+ * @param count Number of guests at the tile.
+ * @return Displayed colour of the tile.
+ */
+static uint32 AddGuestColour(uint32 colour, uint16 count)
+{
+	if (count == 0) return colour;
+
+	int amount = std::min(128 + count * 32, 256); // Out of 256.
+	int red = (GetR(colour) * (256 - amount) + 255 * amount) / 256;
+	int green = (GetG(colour) * (256 - amount) + 40 * amount) / 256;
+	int blue = (GetB(colour) * (256 - amount) + 40 * amount) / 256;
+	return MakeRGBA(red, green, blue, OPAQUE);
+}
+
+MinimapGui::MinimapGui() : GuiWindow(WC_MINIMAP, ALL_WINDOWS_OF_TYPE)
+{
+	this->drawn_count = _minimap.GetChangeCount();
+	this->drawn_view_pos = XYZPoint32(0, 0, 0);
+	this->drawn_orientation = VOR_INVALID;
+	this->drawn_tile_width = 0;
+	this->SetupWidgetTree(_minimap_gui_parts, lengthof(_minimap_gui_parts));
+}
+
+void MinimapGui::UpdateWidgetSize(WidgetNumber wid_num, BaseWidget *wid)
+{
+	if (wid_num != MM_GUI_MAP) return;
+
+	wid->min_x = _world.GetXSize() + _world.GetYSize();
+	wid->min_y = _world.GetXSize() + _world.GetYSize() - 1;
+}
+
+void MinimapGui::OnDraw()
+{
+	_minimap.UpdateDirtyTiles(); // Compute the colours of the changed tiles before the map is drawn.
+	GuiWindow::OnDraw();
+}
+
+void MinimapGui::DrawWidget(WidgetNumber wid_num, const BaseWidget *wid) const
+{
+	if (wid_num != MM_GUI_MAP) return;
+
+	int wid_left = this->GetWidgetScreenX(wid);
+	int wid_top = this->GetWidgetScreenY(wid);
+	_video.FillRectangle(Rectangle32(wid_left, wid_top, wid->pos.width, wid->pos.height), MakeRGBA(0, 0, 0, OPAQUE));
+
+	ClippedRectangle cr = _video.GetClippedRectangle();
+	/* Clip to both the widget and the drawing area. */
+	int min_x = std::max(wid_left, 0);
+	int min_y = std::max(wid_top, 0);
+	int max_x = std::min(wid_left + wid->pos.width, (int)cr.width);
+	int max_y = std::min(wid_top + wid->pos.height, (int)cr.height);
+	auto set_pixel = [&](int x, int y, uint32 colour) {
+		if (x < min_x || x >= max_x || y < min_y || y >= max_y) return;
+		cr.address[x + y * cr.pitch] = colour;
+	};
+
+	Point16 offset = GetMapOffset(wid);
+	int left = wid_left + offset.x;
+	int top = wid_top + offset.y;
+
+	Viewport *vp = GetViewport();
+	ViewOrientation orient = (vp != nullptr) ? vp->orientation : VOR_NORTH;
+	int32 first_length = GetFirstAxisLength(orient);
+	bool show_guests = this->IsWidgetPressed(MM_GUI_GUESTS);
+	for (uint16 y = 0; y < _world.GetYSize(); y++) {
+		for (uint16 x = 0; x < _world.GetXSize(); x++) {
+			int32 apos, bpos;
+			WorldToMinimapAxes(orient, x * 256, y * 256, &apos, &bpos);
+			apos /= 256;
+			bpos /= 256;
+			int col = left + bpos - apos + first_length - 1;
+			int row = top + apos + bpos;
+
+			uint32 colour = _minimap.GetColour(x, y);
+			if (show_guests) colour = AddGuestColour(colour, _minimap.GetGuestCount(x, y));
+			set_pixel(col, row, colour);
+			set_pixel(col + 1, row, colour);
+		}
+	}
+
+	/* Outline of the area displayed in the main display. */
+	if (vp == nullptr || vp->tile_width == 0) return;
+	int32 apos, bpos;
+	WorldToMinimapAxes(orient, vp->view_pos.x, vp->view_pos.y, &apos, &bpos);
+	int centre_x = left + (bpos - apos) / 256 + first_length;
+	int centre_y = top + (apos + bpos - 128) / 256;
+	int width = vp->rect.width * 2 / vp->tile_width;
+	int height = vp->rect.height * 4 / vp->tile_width;
+	int x0 = centre_x - width / 2;
+	int y0 = centre_y - height / 2;
+	uint32 colour = MakeRGBA(255, 255, 255, OPAQUE);
+	for (int i = 0; i < width; i++) {
+		set_pixel(x0 + i, y0, colour);
+		set_pixel(x0 + i, y0 + height - 1, colour);
+	}
+	for (int i = 0; i < height; i++) {
+		set_pixel(x0, y0 + i, colour);
+		set_pixel(x0 + width - 1, y0 + i, colour);
+	}
+}
+
+void MinimapGui::OnClick(WidgetNumber wid_num, const Point16 &pos)
+{
+	switch (wid_num) {
+		case MM_GUI_GUESTS:
+			this->SetWidgetPressed(MM_GUI_GUESTS, !this->IsWidgetPressed(MM_GUI_GUESTS));
+			this->MarkWidgetDirty(MM_GUI_MAP);
+			break;
+
+		case MM_GUI_MAP: {
+			Viewport *vp = GetViewport();
+			if (vp == nullptr) return;
+
+			/* Tiles of a row start at every other column, and cover two columns. */
+			Point16 offset = GetMapOffset(this->GetWidget<BaseWidget>(MM_GUI_MAP));
+			int32 first_length = GetFirstAxisLength(vp->orientation);
+			int32 col = pos.x - offset.x;
+			int32 row = pos.y - offset.y;
+			if (((col - row - (first_length - 1)) & 1) != 0) col--;
+			int32 apos = (first_length - 1 - (col - row)) / 2;
+			int32 bpos = row - apos;
+			int32 second_length = _world.GetXSize() + _world.GetYSize() - first_length;
+			if (apos < 0 || apos >= first_length || bpos < 0 || bpos >= second_length) return;
+
+			Point16 tile = MinimapAxesToWorld(vp->orientation, apos, bpos);
+			vp->view_pos.x = tile.x * 256 + 128;
+			vp->view_pos.y = tile.y * 256 + 128;
+			vp->view_pos.z = _world.GetGroundHeight(tile.x, tile.y) * 256;
+			vp->MarkDirty();
+			this->MarkWidgetDirty(MM_GUI_MAP);
+			break;
+		}
+
+		default:
+			break;
+	}
+}
+
+void MinimapGui::OnChange(ChangeCode code, uint32 parameter)
+{
+	if (code != CHG_DISPLAY_OLD) return;
+
+	const Viewport *vp = GetViewport();
+	if (vp == nullptr) return;
+	if (this->drawn_count == _minimap.GetChangeCount() && this->drawn_view_pos == vp->view_pos &&
+			this->drawn_orientation == vp->orientation && this->drawn_tile_width == vp->tile_width) {
+		return;
+	}
+
+	this->drawn_count = _minimap.GetChangeCount();
+	this->drawn_view_pos = vp->view_pos;
+	this->drawn_orientation = vp->orientation;
+	this->drawn_tile_width = vp->tile_width;
+	this->MarkWidgetDirty(MM_GUI_MAP);
+}
+
+/** Open the minimap window (or if it is already opened, highlight and raise it). */
+void ShowMinimapGui()
+{
+	if (HighlightWindowByType(WC_MINIMAP, ALL_WINDOWS_OF_TYPE)) return;
+	new MinimapGui;
+}
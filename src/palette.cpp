@@ -168,6 +168,41 @@ void Recolouring::AssignRandomColours()
 	}
 }
 
+/**
+ * Load the recolour entries from the save game.
+ * @param ldr Input stream to load from.
+ */
+void Recolouring::Load(Loader &ldr)
+{
+	for (int i = 0; i < MAX_RECOLOUR; i++) {
+		RecolourEntry re;
+		uint8 source = ldr.GetByte();
+		uint8 dest = ldr.GetByte();
+		re.dest_set = ldr.GetLong();
+		if ((source >= COL_RANGE_COUNT && source != COL_RANGE_INVALID) || (dest >= COL_RANGE_COUNT && dest != COL_RANGE_INVALID)) {
+			ldr.SetFailMessage("Incorrect colour range");
+			source = COL_RANGE_INVALID;
+			dest = COL_RANGE_INVALID;
+		}
+		re.source = (ColourRange)source;
+		re.dest = (ColourRange)dest;
+		this->Set(i, re);
+	}
+}
+
+/**
+ * Save the recolour entries to the save game.
+ * @param svr Output stream to save to.
+ */
+void Recolouring::Save(Saver &svr) const
+{
+	for (const RecolourEntry &re : this->entries) {
+		svr.PutByte(re.source);
+		svr.PutByte(re.dest);
+		svr.PutLong(re.dest_set);
+	}
+}
+
 /**
  * Compute the palette of the #Recolouring object from the #entries and the gradient shift.
  * @param shift Applied gradient shift.
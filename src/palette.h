@@ -306,6 +306,9 @@ public:
 	void Set(int index, const RecolourEntry &entry);
 	void AssignRandomColours();
 
+	void Load(Loader &ldr);
+	void Save(Saver &svr) const;
+
 	const uint8 *GetPalette(GradientShift shift) const;
 
 	/**
@@ -0,0 +1,215 @@
+/* $Id$ */
+
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file park_render.cpp Rendering the entire park off-screen, for screenshots and measuring the drawing speed. */
+
+#include "stdafx.h"
+#include "park_render.h"
+#include "viewport.h"
+#include "video.h"
+#include "palette.h"
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <png.h>
+
+/** Names of the view orientations, as used at the command line. */
+static const char *_orientation_names[VOR_NUM_ORIENT] = {
+	"north",
+	"east",
+	"south",
+	"west",
+};
+
+/**
+ * Write an image to a PNG file. The alpha channel of the pixels is not written.
+ * @param fname Name of the file to write.
+ * @param pixels Pixels of the image, row by row.
+ * @param width Width of the image in pixels.
+ * @param height Height of the image in pixels.
+ * @return Whether the file was written successfully.
+ */
+bool SavePngImage(const char *fname, const uint32 *pixels, uint32 width, uint32 height)
+{
+	FILE *fp = fopen(fname, "wb");
+	if (fp == nullptr) return false;
+
+	png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+	if (!png_ptr) {
+		fclose(fp);
+		return false;
+	}
+
+	png_infop info_ptr = png_create_info_struct(png_ptr);
+	if (!info_ptr) {
+		png_destroy_write_struct(&png_ptr, (png_infopp)nullptr);
+		fclose(fp);
+		return false;
+	}
+
+	std::vector<uint8> row(width * 3);
+	if (setjmp(png_jmpbuf(png_ptr))) {
+		png_destroy_write_struct(&png_ptr, &info_ptr);
+		fclose(fp);
+		return false;
+	}
+
+	png_init_io(png_ptr, fp);
+	png_set_IHDR(png_ptr, info_ptr, width, height, 8, PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+	png_write_info(png_ptr, info_ptr);
+	for (uint32 y = 0; y < height; y++) {
+		const uint32 *src = pixels + (size_t)y * width;
+		for (uint32 x = 0; x < width; x++) {
+			row[x * 3]     = GetR(src[x]);
+			row[x * 3 + 1] = GetG(src[x]);
+			row[x * 3 + 2] = GetB(src[x]);
+		}
+		png_write_row(png_ptr, row.data());
+	}
+	png_write_end(png_ptr, nullptr);
+	png_destroy_write_struct(&png_ptr, &info_ptr);
+
+	return fclose(fp) == 0;
+}
+
+/**
+ * Find the view orientation with a given name.
+ * @param text Name of the orientation (\c "north", \c "east", \c "south", \c "west"), or \c "all".
+ * @param orient [out] Orientation with the given name, #VOR_NUM_ORIENT for \c "all".
+ * @return Whether the name is a known orientation.
+ */
+bool GetRenderOrientationFromText(const char *text, ViewOrientation *orient)
+{
+	if (strcmp(text, "all") == 0) {
+		*orient = VOR_NUM_ORIENT;
+		return true;
+	}
+	for (int i = 0; i < VOR_NUM_ORIENT; i++) {
+		if (strcmp(text, _orientation_names[i]) == 0) {
+			*orient = (ViewOrientation)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Get the name of the image file of an orientation, when rendering all orientations.
+ * @param fname Name of the file given by the user.
+ * @param orient Orientation of the image.
+ * @return Name of the file with the name of the orientation inserted before the extension.
+ */
+static std::string GetOrientationFileName(const char *fname, ViewOrientation orient)
+{
+	std::string name = fname;
+	size_t dot = name.find_last_of('.');
+	size_t sep = name.find_last_of("/\\");
+	if (dot == std::string::npos || (sep != std::string::npos && dot < sep)) dot = name.size();
+
+	name.insert(dot, std::string("-") + _orientation_names[orient]);
+	return name;
+}
+
+/**
+ * Render the current park off-screen, and write it to a PNG file and/or print how fast it was drawn.
+ * @param fname Name of the PNG file to write, \c nullptr to not write an image.
+ *              When rendering all orientations, the name of the orientation is inserted before the extension of the file name.
+ * @param orient Direction of view, #VOR_NUM_ORIENT renders the park in all four directions.
+ * @param tile_width Width of a voxel tile in pixels, which selects the zoom level.
+ * @param repeat Number of times to render the park in each direction for measuring the speed, \c 0 renders it once without measuring.
+ * @return Exit code of the program.
+ */
+int RunParkRenderer(const char *fname, ViewOrientation orient, uint16 tile_width, int repeat)
+{
+	int first = (orient == VOR_NUM_ORIENT) ? VOR_NORTH : orient;
+	int last = (orient == VOR_NUM_ORIENT) ? VOR_WEST : orient;
+
+	WorldImage image;
+	for (int vor = first; vor <= last; vor++) {
+		int64 total_time = 0; // In microseconds.
+		for (int i = 0; i < std::max(repeat, 1); i++) {
+			auto start = std::chrono::steady_clock::now();
+			if (!RenderWorld((ViewOrientation)vor, tile_width, &image)) {
+				fprintf(stderr, "ERROR: No sprites available with a tile width of %u pixels\n", tile_width);
+				return 1;
+			}
+			total_time += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+		}
+		if (image.width == 0) {
+			fprintf(stderr, "ERROR: The park has nothing to draw\n");
+			return 1;
+		}
+
+		if (repeat > 0) {
+			double seconds = std::max(total_time, (int64)1) / 1000000.0;
+			double pixels = (double)image.width * image.height;
+			printf("%-5s: %ux%u pixels in %u tiles, %llu sprites, %.2f ms per image, %.0f sprites/s, %.1f Mpixels/s\n",
+					_orientation_names[vor], image.width, image.height, image.tile_count, (unsigned long long)image.sprite_count,
+					total_time / 1000.0 / repeat, image.sprite_count * repeat / seconds, pixels * repeat / seconds / 1000000.0);
+		}
+
+		if (fname != nullptr) {
+			std::string name = (orient == VOR_NUM_ORIENT) ? GetOrientationFileName(fname, (ViewOrientation)vor) : fname;
+			if (!SavePngImage(name.c_str(), image.pixels.data(), image.width, image.height)) {
+				fprintf(stderr, "ERROR: Cannot write the image file \"%s\"\n", name.c_str());
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+/**
+ * Render the current park off-screen both in bands with several threads and sprite by sprite in one thread, and check that the pixels are the same.
+ * The bands are drawn from the decoded sprites of the sprite cache, the reference image is drawn with the sprite cache disabled,
+ * so it uses the blitters that decode the sprites while drawing.
+ * @param orient Direction of view, #VOR_NUM_ORIENT checks the park in all four directions.
+ * @param tile_width Width of a voxel tile in pixels, which selects the zoom level.
+ * @return Exit code of the program.
+ */
+int RunBandCheck(ViewOrientation orient, uint16 tile_width)
+{
+	int first = (orient == VOR_NUM_ORIENT) ? VOR_NORTH : orient;
+	int last = (orient == VOR_NUM_ORIENT) ? VOR_WEST : orient;
+
+	size_t cache_budget = _video.sprite_cache.GetBudget();
+	WorldImage banded;
+	WorldImage serial;
+	for (int vor = first; vor <= last; vor++) {
+		_video.sprite_cache.SetBudget((cache_budget > 0) ? cache_budget : DEFAULT_SPRITE_CACHE_SIZE); // Drawing in bands needs the sprite cache.
+		bool drawn = RenderWorld((ViewOrientation)vor, tile_width, &banded, true);
+		_video.sprite_cache.SetBudget(0);
+		drawn = drawn && RenderWorld((ViewOrientation)vor, tile_width, &serial, false);
+		_video.sprite_cache.SetBudget(cache_budget);
+		if (!drawn) {
+			fprintf(stderr, "ERROR: No sprites available with a tile width of %u pixels\n", tile_width);
+			return 1;
+		}
+		if (banded.width > 0 && banded.banded_tile_count == 0) {
+			fprintf(stderr, "ERROR: %s: The park could not be drawn in bands\n", _orientation_names[vor]);
+			return 1;
+		}
+		if (banded.width != serial.width || banded.height != serial.height) {
+			fprintf(stderr, "ERROR: %s: Banded image has %ux%u pixels, serial image has %ux%u pixels\n", _orientation_names[vor],
+					banded.width, banded.height, serial.width, serial.height);
+			return 1;
+		}
+
+		auto diff = std::mismatch(banded.pixels.begin(), banded.pixels.end(), serial.pixels.begin());
+		if (diff.first != banded.pixels.end()) {
+			size_t index = diff.first - banded.pixels.begin();
+			fprintf(stderr, "ERROR: %s: Banded image differs from the serial image at pixel (%u, %u)\n", _orientation_names[vor],
+					(uint)(index % banded.width), (uint)(index / banded.width));
+			return 1;
+		}
+		printf("%-5s: %ux%u pixels in %u tiles (%u drawn in bands), banded and serial images are the same\n", _orientation_names[vor],
+				banded.width, banded.height, banded.tile_count, banded.banded_tile_count);
+	}
+	return 0;
+}
@@ -0,0 +1,22 @@
+/* $Id$ */
+
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file park_render.h Rendering the entire park off-screen, for screenshots and measuring the drawing speed. */
+
+#ifndef PARK_RENDER_H
+#define PARK_RENDER_H
+
+#include "orientation.h"
+
+bool SavePngImage(const char *fname, const uint32 *pixels, uint32 width, uint32 height);
+bool GetRenderOrientationFromText(const char *text, ViewOrientation *orient);
+int RunParkRenderer(const char *fname, ViewOrientation orient, uint16 tile_width, int repeat);
+int RunBandCheck(ViewOrientation orient, uint16 tile_width);
+
+#endif
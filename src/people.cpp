@@ -19,6 +19,7 @@
 #include "person.h"
 #include "people.h"
 #include "gamelevel.h"
+#include "profiler.h"
 
 Guests _guests; ///< %Guests in the world/park.
 
@@ -130,6 +131,7 @@ uint Guests::CountActiveGuests()
  */
 void Guests::OnAnimate(int delay)
 {
+	PROFILE_SCOPE(PFS_GUESTS_ANIMATE);
 	for (int i = 0; i < GUEST_BLOCK_SIZE; i++) {
 		Guest *p = this->block.Get(i);
 		if (!p->IsActive()) continue;
@@ -138,6 +140,8 @@ void Guests::OnAnimate(int delay)
 		if (ar != OAR_OK) {
 			p->DeActivate(ar);
 			this->AddFree(p);
+		} else {
+			p->UpdateMinimapTile();
 		}
 	}
 }
@@ -196,6 +200,86 @@ void Guests::NotifyRideDeletion(const RideInstance *ri) {
 	}
 }
 
+/** Remove all guests from the park, for example before loading a saved game. */
+void Guests::RemoveAllGuests()
+{
+	for (int i = 0; i < GUEST_BLOCK_SIZE; i++) {
+		Guest *p = this->block.Get(i);
+		if (!p->IsActive()) continue;
+
+		p->DeActivate(p->added ? OAR_REMOVE : OAR_DEACTIVATE); // Guests in a ride are not in a voxel.
+	}
+	this->free_idx = 0;
+	this->daily_frac = 0;
+	this->next_daily_index = 0;
+	this->start_voxel.x = -1;
+	this->start_voxel.y = -1;
+}
+
+/**
+ * Load the guests from the save game.
+ * The guests are stored as fixed size records, only the active guests are saved.
+ * @param ldr Input stream to load from.
+ * @note The world and the rides should be loaded already.
+ * @pre No guests are active, see #RemoveAllGuests.
+ */
+void Guests::Load(Loader &ldr)
+{
+	uint32 version = ldr.OpenBlock("GSTS");
+	if (version == 1) {
+		this->start_voxel.x = ldr.GetWord();
+		this->start_voxel.y = ldr.GetWord();
+		this->free_idx = ldr.GetWord();
+		this->daily_frac = ldr.GetWord();
+		this->next_daily_index = ldr.GetWord();
+		if (this->free_idx > GUEST_BLOCK_SIZE || this->daily_frac > TICK_COUNT_PER_DAY || this->next_daily_index > GUEST_BLOCK_SIZE) {
+			ldr.SetFailMessage("Incorrect guest update position");
+		}
+
+		uint count = ldr.GetWord();
+		for (uint i = 0; i < count && !ldr.IsFail(); i++) {
+			uint index = ldr.GetWord();
+			if (index >= GUEST_BLOCK_SIZE || this->block.Get(index)->IsActive()) {
+				ldr.SetFailMessage("Incorrect guest number");
+				break;
+			}
+			this->block.Get(index)->Load(ldr);
+		}
+	} else if (version != 0) {
+		ldr.SetFailMessage("Unknown guests version");
+	}
+	ldr.CloseBlock();
+	if (ldr.IsFail()) this->free_idx = 0;
+}
+
+/**
+ * Save the guests to the save game.
+ * @param svr Output stream to save to.
+ */
+void Guests::Save(Saver &svr) const
+{
+	uint count = 0;
+	for (int i = 0; i < GUEST_BLOCK_SIZE; i++) {
+		if (this->block.Get(i)->IsActive()) count++;
+	}
+
+	svr.StartBlock("GSTS", 1);
+	svr.PutWord(this->start_voxel.x);
+	svr.PutWord(this->start_voxel.y);
+	svr.PutWord(this->free_idx);
+	svr.PutWord(this->daily_frac);
+	svr.PutWord(this->next_daily_index);
+	svr.PutWord(count);
+	for (int i = 0; i < GUEST_BLOCK_SIZE; i++) {
+		const Guest *g = this->block.Get(i);
+		if (!g->IsActive()) continue;
+
+		svr.PutWord(i);
+		g->Save(svr);
+	}
+	svr.EndBlock();
+}
+
 /**
  * Return whether there are still non-active guests.
  * @return \c true if there are non-active guests, else \c false.
@@ -93,6 +93,10 @@ public:
 	void OnNewDay();
 
 	void NotifyRideDeletion(const RideInstance *);
+	void RemoveAllGuests();
+
+	void Load(Loader &ldr);
+	void Save(Saver &svr) const;
 
 	Point16 start_voxel;  ///< Entry x/y coordinate of the voxel stack at the edge (negative X/Y coordinate means invalid).
 
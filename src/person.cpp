@@ -24,6 +24,7 @@
 #include "ride_type.h"
 #include "viewport.h"
 #include "weather.h"
+#include "minimap.h"
 
 static PersonTypeData _person_type_datas[PERSON_TYPE_COUNT]; ///< Data about each type of person.
 
@@ -96,6 +97,7 @@ Person::Person() : VoxelObject(), rnd()
 {
 	this->type = PERSON_INVALID;
 	this->name = nullptr;
+	this->minimap_tile = Point16(-1, -1);
 
 	this->offset = this->rnd.Uniform(100);
 }
@@ -112,6 +114,22 @@ const ImageData *Person::GetSprite(const SpriteStorage *sprites, ViewOrientation
 	return sprites->GetAnimationSprite(anim_type, this->frame_index, this->type, orient);
 }
 
+/**
+ * Get the offset of the person while walking, the movement of the current animation frame is spread over its duration.
+ * @param progress Number of milliseconds of game time since the last tick.
+ * @return Offset to add to the #pix_pos of the person.
+ */
+XYZPoint16 Person::GetRenderOffset(uint32 progress) const
+{
+	if (this->frames == nullptr || this->frame_index >= this->frame_count) return XYZPoint16(0, 0, 0);
+
+	const AnimationFrame &frame = this->frames[this->frame_index];
+	if (frame.duration == 0) return XYZPoint16(0, 0, 0);
+
+	int32 elapsed = Clamp<int32>(frame.duration - this->frame_time + (int32)progress, 0, frame.duration);
+	return XYZPoint16(frame.dx * elapsed / frame.duration, frame.dy * elapsed / frame.duration, 0);
+}
+
 /**
  * Set the name of a guest.
  * @param name New name of the guest.
@@ -203,6 +221,7 @@ void Person::Activate(const Point16 &start, PersonType person_type)
 		this->pix_pos.y = 255;
 	}
 	this->pix_pos.z = GetZHeight(this->vox_pos, this->pix_pos.x, this->pix_pos.y);
+	this->UpdateMinimapTile();
 
 	this->DecideMoveDirection();
 }
@@ -359,6 +378,45 @@ static const WalkInformation *_center_path_tile[4][4] = {
 	{_center_nw_ne, _center_nw_se, _center_nw_sw, _center_nw_nw},
 };
 
+/**
+ * Get the number of a walk sequence, for storing it in a saved game.
+ * @param walk Walk sequence of a person, pointing into #_walk_path_tile or #_center_path_tile.
+ * @return Number of the walk sequence, with the exit edge in bits 0-1, the start edge in bits 2-3,
+ *         the #_center_path_tile table in bit 4, and the position in the sequence in bits 8-15.
+ */
+static uint16 GetWalkNumber(const WalkInformation *walk)
+{
+	for (int table = 0; table < 2; table++) {
+		for (int start = 0; start < 4; start++) {
+			for (int exit = 0; exit < 4; exit++) {
+				const WalkInformation *seq = (table == 0) ? _walk_path_tile[start][exit] : _center_path_tile[start][exit];
+				for (int i = 0; seq[i].anim_type != ANIM_INVALID; i++) {
+					if (seq + i == walk) return (i << 8) | (table << 4) | (start << 2) | exit;
+				}
+			}
+		}
+	}
+	NOT_REACHED();
+}
+
+/**
+ * Get a walk sequence from its number in a saved game.
+ * @param number Number of the walk sequence.
+ * @return The walk sequence, or \c nullptr if the number is not valid.
+ * @see GetWalkNumber
+ */
+static const WalkInformation *GetWalkFromNumber(uint16 number)
+{
+	if ((number & 0xE0) != 0) return nullptr;
+	int start = GB(number, 2, 2);
+	int exit = GB(number, 0, 2);
+	const WalkInformation *seq = (GB(number, 4, 1) == 0) ? _walk_path_tile[start][exit] : _center_path_tile[start][exit];
+	for (int i = 0; seq[i].anim_type != ANIM_INVALID; i++) {
+		if (i == (number >> 8)) return seq + i;
+	}
+	return nullptr;
+}
+
 /**
  * Decide at which edge the person is.
  * @return Nearest edge of the person.
@@ -794,12 +852,93 @@ void Person::DeActivate(AnimateResult ar)
 		/* If not wandered off-world, remove the person from the voxel person list. */
 		this->RemoveSelf(_world.GetCreateVoxel(this->vox_pos, false));
 	}
+	if (this->minimap_tile.x >= 0) {
+		_minimap.RemoveGuest(this->minimap_tile.x, this->minimap_tile.y);
+		this->minimap_tile = Point16(-1, -1);
+	}
 
 	this->type = PERSON_INVALID;
 	delete[] this->name;
 	this->name = nullptr;
 }
 
+/** Move the person in the guest density of the minimap to the tile it is at now. */
+void Person::UpdateMinimapTile()
+{
+	if (this->minimap_tile.x == this->vox_pos.x && this->minimap_tile.y == this->vox_pos.y) return;
+
+	if (this->minimap_tile.x >= 0) _minimap.RemoveGuest(this->minimap_tile.x, this->minimap_tile.y);
+	if (IsVoxelstackInsideWorld(this->vox_pos.x, this->vox_pos.y)) {
+		this->minimap_tile = Point16(this->vox_pos.x, this->vox_pos.y);
+		_minimap.AddGuest(this->minimap_tile.x, this->minimap_tile.y);
+	} else {
+		this->minimap_tile = Point16(-1, -1);
+	}
+}
+
+/**
+ * Load the person from the save game.
+ * @param ldr Input stream to load from.
+ * @note The person stays inactive if loading fails. The caller adds the person to its voxel.
+ */
+void Person::Load(Loader &ldr)
+{
+	uint8 type = ldr.GetByte();
+	this->offset = ldr.GetWord();
+	this->vox_pos.x = ldr.GetWord();
+	this->vox_pos.y = ldr.GetWord();
+	this->vox_pos.z = ldr.GetWord();
+	this->pix_pos.x = ldr.GetWord();
+	this->pix_pos.y = ldr.GetWord();
+	this->pix_pos.z = ldr.GetWord();
+	uint16 walk_number = ldr.GetWord();
+	this->frame_index = ldr.GetWord();
+	this->frame_time = ldr.GetWord();
+	this->recolour.Load(ldr);
+	if (ldr.IsFail()) return;
+
+	this->walk = GetWalkFromNumber(walk_number);
+	const Animation *anim = nullptr;
+	if (type != PERSON_ANY && type < PERSON_TYPE_COUNT && this->walk != nullptr) {
+		anim = _sprite_manager.GetAnimation(this->walk->anim_type, (PersonType)type);
+	}
+	if (anim == nullptr || this->frame_index >= anim->frame_count) {
+		ldr.SetFailMessage("Incorrect person animation");
+		return;
+	}
+	if (!_world.VoxelExists(this->vox_pos)) {
+		ldr.SetFailMessage("Person outside the world");
+		return;
+	}
+
+	this->type = (PersonType)type;
+	this->name = nullptr;
+	this->frames = anim->frames;
+	this->frame_count = anim->frame_count;
+	this->minimap_tile = Point16(-1, -1);
+}
+
+/**
+ * Save the person to the save game.
+ * @param svr Output stream to save to.
+ * @note The name of the person is not saved.
+ */
+void Person::Save(Saver &svr) const
+{
+	svr.PutByte(this->type);
+	svr.PutWord(this->offset);
+	svr.PutWord(this->vox_pos.x);
+	svr.PutWord(this->vox_pos.y);
+	svr.PutWord(this->vox_pos.z);
+	svr.PutWord(this->pix_pos.x);
+	svr.PutWord(this->pix_pos.y);
+	svr.PutWord(this->pix_pos.z);
+	svr.PutWord(GetWalkNumber(this->walk));
+	svr.PutWord(this->frame_index);
+	svr.PutWord(this->frame_time);
+	this->recolour.Save(svr);
+}
+
 /**
  * Update the animation of a person.
  * @param delay Amount of milliseconds since the last update.
@@ -1038,6 +1177,92 @@ void Guest::DeActivate(AnimateResult ar)
 	this->Person::DeActivate(ar);
 }
 
+/** Flags of the possessions of a guest in the save game. */
+enum GuestPossessionFlags {
+	GPF_MAP        = 1 << 0, ///< Guest has a park map.
+	GPF_UMBRELLA   = 1 << 1, ///< Guest has an umbrella.
+	GPF_WRAPPER    = 1 << 2, ///< Guest has a wrapper.
+	GPF_BALLOON    = 1 << 3, ///< Guest has a balloon.
+	GPF_SALTY_FOOD = 1 << 4, ///< The food of the guest is salty.
+};
+
+/**
+ * Load the guest from the save game, and add it to the world.
+ * @param ldr Input stream to load from.
+ * @note The rides should be loaded already.
+ * @note The guest stays inactive if loading fails.
+ */
+void Guest::Load(Loader &ldr)
+{
+	this->Person::Load(ldr);
+
+	uint8 activity = ldr.GetByte();
+	this->happiness = ldr.GetWord();
+	this->total_happiness = ldr.GetWord();
+	this->cash = (int64)ldr.GetLongLong();
+	uint8 ride = ldr.GetByte();
+
+	uint8 possessions = ldr.GetByte();
+	this->has_map      = (possessions & GPF_MAP) != 0;
+	this->has_umbrella = (possessions & GPF_UMBRELLA) != 0;
+	this->has_wrapper  = (possessions & GPF_WRAPPER) != 0;
+	this->has_balloon  = (possessions & GPF_BALLOON) != 0;
+	this->salty_food   = (possessions & GPF_SALTY_FOOD) != 0;
+	this->souvenirs = ldr.GetByte();
+	this->food = ldr.GetByte();
+	this->drink = ldr.GetByte();
+	this->hunger_level = ldr.GetByte();
+	this->thirst_level = ldr.GetByte();
+	this->stomach_level = ldr.GetByte();
+	this->waste = ldr.GetByte();
+	this->nausea = ldr.GetByte();
+
+	this->ride = nullptr;
+	if (ride >= SRI_FULL_RIDES && ride < SRI_LAST) this->ride = _rides_manager.GetRideInstance(ride);
+	bool bad_ride = (ride != SRI_FREE && this->ride == nullptr) || (activity == GA_ON_RIDE && this->ride == nullptr);
+	if (ldr.IsFail() || this->type != PERSON_GUEST || activity > GA_GO_HOME || bad_ride) {
+		if (!ldr.IsFail()) ldr.SetFailMessage("Incorrect guest");
+		this->type = PERSON_INVALID;
+		return;
+	}
+	this->activity = (GuestActivity)activity;
+
+	/* A guest in a ride is not in the voxel objects of the world. */
+	if (this->activity != GA_ON_RIDE) this->AddSelf(_world.GetCreateVoxel(this->vox_pos, false));
+	this->UpdateMinimapTile();
+}
+
+/**
+ * Save the guest to the save game.
+ * @param svr Output stream to save to.
+ */
+void Guest::Save(Saver &svr) const
+{
+	this->Person::Save(svr);
+
+	svr.PutByte(this->activity);
+	svr.PutWord(this->happiness);
+	svr.PutWord(this->total_happiness);
+	svr.PutLongLong((uint64)this->cash);
+	svr.PutByte((this->ride != nullptr) ? this->ride->GetIndex() : SRI_FREE);
+
+	uint8 possessions = 0;
+	if (this->has_map)      possessions |= GPF_MAP;
+	if (this->has_umbrella) possessions |= GPF_UMBRELLA;
+	if (this->has_wrapper)  possessions |= GPF_WRAPPER;
+	if (this->has_balloon)  possessions |= GPF_BALLOON;
+	if (this->salty_food)   possessions |= GPF_SALTY_FOOD;
+	svr.PutByte(possessions);
+	svr.PutByte(this->souvenirs);
+	svr.PutByte(this->food);
+	svr.PutByte(this->drink);
+	svr.PutByte(this->hunger_level);
+	svr.PutByte(this->thirst_level);
+	svr.PutByte(this->stomach_level);
+	svr.PutByte(this->waste);
+	svr.PutByte(this->nausea);
+}
+
 AnimateResult Guest::OnAnimate(int delay)
 {
 	if (this->activity == GA_ON_RIDE) return OAR_OK; // Guest is not animated while on ride.
@@ -99,6 +99,7 @@ public:
 	virtual ~Person() override;
 
 	const ImageData *GetSprite(const SpriteStorage *sprites, ViewOrientation orient, const Recolouring **recolour) const override;
+	XYZPoint16 GetRenderOffset(uint32 progress) const override;
 
 	virtual AnimateResult OnAnimate(int delay);
 	virtual bool DailyUpdate() = 0;
@@ -127,10 +128,17 @@ public:
 	void SetName(const char *name);
 	const char *GetName() const;
 
+	void UpdateMinimapTile();
+
+	void Load(Loader &ldr);
+	void Save(Saver &svr) const;
+
 	uint16 id;       ///< Unique id of the person.
 	PersonType type; ///< Type of person.
 	int16 offset;    ///< Offset with respect to centre of paths walked on (0..100).
 
+	Point16 minimap_tile; ///< Tile at which the person is counted in the guest density of the minimap (negative if not counted).
+
 	const WalkInformation *walk;  ///< Walk animation sequence being performed.
 	const AnimationFrame *frames; ///< Animation frames of the current animation.
 	uint16 frame_count;           ///< Number of frames in #frames.
@@ -180,6 +188,9 @@ public:
 	void NotifyRideDeletion(const RideInstance *ri);
 	void ExitRide(RideInstance *ri, TileEdge entry);
 
+	void Load(Loader &ldr);
+	void Save(Saver &svr) const;
+
 	GuestActivity activity; ///< Activity being done by the guest currently.
 	int16 happiness;        ///< Happiness of the guest (values are 0-100). Use #ChangeHappiness to change the guest happiness.
 	uint16 total_happiness; ///< Sum of all good experiences (for evaluating the day after getting home, values are 0-1000).
@@ -0,0 +1,153 @@
+/* $Id$ */
+
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file profiler.cpp Measuring the time spent in parts of a frame. */
+
+#include "stdafx.h"
+#include "profiler.h"
+
+#ifdef ENABLE_PROFILER
+
+#include <chrono>
+
+Profiler _profiler; ///< Profiler of the frames.
+
+/** Names of the profiled sections, as shown in the trace. */
+static const char *_section_names[PFS_COUNT] = {
+	"Frame",
+	"OnNewFrame",
+	"Guests::OnAnimate",
+	"RidesManager::OnAnimate",
+	"UpdateWindows",
+	"VoxelCollector::Collect",
+	"Sort draw list",
+	"Blit sprites",
+	"FinishRepaint",
+};
+
+Profiler::Profiler() : history_index(0), history_count(0), frame_start(0), trace_file(nullptr), trace_events(0)
+{
+	std::fill_n(this->current, lengthof(this->current), 0);
+}
+
+Profiler::~Profiler()
+{
+	this->StopTrace();
+}
+
+/**
+ * Get the current time.
+ * @return Current time in microseconds, relative to an unspecified moment.
+ */
+int64 Profiler::GetTime()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Add a measured time interval to a section of the current frame.
+ * @param section Section that was measured.
+ * @param start Start time of the interval (see #GetTime).
+ * @param end End time of the interval (see #GetTime).
+ */
+void Profiler::AddTime(ProfileSection section, int64 start, int64 end)
+{
+	this->current[section] += end - start;
+
+	if (this->trace_file == nullptr) return;
+	if (this->trace_events == MAX_TRACE_EVENTS) {
+		fprintf(stderr, "Trace has %u events, stopped tracing.\n", MAX_TRACE_EVENTS);
+		this->StopTrace();
+		return;
+	}
+	fprintf(this->trace_file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":1}",
+			(this->trace_events == 0) ? "\n" : ",\n", _section_names[section], start, end - start);
+	this->trace_events++;
+}
+
+/** Start a new frame. The times of the previous frame (if there is one) are added to the history. */
+void Profiler::StartFrame()
+{
+	int64 now = GetTime();
+	if (this->frame_start != 0) {
+		this->AddTime(PFS_FRAME, this->frame_start, now);
+		for (int i = 0; i < PFS_COUNT; i++) this->history[i][this->history_index] = this->current[i];
+		this->history_index = (this->history_index + 1) % PROFILE_HISTORY_LENGTH;
+		if (this->history_count < PROFILE_HISTORY_LENGTH) this->history_count++;
+	}
+	std::fill_n(this->current, lengthof(this->current), 0);
+	this->frame_start = now;
+}
+
+/**
+ * Compute statistics of the time spent in a section over the last frames.
+ * @param section Section to examine.
+ * @param stats [out] Statistics of the section, all zero if no frame has been measured yet.
+ */
+void Profiler::GetStatistics(ProfileSection section, ProfileStatistics *stats) const
+{
+	*stats = {0, 0, 0, 0};
+	if (this->history_count == 0) return;
+
+	/* The order of the frames does not matter for the statistics. */
+	uint32 times[PROFILE_HISTORY_LENGTH];
+	std::copy_n(this->history[section], this->history_count, times);
+	std::sort(times, times + this->history_count);
+
+	uint64 total = 0;
+	for (int i = 0; i < this->history_count; i++) total += times[i];
+	stats->average = total / this->history_count;
+	stats->median = times[this->history_count / 2];
+	stats->p95 = times[(this->history_count * 95) / 100];
+	stats->maximum = times[this->history_count - 1];
+}
+
+/**
+ * Start writing the measured time intervals to a file, in the trace event format of the Chrome browser.
+ * @param fname Name of the file to write.
+ * @return Whether the file could be opened.
+ */
+bool Profiler::StartTrace(const char *fname)
+{
+	this->StopTrace();
+
+	this->trace_file = fopen(fname, "wb");
+	if (this->trace_file == nullptr) return false;
+
+	fprintf(this->trace_file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	this->trace_events = 0;
+	return true;
+}
+
+/** Stop writing the measured time intervals, and close the trace file. */
+void Profiler::StopTrace()
+{
+	if (this->trace_file == nullptr) return;
+
+	fprintf(this->trace_file, "\n]}\n");
+	fclose(this->trace_file);
+	this->trace_file = nullptr;
+}
+
+/**
+ * Get the name of a profiled section.
+ * @param section Section to name.
+ * @return Name of the section.
+ */
+const char *GetProfileSectionName(ProfileSection section)
+{
+	return _section_names[section];
+}
+
+ProfileScope::~ProfileScope()
+{
+	_profiler.AddTime(this->section, this->start, Profiler::GetTime());
+}
+
+#endif
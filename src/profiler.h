@@ -0,0 +1,123 @@
+/* $Id$ */
+
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file profiler.h Measuring the time spent in parts of a frame. */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+/* The profiler is available in debug builds, and in release builds when asked for. */
+#if !defined(NDEBUG) || defined(WITH_PROFILER)
+#define ENABLE_PROFILER
+#endif
+
+#ifdef ENABLE_PROFILER
+
+/** Parts of a frame measured by the #Profiler. */
+enum ProfileSection {
+	PFS_FRAME,          ///< Entire frame, from the start of one frame to the start of the next frame.
+	PFS_NEW_FRAME,      ///< Simulation ticks (#OnNewFrame).
+	PFS_GUESTS_ANIMATE, ///< Animating the guests (Guests::OnAnimate).
+	PFS_RIDES_ANIMATE,  ///< Animating the rides (RidesManager::OnAnimate).
+	PFS_UPDATE_WINDOWS, ///< Repainting the windows (#UpdateWindows).
+	PFS_COLLECT,        ///< Collecting the voxels of a viewport (VoxelCollector::Collect).
+	PFS_SORT,           ///< Sorting the collected sprites in drawing order.
+	PFS_BLIT,           ///< Blitting the sprites of a viewport.
+	PFS_FINISH_REPAINT, ///< Handing the repainted display to the GPU (VideoSystem::FinishRepaint).
+
+	PFS_COUNT,          ///< Number of measured parts.
+};
+
+static const int PROFILE_HISTORY_LENGTH = 128;       ///< Number of frames kept for computing statistics.
+static const uint32 MAX_TRACE_EVENTS = 1000 * 1000; ///< Maximal number of events written to a trace file.
+static const uint32 PROFILER_DISPLAY_INTERVAL = 15;  ///< Number of frames between two updates of the profiler window.
+
+/** Statistics of the time spent in a #ProfileSection over the last frames, all times are in microseconds. */
+struct ProfileStatistics {
+	uint32 average; ///< Average time of a frame.
+	uint32 median;  ///< Median time of a frame.
+	uint32 p95;     ///< 95th percentile of the time of a frame.
+	uint32 maximum; ///< Longest time of a frame.
+};
+
+/**
+ * Profiler measuring the time spent in the parts of each frame.
+ * Measurements are made with #ProfileScope objects, normally created with the #PROFILE_SCOPE macro.
+ * @note The profiler may only be used from the main thread.
+ */
+class Profiler {
+public:
+	Profiler();
+	~Profiler();
+
+	static int64 GetTime();
+
+	void AddTime(ProfileSection section, int64 start, int64 end);
+	void StartFrame();
+	void GetStatistics(ProfileSection section, ProfileStatistics *stats) const;
+
+	bool StartTrace(const char *fname);
+	void StopTrace();
+
+	/**
+	 * Get the number of frames with measurements.
+	 * @return Number of frames available for statistics.
+	 */
+	inline int GetFrameCount() const
+	{
+		return this->history_count;
+	}
+
+private:
+	uint32 current[PFS_COUNT];                         ///< Time spent in each section during the current frame, in microseconds.
+	uint32 history[PFS_COUNT][PROFILE_HISTORY_LENGTH]; ///< Time spent in each section during the last frames, in microseconds.
+	int history_index; ///< Index in #history to store the next frame.
+	int history_count; ///< Number of valid frames in #history.
+	int64 frame_start; ///< Start time of the current frame, \c 0 if no frame has been started yet.
+
+	FILE *trace_file;    ///< File to write the trace events to, \c nullptr if not tracing.
+	uint32 trace_events; ///< Number of events written to #trace_file.
+};
+
+/** Measure the time between its construction and destruction, and add it to a section of the #_profiler. */
+class ProfileScope {
+public:
+	/**
+	 * Start measuring time.
+	 * @param section Section to add the time to.
+	 */
+	ProfileScope(ProfileSection section) : section(section), start(Profiler::GetTime())
+	{
+	}
+
+	~ProfileScope();
+
+private:
+	ProfileSection section; ///< Section receiving the measured time.
+	int64 start;            ///< Time of construction.
+};
+
+extern Profiler _profiler;
+
+const char *GetProfileSectionName(ProfileSection section);
+void ShowProfilerGui();
+
+/**
+ * Measure the time spent in the remainder of the current scope.
+ * @param section Section to add the time to.
+ */
+#define PROFILE_SCOPE(section) ProfileScope profile_scope_timer(section)
+
+#else
+
+#define PROFILE_SCOPE(section)
+
+#endif
+
+#endif
@@ -0,0 +1,145 @@
+/* $Id$ */
+
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file profiler_gui.cpp Window displaying the measurements of the profiler. */
+
+#include "stdafx.h"
+#include "profiler.h"
+
+#ifdef ENABLE_PROFILER
+
+#include "window.h"
+#include "gui_graphics.h"
+
+/**
+ * Window displaying the time spent in the parts of the last frames.
+ * @ingroup gui_group
+ */
+class ProfilerGui : public GuiWindow {
+public:
+	ProfilerGui();
+
+	void UpdateWidgetSize(WidgetNumber wid_num, BaseWidget *wid) override;
+	void DrawWidget(WidgetNumber wid_num, const BaseWidget *wid) const override;
+	void OnChange(ChangeCode code, uint32 parameter) override;
+};
+
+/**
+ * Widget numbers of the profiler GUI.
+ * @ingroup gui_group
+ */
+enum ProfilerWidgets {
+	PFW_TABLE, ///< Table with the measurements.
+};
+
+/** Widget parts of the #ProfilerGui window. */
+static const WidgetPart _profiler_gui_parts[] = {
+	Intermediate(0, 1),
+		Intermediate(1, 0),
+			Widget(WT_TITLEBAR, INVALID_WIDGET_INDEX, COL_RANGE_GREY), SetData(GUI_PROFILER_TITLE, GUI_TITLEBAR_TIP),
+			Widget(WT_CLOSEBOX, INVALID_WIDGET_INDEX, COL_RANGE_GREY),
+		EndContainer(),
+		Widget(WT_PANEL, INVALID_WIDGET_INDEX, COL_RANGE_GREY),
+			Widget(WT_EMPTY, PFW_TABLE, COL_RANGE_GREY), SetPadding(2, 4, 2, 4),
+	EndContainer(),
+};
+
+static const int PROFILER_COLUMN_COUNT = 4; ///< Number of columns with times in the table.
+static const StringID _column_names[PROFILER_COLUMN_COUNT] = { ///< Column headers of the times.
+	GUI_PROFILER_AVERAGE,
+	GUI_PROFILER_MEDIAN,
+	GUI_PROFILER_P95,
+	GUI_PROFILER_MAXIMUM,
+};
+
+/**
+ * Format a time for displaying in the table.
+ * @param buffer [out] Destination of the text.
+ * @param size Size of \a buffer.
+ * @param time Time in microseconds.
+ */
+static void FormatTime(char *buffer, size_t size, uint32 time)
+{
+	snprintf(buffer, size, "%u.%02u", time / 1000, (time % 1000) / 10);
+}
+
+ProfilerGui::ProfilerGui() : GuiWindow(WC_PROFILER, ALL_WINDOWS_OF_TYPE)
+{
+	this->SetupWidgetTree(_profiler_gui_parts, lengthof(_profiler_gui_parts));
+}
+
+/**
+ * Get the width of a column with times.
+ * @return Width of the column in pixels.
+ */
+static int GetTimeColumnWidth()
+{
+	int width, height;
+	_video.GetTextSize((const uint8 *)"  9999.99", &width, &height);
+	return width;
+}
+
+void ProfilerGui::UpdateWidgetSize(WidgetNumber wid_num, BaseWidget *wid)
+{
+	if (wid_num != PFW_TABLE) return;
+
+	int name_width = 0;
+	for (int i = 0; i < PFS_COUNT; i++) {
+		int width, height;
+		_video.GetTextSize((const uint8 *)GetProfileSectionName((ProfileSection)i), &width, &height);
+		name_width = std::max(name_width, width);
+	}
+	wid->min_x = name_width + PROFILER_COLUMN_COUNT * GetTimeColumnWidth();
+	wid->min_y = (PFS_COUNT + 1) * GetTextHeight();
+}
+
+void ProfilerGui::DrawWidget(WidgetNumber wid_num, const BaseWidget *wid) const
+{
+	if (wid_num != PFW_TABLE) return;
+
+	int x = this->GetWidgetScreenX(wid);
+	int y = this->GetWidgetScreenY(wid);
+	int column_width = GetTimeColumnWidth();
+	int name_width = wid->pos.width - PROFILER_COLUMN_COUNT * column_width;
+	uint32 colour = _palette[TEXT_WHITE];
+
+	DrawString(GUI_PROFILER_UNIT, TEXT_WHITE, x, y, name_width);
+	for (int c = 0; c < PROFILER_COLUMN_COUNT; c++) {
+		DrawString(_column_names[c], TEXT_WHITE, x + name_width + c * column_width, y, column_width, ALG_RIGHT);
+	}
+	y += GetTextHeight();
+
+	for (int i = 0; i < PFS_COUNT; i++) {
+		ProfileStatistics stats;
+		_profiler.GetStatistics((ProfileSection)i, &stats);
+		const uint32 times[PROFILER_COLUMN_COUNT] = {stats.average, stats.median, stats.p95, stats.maximum};
+
+		_video.BlitText((const uint8 *)GetProfileSectionName((ProfileSection)i), colour, x, y, name_width);
+		for (int c = 0; c < PROFILER_COLUMN_COUNT; c++) {
+			char buffer[16];
+			FormatTime(buffer, lengthof(buffer), times[c]);
+			_video.BlitText((const uint8 *)buffer, colour, x + name_width + c * column_width, y, column_width, ALG_RIGHT);
+		}
+		y += GetTextHeight();
+	}
+}
+
+void ProfilerGui::OnChange(ChangeCode code, uint32 parameter)
+{
+	if (code == CHG_DISPLAY_OLD) this->MarkWidgetDirty(PFW_TABLE);
+}
+
+/** Open the profiler window (or if it is already opened, highlight and raise it). */
+void ShowProfilerGui()
+{
+	if (HighlightWindowByType(WC_PROFILER, ALL_WINDOWS_OF_TYPE)) return;
+	new ProfilerGui;
+}
+
+#endif
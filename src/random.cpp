@@ -91,8 +91,12 @@ uint32 Random::DrawNumber()
 void Random::Load(Loader &ldr)
 {
 	uint32 version = ldr.OpenBlock("RAND");
-	/* Do nothing if version == 0, as any number in seed is fine. */
-	if (version == 1) Random::seed = ldr.GetLong();
+	/* Do nothing if version == 0, as any number in seed is fine. An unknown version is skipped for the same reason. */
+	if (version == 1) {
+		Random::seed = ldr.GetLong();
+	} else if (version != 0 && !ldr.SkipBlock()) {
+		ldr.SetFailMessage("Unknown random number version");
+	}
 	ldr.CloseBlock();
 }
 
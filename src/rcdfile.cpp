@@ -13,6 +13,7 @@
 #include "rcdfile.h"
 #include "fileio.h"
 #include "string_func.h"
+#include "loadsave.h"
 
 RcdFileCollection _rcd_collection; ///< Available RCD files.
 
@@ -23,7 +24,7 @@ RcdFileCollection _rcd_collection; ///< Available RCD files.
  * @param build Build version of the file.
  */
 RcdFileInfo::RcdFileInfo(const std::string &path, const std::string &uri, const std::string &build)
-		: path(path), uri(uri), build(build)
+		: path(path), uri(uri), build(build), file_size(0), mtime(0)
 {
 }
 
@@ -31,7 +32,8 @@ RcdFileInfo::RcdFileInfo(const std::string &path, const std::string &uri, const
  * Copy constructor.
  * @param orig Existing instance to copy.
  */
-RcdFileInfo::RcdFileInfo(const RcdFileInfo &orig) : path(orig.path), uri(orig.uri), build(orig.build)
+RcdFileInfo::RcdFileInfo(const RcdFileInfo &orig)
+		: path(orig.path), uri(orig.uri), build(orig.build), file_size(orig.file_size), mtime(orig.mtime), blocks(orig.blocks)
 {
 }
 
@@ -46,6 +48,9 @@ RcdFileInfo &RcdFileInfo::operator=(const RcdFileInfo &orig)
 		this->path = orig.path;
 		this->uri = orig.uri;
 		this->build = orig.build;
+		this->file_size = orig.file_size;
+		this->mtime = orig.mtime;
+		this->blocks = orig.blocks;
 	}
 	return *this;
 }
@@ -77,9 +82,114 @@ static const char *_rcd_paths[] = {
 	nullptr,
 };
 
-/** Scan directories, looking for RCD files to add. */
+static const char *RCD_INDEX_FILE = "rcdindex.dat"; ///< File containing the information of the RCD files found at the previous scan.
+
+typedef std::map<std::string, RcdFileInfo> RcdFileIndex; ///< Information of RCD files, by path of the file.
+
+/**
+ * Load a text.
+ * @param ldr Input stream to load from.
+ * @return The loaded text.
+ */
+static std::string LoadText(Loader &ldr)
+{
+	uint16 length = ldr.GetWord();
+	std::string text;
+	for (uint16 i = 0; i < length && !ldr.IsFail(); i++) text += (char)ldr.GetByte();
+	return text;
+}
+
+/**
+ * Save a text.
+ * @param svr Output stream to write to.
+ * @param text Text to save, at most 65535 bytes.
+ */
+static void SaveText(Saver &svr, const std::string &text)
+{
+	assert(text.size() <= 0xFFFF);
+	svr.PutWord(text.size());
+	svr.PutBlob(text.data(), text.size());
+}
+
+/**
+ * Load the information of the RCD files found at the previous scan.
+ * @param index [out] Information of the RCD files, empty if the index file is missing or broken.
+ */
+static void LoadRcdIndex(RcdFileIndex *index)
+{
+	index->clear();
+	FileContents contents;
+	if (!contents.Load(RCD_INDEX_FILE) || contents.data == nullptr) return;
+
+	Loader ldr(contents.data, contents.size);
+	if (ldr.OpenBlock("RIDX") == 1) {
+		uint32 count = ldr.GetLong();
+		for (uint32 i = 0; i < count && !ldr.IsFail(); i++) {
+			RcdFileInfo rfi(LoadText(ldr), "", "");
+			rfi.uri = LoadText(ldr);
+			rfi.build = LoadText(ldr);
+			rfi.file_size = ldr.GetLongLong();
+			rfi.mtime = ldr.GetLongLong();
+			uint32 block_count = ldr.GetLong();
+			for (uint32 j = 0; j < block_count && !ldr.IsFail(); j++) {
+				RcdBlockInfo bi;
+				for (int k = 0; k < 4; k++) bi.name[k] = ldr.GetByte();
+				bi.name[4] = '\0';
+				bi.version = ldr.GetLong();
+				bi.offset = ldr.GetLong();
+				bi.size = ldr.GetLong();
+				rfi.blocks.push_back(bi);
+			}
+			index->emplace(rfi.path, rfi);
+		}
+		ldr.CloseBlock();
+	} else {
+		ldr.SetFailMessage("Unknown index version");
+	}
+
+	if (ldr.IsFail()) index->clear();
+}
+
+/**
+ * Save the information of the found RCD files, so the next scan does not need to read them.
+ * @param index Information of the RCD files.
+ */
+static void SaveRcdIndex(const RcdFileIndex &index)
+{
+	Saver svr;
+	svr.StartBlock("RIDX", 1);
+	svr.PutLong(index.size());
+	for (const auto &entry : index) {
+		const RcdFileInfo &rfi = entry.second;
+		SaveText(svr, rfi.path);
+		SaveText(svr, rfi.uri);
+		SaveText(svr, rfi.build);
+		svr.PutLongLong(rfi.file_size);
+		svr.PutLongLong(rfi.mtime);
+		svr.PutLong(rfi.blocks.size());
+		for (const RcdBlockInfo &bi : rfi.blocks) {
+			for (int k = 0; k < 4; k++) svr.PutByte(bi.name[k]);
+			svr.PutLong(bi.version);
+			svr.PutLong(bi.offset);
+			svr.PutLong(bi.size);
+		}
+	}
+	svr.EndBlock();
+	svr.WriteFile(RCD_INDEX_FILE); // Not being able to save the index only makes the next scan slower.
+}
+
+/**
+ * Scan directories, looking for RCD files to add.
+ * Files that did not change since the previous scan (same size and modification time) are not read again,
+ * their information is taken from the index file written at the previous scan.
+ */
 void RcdFileCollection::ScanDirectories()
 {
+	RcdFileIndex old_index;
+	LoadRcdIndex(&old_index);
+	RcdFileIndex new_index;
+	bool changed = false;
+
 	DirectoryReader *reader = MakeDirectoryReader();
 
 	const char **rcd_path = _rcd_paths;
@@ -89,12 +199,26 @@ void RcdFileCollection::ScanDirectories()
 			const char *fname = reader->NextFile();
 			if (fname == nullptr) break;
 			if (!StrEndsWith(fname, ".rcd", false)) continue;
-			this->ScanFileForMetaInfo(fname);
+
+			RcdFileInfo rfi(fname, "", "");
+			if (!GetFileStatus(fname, &rfi.file_size, &rfi.mtime)) continue;
+
+			auto iter = old_index.find(rfi.path);
+			if (iter != old_index.end() && iter->second.file_size == rfi.file_size && iter->second.mtime == rfi.mtime) {
+				rfi = iter->second;
+			} else {
+				if (this->ScanFileForMetaInfo(&rfi) != nullptr) continue;
+				changed = true;
+			}
+			this->AddFile(rfi);
+			new_index.emplace(rfi.path, rfi);
 		}
 		reader->ClosePath();
 		rcd_path++;
 	}
 	delete reader;
+
+	if (changed || new_index.size() != old_index.size()) SaveRcdIndex(new_index);
 }
 
 /**
@@ -132,20 +256,22 @@ static std::string GetString(RcdFileReader &rcd_file, uint max_bytes, uint32 *re
 }
 
 /**
- * Scan a file for Rcd meta-data, and add it to the collection if all is well.
- * @param fname Filename of the file to scan.
+ * Scan a file for Rcd meta-data and its blocks.
+ * @param rfi [inout] Information of the file to scan, the #RcdFileInfo::path must be set.
  * @return Error message, or \c nullptr if no error found.
  */
-const char *RcdFileCollection::ScanFileForMetaInfo(const char *fname)
+const char *RcdFileCollection::ScanFileForMetaInfo(RcdFileInfo *rfi)
 {
-	RcdFileReader rcd_file(fname);
+	RcdFileReader rcd_file(rfi->path.c_str());
 	if (!rcd_file.CheckFileHeader("RCDF", 2)) return "Wrong header";
 
 	/* Load block. */
+	size_t offset = rcd_file.GetPosition();
 	if (!rcd_file.ReadBlockHeader() || (strcmp(rcd_file.name, "INFO") != 0)) {
 		/* End reached or found a non-meta block, end scanning. */
 		return "No INFO block found.";
 	}
+	size_t data_offset = rcd_file.GetPosition();
 
 	/* Load INFO block. */
 	if (rcd_file.version != 1) return "INFO block has wrong version";
@@ -157,7 +283,22 @@ const char *RcdFileCollection::ScanFileForMetaInfo(const char *fname)
 	std::string description = GetString(rcd_file, 512, &remaining);
 	if (remaining != 0) return "Error while reading INFO text.";
 
-	RcdFileInfo rfi(fname, uri, build);
-	this->AddFile(rfi);
+	rfi->uri = uri;
+	rfi->build = build;
+
+	/* Make a directory of the blocks, for finding them without reading the file. */
+	rfi->blocks.clear();
+	for (;;) {
+		RcdBlockInfo bi;
+		strcpy(bi.name, rcd_file.name);
+		bi.version = rcd_file.version;
+		bi.offset = offset;
+		bi.size = rcd_file.size;
+		rfi->blocks.push_back(bi);
+
+		offset = data_offset + rcd_file.size;
+		if (!rcd_file.SetPosition(offset) || !rcd_file.ReadBlockHeader()) break;
+		data_offset = rcd_file.GetPosition();
+	}
 	return nullptr; // Success.
 }
@@ -13,8 +13,17 @@
 #define RCDFILE_H
 
 #include <string>
+#include <vector>
 #include <map>
 
+/** Position of a block in an RCD file. */
+struct RcdBlockInfo {
+	char name[5];   ///< Name of the block.
+	uint32 version; ///< Version number of the block.
+	uint32 offset;  ///< Offset of the block header in the file.
+	uint32 size;    ///< Size of the data of the block.
+};
+
 /** Information about an RCD file. */
 class RcdFileInfo {
 public:
@@ -25,6 +34,9 @@ public:
 	std::string path;  ///< Path to the file, utf-8 encoded.
 	std::string uri;   ///< URI of the RCD file, utf-8 encoded.
 	std::string build; ///< Build version, utf-8 encoded.
+	uint64 file_size;  ///< Size of the file in bytes, when it was scanned.
+	uint64 mtime;      ///< Time of the last modification of the file, when it was scanned.
+	std::vector<RcdBlockInfo> blocks; ///< Blocks of the file, in file order.
 };
 
 /** Collected RCD files. */
@@ -38,7 +50,7 @@ public:
 	std::map<std::string, RcdFileInfo> rcdfiles; ///< Found unique RCD files, mapping of uri to the Rcd file information.
 
 private:
-	const char *ScanFileForMetaInfo(const char *fname);
+	const char *ScanFileForMetaInfo(RcdFileInfo *rfi);
 };
 
 extern RcdFileCollection _rcd_collection;
@@ -128,6 +128,20 @@ void FileBlock::Write(FILE *fp)
 	}
 }
 
+/**
+ * Compute a hash of the content of the file block (64 bit FNV-1a), for finding identical blocks quickly.
+ * @return Hash of the data of the block.
+ */
+uint64 FileBlock::GetHash() const
+{
+	uint64 hash = 14695981039346656037ull;
+	for (int i = 0; i < this->length; i++) {
+		hash ^= this->data[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
 /**
  * Check whether two file blocks are identical.
  * @param fb1 First block to compare.
@@ -143,6 +157,8 @@ bool operator==(const FileBlock &fb1, const FileBlock &fb2)
 
 FileWriter::FileWriter()
 {
+	this->duplicate_count = 0;
+	this->duplicate_size = 0;
 }
 
 FileWriter::~FileWriter()
@@ -157,17 +173,20 @@ FileWriter::~FileWriter()
  */
 int FileWriter::AddBlock(FileBlock *blk)
 {
-	int idx = 1;
-	for (auto &iter : this->blocks) {
+	uint64 hash = blk->GetHash();
+	auto range = this->block_hashes.equal_range(hash);
+	for (auto iter = range.first; iter != range.second; ++iter) {
 		/* Block already added, just return the old block number. */
-		if (*iter == *blk) {
+		if (*this->blocks[iter->second] == *blk) {
+			this->duplicate_count++;
+			this->duplicate_size += blk->length;
 			delete blk;
-			return idx;
+			return iter->second + 1;
 		}
-		idx++;
 	}
+	this->block_hashes.emplace(hash, this->blocks.size());
 	this->blocks.push_back(blk);
-	return idx;
+	return this->blocks.size();
 }
 
 /**
@@ -192,3 +211,16 @@ void FileWriter::WriteFile(std::string fname)
 
 	fclose(fp);
 }
+
+/**
+ * Print how many blocks are stored in the file, and how many added blocks were not stored as they were already in the file.
+ * @param fname Name of the RCD file.
+ */
+void FileWriter::PrintStatistics(const std::string &fname) const
+{
+	uint64 size = 8; // File header.
+	for (const FileBlock *blk : this->blocks) size += blk->length;
+
+	printf("%s: %u blocks, %llu bytes, %d duplicate blocks (%llu bytes) removed\n", fname.c_str(),
+			(uint)this->blocks.size(), (unsigned long long)size, this->duplicate_count, (unsigned long long)this->duplicate_size);
+}
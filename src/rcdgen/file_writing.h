@@ -12,8 +12,9 @@
 #ifndef FILE_WRITING_H
 #define FILE_WRITING_H
 
-#include <list>
+#include <vector>
 #include <string>
+#include <unordered_map>
 
 /** A block in an RCD file. See #StartSave for details on usage. */
 class FileBlock {
@@ -31,6 +32,7 @@ public:
 	void CheckEndSave();
 
 	void Write(FILE *fp);
+	uint64 GetHash() const;
 
 	uint8 *data;    ///< Data of the block.
 	int length;     ///< Length of the block.
@@ -40,7 +42,7 @@ public:
 bool operator==(const FileBlock &fb1, const FileBlock &fb2);
 
 /** Type definition for a list of file blocks. */
-typedef std::list<FileBlock *> FileBlockPtrList;
+typedef std::vector<FileBlock *> FileBlockPtrList;
 
 /** RCD output file. */
 class FileWriter {
@@ -51,9 +53,14 @@ public:
 	int AddBlock(FileBlock *fb);
 
 	void WriteFile(const std::string fname);
+	void PrintStatistics(const std::string &fname) const;
 
 private:
 	FileBlockPtrList blocks; ///< Blocks stored in the file so far.
+	std::unordered_multimap<uint64, int> block_hashes; ///< Hash of the content of each stored block, and its index in #blocks.
+
+	int duplicate_count;   ///< Number of added blocks that were already stored.
+	uint64 duplicate_size; ///< Number of bytes of the added blocks that were already stored.
 };
 
 #endif
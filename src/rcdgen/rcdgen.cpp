@@ -40,6 +40,7 @@ static const OptionData _options[] = {
 	GETOPT_VALUE('c', "--code"),
 	GETOPT_VALUE('b', "--base"),
 	GETOPT_VALUE('p', "--prefix"),
+	GETOPT_NOVAL('s', "--stats"),
 	GETOPT_END()
 };
 
@@ -54,7 +55,10 @@ static void PrintUsage()
 	printf("\n");
 	printf("2. Generate RCD data files from input files or stdin:\n");
 	printf("\n");
-	printf("\trcdgen [FILE ...]\n");
+	printf("\trcdgen [--stats] [FILE ...]\n");
+	printf("\n");
+	printf("   --stats prints the number of blocks of each RCD file, and the number of\n");
+	printf("           identical blocks that were stored only once.\n");
 	printf("\n");
 	printf("3. Generate .h and/or .cpp files for strings of the program:\n");
 	printf("\n");
@@ -81,6 +85,7 @@ int main(int argc, char *argv[])
 	const char *code = nullptr;
 	const char *prefix = nullptr;
 	const char *base = "0";
+	bool stats = false;
 
 	int opt_id;
 	do {
@@ -106,6 +111,10 @@ int main(int argc, char *argv[])
 				prefix = opt_data.opt;
 				break;
 
+			case 's':
+				stats = true;
+				break;
+
 			case -1:
 				break;
 
@@ -141,6 +150,7 @@ int main(int argc, char *argv[])
 			FileWriter fw;
 			iter->Write(&fw);
 			fw.WriteFile(iter->file_name);
+			if (stats) fw.PrintStatistics(iter->file_name);
 		}
 
 		delete file_nodes;
@@ -56,6 +56,8 @@ static const char *_gui_string_names[] = {
 	"TOOLBAR_GUI_TOOLTIP_TERRAFORM",
 	"TOOLBAR_GUI_FINANCES",
 	"TOOLBAR_GUI_TOOLTIP_FINANCES",
+	"TOOLBAR_GUI_MINIMAP",
+	"TOOLBAR_GUI_TOOLTIP_MINIMAP",
 
 	/* Quit program strings. */
 	"QUIT_CAPTION",
@@ -188,6 +190,19 @@ static const char *_gui_string_names[] = {
 	"SETTING_LANGUAGE_TOOLTIP",
 	"SETTING_RESOLUTION",
 	"SETTING_RESOLUTION_TOOLTIP",
+
+	/* Profiler window. */
+	"PROFILER_TITLE",
+	"PROFILER_UNIT",
+	"PROFILER_AVERAGE",
+	"PROFILER_MEDIAN",
+	"PROFILER_P95",
+	"PROFILER_MAXIMUM",
+
+	/* Minimap window. */
+	"MINIMAP_TITLE",
+	"MINIMAP_GUESTS",
+	"MINIMAP_GUESTS_TOOLTIP",
 };
 
 /** String names of the shops. */
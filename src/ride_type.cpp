@@ -24,6 +24,7 @@
 #include "person.h"
 #include "people.h"
 #include "random.h"
+#include "profiler.h"
 
 /**
  * \page Rides
@@ -383,6 +384,61 @@ void RideInstance::BuildRide()
 	this->state = RIS_BUILDING;
 }
 
+/**
+ * Load the data of the ride instance from the save game.
+ * @param ldr Input stream to load from.
+ * @note Derived classes load their own data after the data of this class.
+ */
+void RideInstance::Load(Loader &ldr)
+{
+	ldr.GetBlob(this->name, sizeof(this->name));
+	this->name[lengthof(this->name) - 1] = '\0';
+	this->state = ldr.GetByte();
+	this->flags = ldr.GetByte();
+	this->recolours.Load(ldr);
+
+	this->total_profit = (int64)ldr.GetLongLong();
+	this->total_sell_profit = (int64)ldr.GetLongLong();
+	for (int i = 0; i < NUMBER_ITEM_TYPES_SOLD; i++) {
+		this->item_price[i] = (int64)ldr.GetLongLong();
+		this->item_count[i] = (int64)ldr.GetLongLong();
+	}
+
+	this->breakdown_ctr = (int16)ldr.GetWord();
+	this->reliability = ldr.GetWord();
+	uint8 breakdown_state = ldr.GetByte();
+	this->breakdown_state = (breakdown_state <= BDS_UNOPENED) ? (BreakdownState)breakdown_state : BDS_UNOPENED;
+
+	if (this->state == RIS_ALLOCATED || this->state > RIS_OPEN || breakdown_state > BDS_UNOPENED) {
+		ldr.SetFailMessage("Incorrect ride state");
+		this->state = RIS_CLOSED;
+	}
+}
+
+/**
+ * Save the data of the ride instance to the save game.
+ * @param svr Output stream to save to.
+ * @note Derived classes save their own data after the data of this class.
+ */
+void RideInstance::Save(Saver &svr) const
+{
+	svr.PutBlob(this->name, sizeof(this->name));
+	svr.PutByte(this->state);
+	svr.PutByte(this->flags);
+	this->recolours.Save(svr);
+
+	svr.PutLongLong((uint64)this->total_profit);
+	svr.PutLongLong((uint64)this->total_sell_profit);
+	for (int i = 0; i < NUMBER_ITEM_TYPES_SOLD; i++) {
+		svr.PutLongLong((uint64)this->item_price[i]);
+		svr.PutLongLong((uint64)this->item_count[i]);
+	}
+
+	svr.PutWord(this->breakdown_ctr);
+	svr.PutWord(this->reliability);
+	svr.PutByte(this->breakdown_state);
+}
+
 /** Default constructor of the rides manager. */
 RidesManager::RidesManager()
 {
@@ -402,6 +458,7 @@ RidesManager::~RidesManager()
  */
 void RidesManager::OnAnimate(int delay)
 {
+	PROFILE_SCOPE(PFS_RIDES_ANIMATE);
 	for (uint16 i = 0; i < lengthof(this->instances); i++) {
 		if (this->instances[i] == nullptr || this->instances[i]->state == RIS_ALLOCATED) continue;
 		this->instances[i]->OnAnimate(delay);
@@ -596,6 +653,87 @@ void RidesManager::DeleteInstance(uint16 num)
 	_guests.NotifyRideDeletion(this->instances[num]);
 	delete this->instances[num];
 	this->instances[num] = nullptr;
+	_world.NotifyChange(); // Voxels referring to the ride are no longer drawn.
+}
+
+/**
+ * Destroy all ride instances, for example before loading a saved game.
+ * The windows of the rides are closed first, closing the ride selection window also frees a ride being placed.
+ * @pre The guests have left the park already.
+ */
+void RidesManager::DeleteAllRideInstances()
+{
+	static const WindowTypes ride_windows[] = {WC_RIDE_SELECT, WC_SHOP_MANAGER, WC_COASTER_BUILD, WC_COASTER_MANAGER};
+	for (WindowTypes wtype : ride_windows) {
+		Window *w;
+		while ((w = GetWindowByType(wtype, ALL_WINDOWS_OF_TYPE)) != nullptr) delete w;
+	}
+
+	for (uint i = 0; i < lengthof(this->instances); i++) {
+		delete this->instances[i];
+		this->instances[i] = nullptr;
+	}
+	_world.NotifyChange();
+}
+
+/**
+ * Load the ride instances from the save game.
+ * @param ldr Input stream to load from.
+ * @note The world should be loaded already, the rides put their voxels back in the world.
+ * @pre No ride instances exist, see #DeleteAllRideInstances.
+ */
+void RidesManager::Load(Loader &ldr)
+{
+	uint32 version = ldr.OpenBlock("RIDS");
+	if (version == 1) {
+		uint count = ldr.GetWord();
+		for (uint i = 0; i < count && !ldr.IsFail(); i++) {
+			uint16 num = ldr.GetByte();
+			const RideType *type = this->GetRideType(ldr.GetWord());
+			if (num < SRI_FULL_RIDES || num >= SRI_FULL_RIDES + lengthof(this->instances) || this->instances[num - SRI_FULL_RIDES] != nullptr) {
+				ldr.SetFailMessage("Incorrect ride instance number");
+				break;
+			}
+			if (type == nullptr) {
+				ldr.SetFailMessage("Unknown ride type");
+				break;
+			}
+			this->CreateInstance(type, num)->Load(ldr);
+		}
+	} else if (version != 0) {
+		ldr.SetFailMessage("Unknown rides version");
+	}
+	ldr.CloseBlock();
+	_world.NotifyChange();
+}
+
+/**
+ * Save the ride instances to the save game.
+ * @param svr Output stream to save to.
+ * @note A ride being placed (#RIS_ALLOCATED) is not saved.
+ */
+void RidesManager::Save(Saver &svr) const
+{
+	uint count = 0;
+	for (const RideInstance *ri : this->instances) {
+		if (ri != nullptr && ri->state != RIS_ALLOCATED) count++;
+	}
+
+	svr.StartBlock("RIDS", 1);
+	svr.PutWord(count);
+	for (uint i = 0; i < lengthof(this->instances); i++) {
+		const RideInstance *ri = this->instances[i];
+		if (ri == nullptr || ri->state == RIS_ALLOCATED) continue;
+
+		const RideType *type = ri->GetRideType();
+		uint16 type_index = std::find(this->ride_types, endof(this->ride_types), type) - this->ride_types;
+		assert(type_index < lengthof(this->ride_types));
+
+		svr.PutByte(i + SRI_FULL_RIDES);
+		svr.PutWord(type_index);
+		ri->Save(svr);
+	}
+	svr.EndBlock();
 }
 
 /**
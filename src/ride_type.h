@@ -158,6 +158,9 @@ public:
 	void CloseRide();
 	void HandleBreakdown();
 
+	virtual void Load(Loader &ldr);
+	virtual void Save(Saver &svr) const;
+
 	uint16 GetIndex() const;
 
 	uint8 name[64];          ///< Name of the ride, if it is instantiated.
@@ -196,8 +199,12 @@ public:
 	RideInstance *CreateInstance(const RideType *type, uint16 num);
 	void NewInstanceAdded(uint16 num);
 	void DeleteInstance(uint16 num);
+	void DeleteAllRideInstances();
 	void CheckNoAllocatedRides() const;
 
+	void Load(Loader &ldr);
+	void Save(Saver &svr) const;
+
 	void OnAnimate(int delay);
 	void OnNewMonth();
 	void OnNewDay();
@@ -257,3 +257,44 @@ void ShopInstance::OnAnimate(int delay)
 		gb.state = BST_EMPTY;
 	}
 }
+
+void ShopInstance::Load(Loader &ldr)
+{
+	this->RideInstance::Load(ldr);
+
+	this->orientation = ldr.GetByte();
+	this->vox_pos.x = ldr.GetWord();
+	this->vox_pos.y = ldr.GetWord();
+	this->vox_pos.z = ldr.GetWord();
+	this->onride_guests.Load(ldr);
+	if (ldr.IsFail()) return;
+
+	for (const GuestBatch &gb : this->onride_guests.batches) {
+		for (const GuestData &gd : gb.guests) {
+			if (!gd.IsEmpty() && gd.guest >= GUEST_BLOCK_SIZE) {
+				ldr.SetFailMessage("Incorrect guest in the shop");
+				return;
+			}
+		}
+	}
+
+	/* The world saves the voxel of the shop as empty, put the shop back. */
+	Voxel *vx = IsVoxelInsideWorld(this->vox_pos) ? _world.GetCreateVoxel(this->vox_pos, true) : nullptr;
+	if (this->orientation > 3 || vx == nullptr || !vx->CanPlaceInstance()) {
+		ldr.SetFailMessage("Incorrect shop position");
+		return;
+	}
+	vx->SetInstance((SmallRideInstance)this->GetIndex());
+	vx->SetInstanceData(this->GetEntranceDirections(this->vox_pos));
+}
+
+void ShopInstance::Save(Saver &svr) const
+{
+	this->RideInstance::Save(svr);
+
+	svr.PutByte(this->orientation);
+	svr.PutWord(this->vox_pos.x);
+	svr.PutWord(this->vox_pos.y);
+	svr.PutWord(this->vox_pos.z);
+	this->onride_guests.Save(svr);
+}
@@ -0,0 +1,276 @@
+/* $Id$ */
+
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file sprite_cache.cpp Cache of decoded sprites. */
+
+#include "stdafx.h"
+#include "sprite_cache.h"
+#include "sprite_data.h"
+#include "bitmath.h"
+
+/**
+ * Add a pixel to the decoded sprite, extending the last span if possible.
+ * @param ds Decoded sprite being constructed.
+ * @param x Horizontal position of the pixel.
+ * @param y Vertical position of the pixel.
+ * @param colour Colour of the pixel.
+ * @param blend Whether the pixel should be blended with the background.
+ */
+static void AddDecodedPixel(DecodedSprite *ds, uint16 x, uint16 y, uint32 colour, bool blend)
+{
+	if (!ds->spans.empty()) {
+		DecodedSpan &last = ds->spans.back();
+		if (last.y == y && last.blend == blend && last.x + last.length == x) {
+			last.length++;
+			ds->pixels.push_back(colour);
+			return;
+		}
+	}
+
+	DecodedSpan span;
+	span.x = x;
+	span.y = y;
+	span.length = 1;
+	span.blend = blend;
+	span.first = ds->pixels.size();
+	ds->spans.push_back(span);
+	ds->pixels.push_back(colour);
+}
+
+/**
+ * Decode the sprite, applying recolouring and gradient shift.
+ * @param spr %Sprite to decode.
+ * @param recolour Sprite recolouring definition.
+ * @param shift Gradient shift.
+ * @note The pixels produced are the same as VideoSystem::BlitImages computes, blended pixels store the opacity in their alpha channel.
+ */
+void DecodedSprite::Decode(const ImageData *spr, const Recolouring &recolour, GradientShift shift)
+{
+	this->spans.clear();
+	this->pixels.clear();
+
+	spr->RequirePixels();
+	if (GB(spr->flags, IFG_IS_8BPP, 1) != 0) {
+		const uint8 *recoloured = recolour.GetPalette(shift);
+		for (uint16 yoff = 0; yoff < spr->height; yoff++) {
+			uint32 offset = spr->table[yoff];
+			if (offset == INVALID_JUMP) continue;
+
+			uint16 xpos = 0;
+			for (;;) {
+				uint8 rel_off = spr->data[offset];
+				uint8 count   = spr->data[offset + 1];
+				const uint8 *pixels = &spr->data[offset + 2];
+				offset += 2 + count;
+
+				xpos += rel_off & 127;
+				for (; count > 0; count--) {
+					AddDecodedPixel(this, xpos, yoff, _palette[recoloured[*pixels]], false);
+					pixels++;
+					xpos++;
+				}
+				if ((rel_off & 128) != 0) break;
+			}
+		}
+	} else {
+		ShiftFunc sf = GetGradientShiftFunc(shift);
+		const uint8 *src = spr->data + 2; // Skip the length word.
+		for (uint16 yoff = 0; yoff < spr->height; yoff++) {
+			uint16 xpos = 0;
+			for (;;) {
+				uint8 mode = *src++;
+				if (mode == 0) break;
+				switch (mode >> 6) {
+					case 0: // Fully opaque pixels.
+						mode &= 0x3F;
+						for (; mode > 0; mode--) {
+							AddDecodedPixel(this, xpos, yoff, MakeRGBA(sf(src[0]), sf(src[1]), sf(src[2]), OPAQUE), false);
+							xpos++;
+							src += 3;
+						}
+						break;
+
+					case 1: { // Partial opaque pixels.
+						uint8 opacity = *src++;
+						mode &= 0x3F;
+						for (; mode > 0; mode--) {
+							AddDecodedPixel(this, xpos, yoff, MakeRGBA(sf(src[0]), sf(src[1]), sf(src[2]), opacity), true);
+							xpos++;
+							src += 3;
+						}
+						break;
+					}
+
+					case 2: // Fully transparent pixels.
+						xpos += mode & 0x3F;
+						break;
+
+					case 3: { // Recoloured pixels.
+						uint8 layer = *src++;
+						const uint32 *table = recolour.GetRecolourTable(layer - 1);
+						uint8 opacity = *src++;
+						mode &= 0x3F;
+						for (; mode > 0; mode--) {
+							uint32 recoloured = table[*src++];
+							AddDecodedPixel(this, xpos, yoff, MakeRGBA(sf(GetR(recoloured)), sf(GetG(recoloured)), sf(GetB(recoloured)), opacity), true);
+							xpos++;
+						}
+						break;
+					}
+				}
+			}
+			src += 2; // Skip the length word.
+		}
+	}
+
+	this->spans.shrink_to_fit();
+	this->pixels.shrink_to_fit();
+}
+
+/**
+ * Constructor of the key of a decoded sprite.
+ * @param spr %Sprite being decoded.
+ * @param recolour Sprite recolouring definition.
+ * @param shift Gradient shift.
+ */
+SpriteCacheKey::SpriteCacheKey(const ImageData *spr, const Recolouring &recolour, GradientShift shift)
+{
+	this->sprite = spr;
+	this->recolour = 0;
+	for (int i = 0; i < MAX_RECOLOUR; i++) {
+		const RecolourEntry &re = recolour.entries[i];
+		this->recolour = (this->recolour << 16) | ((uint8)re.source << 8) | (uint8)re.dest;
+	}
+	this->shift = shift;
+}
+
+/**
+ * Compute the hash value of a key of a decoded sprite.
+ * @param key Key to hash.
+ * @return The hash value of the key.
+ */
+size_t SpriteCacheKeyHash::operator()(const SpriteCacheKey &key) const
+{
+	uint64 h = (uint64)(size_t)key.sprite;
+	h ^= key.recolour * 0x9E3779B97F4A7C15ULL;
+	h ^= (uint64)key.shift << 59;
+	return (size_t)(h ^ (h >> 29));
+}
+
+SpriteCache::SpriteCache() : hits(0), misses(0), budget(DEFAULT_SPRITE_CACHE_SIZE), used(0), batch(0), in_batch(false)
+{
+}
+
+SpriteCache::~SpriteCache()
+{
+	this->Clear();
+}
+
+/**
+ * Change the memory budget of the cache.
+ * @param budget New maximal amount of memory in bytes to use for decoded sprites. \c 0 disables the cache.
+ */
+void SpriteCache::SetBudget(size_t budget)
+{
+	this->budget = budget;
+	this->EvictTo(budget);
+}
+
+/** Drop all decoded sprites. */
+void SpriteCache::Clear()
+{
+	this->lookup.clear();
+	this->entries.clear();
+	this->used = 0;
+}
+
+/**
+ * Drop all decoded versions of a sprite, for example because its image data is released.
+ * @param spr %Sprite being removed.
+ */
+void SpriteCache::RemoveSprite(const ImageData *spr)
+{
+	CacheList::iterator iter = this->entries.begin();
+	while (iter != this->entries.end()) {
+		if (iter->key.sprite == spr) {
+			this->used -= iter->decoded.GetMemorySize();
+			this->lookup.erase(iter->key);
+			iter = this->entries.erase(iter);
+		} else {
+			++iter;
+		}
+	}
+}
+
+/**
+ * Remove least recently used entries until the used memory is at most \a limit.
+ * @param limit Maximal amount of memory in bytes that may remain in use.
+ */
+void SpriteCache::EvictTo(size_t limit)
+{
+	while (this->used > limit && !this->entries.empty()) {
+		const CacheEntry &ce = this->entries.back();
+		if (this->in_batch && ce.batch == this->batch) break; // All remaining entries are used in the current batch.
+
+		this->used -= ce.decoded.GetMemorySize();
+		this->lookup.erase(ce.key);
+		this->entries.pop_back();
+	}
+}
+
+/**
+ * Get the decoded version of a sprite, decoding it if needed.
+ * @param spr %Sprite to get.
+ * @param recolour Sprite recolouring definition.
+ * @param shift Gradient shift.
+ * @return The decoded sprite, or \c nullptr if the sprite should not be cached. Pointer is valid until the next call, or inside a batch until the end of the batch.
+ */
+const DecodedSprite *SpriteCache::Get(const ImageData *spr, const Recolouring &recolour, GradientShift shift)
+{
+	/* Do not let a single sprite take more than a quarter of the budget. */
+	if ((size_t)spr->width * spr->height * sizeof(uint32) > this->budget / 4) return nullptr;
+
+	SpriteCacheKey key(spr, recolour, shift);
+	CacheMap::iterator iter = this->lookup.find(key);
+	if (iter != this->lookup.end()) {
+		this->hits++;
+		this->entries.splice(this->entries.begin(), this->entries, iter->second);
+		iter->second->batch = this->batch;
+		return &iter->second->decoded;
+	}
+
+	this->misses++;
+	this->entries.push_front({key, DecodedSprite(), this->batch});
+	CacheEntry &ce = this->entries.front();
+	ce.decoded.Decode(spr, recolour, shift);
+	size_t size = ce.decoded.GetMemorySize();
+	this->lookup.emplace(key, this->entries.begin());
+	this->used += size;
+	this->EvictTo(std::max(this->budget, size));
+	return &ce.decoded;
+}
+
+/**
+ * Start a batch of lookups. Decoded sprites returned during the batch stay available until #EndBatch, even if that temporarily exceeds the budget.
+ * @note Batches cannot be nested.
+ */
+void SpriteCache::StartBatch()
+{
+	assert(!this->in_batch);
+	this->batch++;
+	this->in_batch = true;
+}
+
+/** End a batch of lookups, and return to the memory budget. */
+void SpriteCache::EndBatch()
+{
+	assert(this->in_batch);
+	this->in_batch = false;
+	this->EvictTo(this->budget);
+}
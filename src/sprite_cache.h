@@ -0,0 +1,147 @@
+/* $Id$ */
+
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file sprite_cache.h Cache of decoded sprites. */
+
+#ifndef SPRITE_CACHE_H
+#define SPRITE_CACHE_H
+
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include "palette.h"
+
+class ImageData;
+
+/**
+ * A horizontal run of pixels in a decoded sprite.
+ * @ingroup sprites_group
+ */
+struct DecodedSpan {
+	uint16 x;      ///< Horizontal offset of the first pixel, relative to the left edge of the sprite.
+	uint16 y;      ///< Row of the span, relative to the top edge of the sprite.
+	uint16 length; ///< Number of pixels in the span.
+	bool blend;    ///< If set, the alpha channel of the pixels is the opacity to blend with the background, else the pixels are copied.
+	uint32 first;  ///< Index of the first pixel of the span in DecodedSprite::pixels.
+};
+
+/**
+ * %Sprite with recolouring and gradient shift applied, ready for copying to the screen.
+ * @ingroup sprites_group
+ */
+class DecodedSprite {
+public:
+	void Decode(const ImageData *spr, const Recolouring &recolour, GradientShift shift);
+
+	/**
+	 * Get the amount of memory used by the decoded sprite.
+	 * @return Size of the decoded sprite data in bytes.
+	 */
+	inline size_t GetMemorySize() const
+	{
+		return sizeof(DecodedSprite) + this->spans.size() * sizeof(DecodedSpan) + this->pixels.size() * sizeof(uint32);
+	}
+
+	std::vector<DecodedSpan> spans; ///< Non-transparent parts of the sprite, ordered by row.
+	std::vector<uint32> pixels;     ///< Colours of the pixels of all #spans.
+};
+
+/**
+ * Key of a decoded sprite in the #SpriteCache.
+ * @ingroup sprites_group
+ */
+struct SpriteCacheKey {
+	SpriteCacheKey(const ImageData *spr, const Recolouring &recolour, GradientShift shift);
+
+	/**
+	 * Compare two keys for equality.
+	 * @param other Key to compare with.
+	 * @return Whether both keys denote the same decoded sprite.
+	 */
+	inline bool operator==(const SpriteCacheKey &other) const
+	{
+		return this->sprite == other.sprite && this->recolour == other.recolour && this->shift == other.shift;
+	}
+
+	const ImageData *sprite; ///< Sprite being decoded.
+	uint64 recolour;         ///< Source and destination colour ranges of all recolour entries.
+	GradientShift shift;     ///< Gradient shift applied to the sprite.
+};
+
+/**
+ * Hash function of the #SpriteCacheKey.
+ * @ingroup sprites_group
+ */
+struct SpriteCacheKeyHash {
+	size_t operator()(const SpriteCacheKey &key) const;
+};
+
+/**
+ * Least recently used cache of decoded sprites, limited by a memory budget.
+ * @ingroup sprites_group
+ */
+class SpriteCache {
+public:
+	SpriteCache();
+	~SpriteCache();
+
+	void SetBudget(size_t budget);
+	void Clear();
+	void RemoveSprite(const ImageData *spr);
+
+	const DecodedSprite *Get(const ImageData *spr, const Recolouring &recolour, GradientShift shift);
+
+	void StartBatch();
+	void EndBatch();
+
+	/**
+	 * Get the memory budget of the cache.
+	 * @return Maximal amount of memory in bytes used for decoded sprites.
+	 */
+	inline size_t GetBudget() const
+	{
+		return this->budget;
+	}
+
+	/**
+	 * Get the amount of memory currently in use by the cache.
+	 * @return Memory in use by decoded sprites in bytes.
+	 */
+	inline size_t GetUsed() const
+	{
+		return this->used;
+	}
+
+	uint64 hits;   ///< Number of lookups that found the decoded sprite in the cache.
+	uint64 misses; ///< Number of lookups that had to decode the sprite.
+
+private:
+	/** Entry in the cache. */
+	struct CacheEntry {
+		SpriteCacheKey key;    ///< Key of the decoded sprite.
+		DecodedSprite decoded; ///< The decoded sprite itself.
+		uint32 batch;          ///< Last batch that used the entry.
+	};
+
+	typedef std::list<CacheEntry> CacheList; ///< Entries of the cache, most recently used first.
+	typedef std::unordered_map<SpriteCacheKey, CacheList::iterator, SpriteCacheKeyHash> CacheMap; ///< Lookup table of the cache entries.
+
+	void EvictTo(size_t limit);
+
+	CacheList entries; ///< Cached decoded sprites, most recently used entry first.
+	CacheMap lookup;   ///< Lookup table for finding entries in #entries.
+	size_t budget;     ///< Maximal amount of memory in bytes to use for decoded sprites.
+	size_t used;       ///< Amount of memory in bytes currently in use by decoded sprites.
+	uint32 batch;      ///< Number of the current (or last) batch.
+	bool in_batch;     ///< Whether a batch is active, entries used in the batch are kept.
+};
+
+static const size_t DEFAULT_SPRITE_CACHE_SIZE = 16 * 1024 * 1024; ///< Default memory budget of the sprite cache in bytes.
+
+#endif
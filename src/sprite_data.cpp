@@ -16,10 +16,19 @@
 #include "bitmath.h"
 
 #include <vector>
-
-static const int MAX_IMAGE_COUNT = 5000; ///< Maximum number of images that can be loaded (arbitrary number).
+#include <algorithm>
 
 static std::vector<ImageData> _sprites;  ///< Available sprites to the program.
+static std::vector<ImageData> _zoomed_sprites; ///< Downsampled versions of #_sprites for the smaller tile widths.
+static std::vector<FileContentsPtr> _sprite_files; ///< Contents of the RCD files referenced by the image data of #_sprites.
+static std::vector<ImageArena> _sprite_arenas;    ///< Jump tables of the images of #_sprites.
+
+typedef std::pair<ImageData *, size_t> ResidentImage; ///< Downsampled image with pixels, and the amount of memory in bytes used by its pixels.
+
+static std::vector<ResidentImage> _resident_downsampled; ///< Downsampled images that have pixels.
+static size_t _downsampled_budget = SIZE_MAX; ///< Maximal amount of memory in bytes used by the pixels of downsampled images.
+static size_t _downsampled_used = 0;          ///< Amount of memory in bytes used by the pixels of downsampled images.
+static uint64 _downsampled_uses = 0;          ///< Number of uses of downsampled images, for finding the least recently used images.
 
 ImageData::ImageData()
 {
@@ -27,22 +36,78 @@ ImageData::ImageData()
 	this->height = 0;
 	this->table = nullptr;
 	this->data = nullptr;
+	this->storage = nullptr;
+	for (int i = 0; i < ZOOM_COUNT - 1; i++) this->zoomed[i] = nullptr;
+	this->source = nullptr;
+	this->zoom_factor = 1;
+	this->last_use = 0;
+}
+
+/**
+ * Move constructor, takes over the data of another image.
+ * @param other Image to take the data from, it becomes an empty image.
+ */
+ImageData::ImageData(ImageData &&other)
+{
+	this->flags = other.flags;
+	this->width = other.width;
+	this->height = other.height;
+	this->xoffset = other.xoffset;
+	this->yoffset = other.yoffset;
+	this->table = other.table;
+	this->data = other.data;
+	this->storage = other.storage;
+	for (int i = 0; i < ZOOM_COUNT - 1; i++) this->zoomed[i] = other.zoomed[i];
+	this->source = other.source;
+	this->zoom_factor = other.zoom_factor;
+	this->last_use = other.last_use;
+
+	other.width = 0;
+	other.height = 0;
+	other.table = nullptr;
+	other.data = nullptr;
+	other.storage = nullptr;
+	for (int i = 0; i < ZOOM_COUNT - 1; i++) other.zoomed[i] = nullptr;
+	other.source = nullptr;
 }
 
 ImageData::~ImageData()
 {
-	delete[] this->table;
-	delete[] this->data;
+	delete[] this->storage;
+}
+
+ImageArena::ImageArena() : next(nullptr), free_entries(0)
+{
+}
+
+/**
+ * Allocate memory for a jump table.
+ * @param count Number of entries of the table.
+ * @return The allocated memory. It is released when the arena is destroyed.
+ */
+uint32 *ImageArena::Allocate(size_t count)
+{
+	if (count > this->free_entries) {
+		size_t block_size = std::max(count, ARENA_BLOCK_SIZE);
+		this->blocks.emplace_back(new uint32[block_size]);
+		this->next = this->blocks.back().get();
+		this->free_entries = block_size;
+	}
+	uint32 *mem = this->next;
+	this->next += count;
+	this->free_entries -= count;
+	return mem;
 }
 
 /**
  * Load image data from the RCD file.
  * @param rcd_file File to load from.
  * @param length Length of the image data block.
+ * @param arena Memory to allocate the jump table from.
  * @return Load was successful.
  * @pre File pointer is at first byte of the block.
  */
-bool ImageData::Load8bpp(RcdFileReader *rcd_file, size_t length)
+bool ImageData::Load8bpp(RcdFileReader *rcd_file, size_t length, ImageArena *arena)
 {
 	if (length < 8) return false; // 2 bytes width, 2 bytes height, 2 bytes x-offset, and 2 bytes y-offset
 	this->width  = rcd_file->GetUInt16();
@@ -60,9 +125,7 @@ bool ImageData::Load8bpp(RcdFileReader *rcd_file, size_t length)
 	if (length <= jmp_table) return false; // You need at least place for the jump table.
 	length -= jmp_table;
 
-	this->table = new uint32[jmp_table / 4];
-	this->data  = new uint8[length];
-	if (this->table == nullptr || this->data == nullptr) return false;
+	this->table = arena->Allocate(this->height);
 
 	/* Load jump table, adjusting the entries while loading. */
 	for (uint i = 0; i < this->height; i++) {
@@ -76,7 +139,8 @@ bool ImageData::Load8bpp(RcdFileReader *rcd_file, size_t length)
 		this->table[i] = dest;
 	}
 
-	rcd_file->GetBlob(this->data, length); // Load the image data.
+	this->data = rcd_file->GetBlobAddress(length); // Use the image data in the file.
+	if (this->data == nullptr) return false;
 
 	/* Verify the image data. */
 	for (uint i = 0; i < this->height; i++) {
@@ -121,13 +185,12 @@ bool ImageData::Load32bpp(RcdFileReader *rcd_file, size_t length)
 	length -= 8;
 	if (length > 100 * 1024) return false; // Another arbitrary limit.
 
-	/* Allocate and load the image data. */
-	this->data = new uint8[length];
+	/* Use the image data in the file. */
+	this->data = rcd_file->GetBlobAddress(length);
 	if (this->data == nullptr) return false;
-	rcd_file->GetBlob(this->data, length);
 
 	/* Verify the data. */
-	uint8 *abs_end = this->data + length;
+	const uint8 *abs_end = this->data + length;
 	int line_count = 0;
 	const uint8 *ptr = this->data;
 	bool finished = false;
@@ -184,6 +247,7 @@ uint32 ImageData::GetPixel(uint16 xoffset, uint16 yoffset, const Recolouring *re
 {
 	if (xoffset >= this->width) return _palette[0];
 	if (yoffset >= this->height) return _palette[0];
+	this->RequirePixels();
 
 	if (GB(this->flags, IFG_IS_8BPP, 1) != 0) {
 		/* 8bpp image. */
@@ -258,34 +322,538 @@ uint32 ImageData::GetPixel(uint16 xoffset, uint16 yoffset, const Recolouring *re
 }
 
 /**
- * Load 8bpp or 32bpp sprite block from the \a rcd_file.
+ * Divide rounding towards negative infinity.
+ * @param value Value to divide.
+ * @param divisor Divisor, must be positive.
+ * @return Largest integer not larger than \a value / \a divisor.
+ */
+static inline int FloorDivide(int value, int divisor)
+{
+	return (value >= 0) ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+/** A pixel of an image being downsampled. */
+struct ZoomPixel {
+	uint8 kind;    ///< Kind of pixel, \c 0 is transparent, \c 1 is a plain colour, \c 2 is a recoloured pixel (32bpp only).
+	uint8 opacity; ///< Opacity of the pixel.
+	uint8 layer;   ///< Recolour layer of a recoloured pixel.
+	uint8 col[3];  ///< Red, green, and blue of a plain 32bpp pixel, palette index of an 8bpp pixel in col[0], or the recolour intensity in col[0].
+};
+
+/**
+ * Decode an 8bpp image into pixels.
+ * @param imd Image to decode.
+ * @param pixels [out] Pixels of the image, row by row.
+ */
+static void DecodeZoomPixels8bpp(const ImageData *imd, std::vector<ZoomPixel> &pixels)
+{
+	for (uint16 y = 0; y < imd->height; y++) {
+		uint32 offset = imd->table[y];
+		if (offset == INVALID_JUMP) continue;
+
+		uint16 xpos = 0;
+		for (;;) {
+			uint8 rel_off = imd->data[offset];
+			uint8 count = imd->data[offset + 1];
+			xpos += rel_off & 127;
+			for (uint8 i = 0; i < count; i++) {
+				ZoomPixel &zp = pixels[y * imd->width + xpos];
+				zp.kind = 1;
+				zp.opacity = OPAQUE;
+				zp.col[0] = imd->data[offset + 2 + i];
+				xpos++;
+			}
+			offset += 2 + count;
+			if ((rel_off & 128) != 0) break;
+		}
+	}
+}
+
+/**
+ * Decode a 32bpp image into pixels.
+ * @param imd Image to decode.
+ * @param pixels [out] Pixels of the image, row by row.
+ */
+static void DecodeZoomPixels32bpp(const ImageData *imd, std::vector<ZoomPixel> &pixels)
+{
+	const uint8 *src = imd->data + 2; // Skip the length word.
+	for (uint16 y = 0; y < imd->height; y++) {
+		ZoomPixel *zp = &pixels[y * imd->width];
+		for (;;) {
+			uint8 mode = *src++;
+			if (mode == 0) break;
+			uint8 count = mode & 0x3F;
+			switch (mode >> 6) {
+				case 0: // Fully opaque pixels.
+				case 1: { // Partial opaque pixels.
+					uint8 opacity = ((mode >> 6) == 0) ? OPAQUE : *src++;
+					for (; count > 0; count--) {
+						zp->kind = 1;
+						zp->opacity = opacity;
+						zp->col[0] = src[0];
+						zp->col[1] = src[1];
+						zp->col[2] = src[2];
+						zp++;
+						src += 3;
+					}
+					break;
+				}
+
+				case 2: // Fully transparent pixels.
+					zp += count;
+					break;
+
+				case 3: { // Recoloured pixels.
+					uint8 layer = *src++;
+					uint8 opacity = *src++;
+					for (; count > 0; count--) {
+						zp->kind = 2;
+						zp->opacity = opacity;
+						zp->layer = layer;
+						zp->col[0] = *src++;
+						zp++;
+					}
+					break;
+				}
+			}
+		}
+		src += 2; // Skip the length word.
+	}
+}
+
+/**
+ * Compute the distance between a palette colour and a colour.
+ * @param index Palette index of the first colour.
+ * @param rgb Red, green, and blue components of the second colour.
+ * @return Squared distance between both colours.
+ */
+static inline int GetPaletteDistance(int index, const int *rgb)
+{
+	int dr = GetR(_palette[index]) - rgb[0];
+	int dg = GetG(_palette[index]) - rgb[1];
+	int db = GetB(_palette[index]) - rgb[2];
+	return dr * dr + dg * dg + db * db;
+}
+
+/**
+ * Compute a pixel of a downsampled image from a box of pixels of the original image (box filter).
+ * The result is transparent unless at least half of the box is covered, such that tiles meeting each other stay closed.
+ * @param box Pixels of the box (transparent pixels may be left out).
+ * @param area Number of pixels of the full box.
+ * @param is_8bpp Whether the pixels are palette indices.
+ * @return The downsampled pixel.
+ */
+static ZoomPixel FilterZoomPixels(const std::vector<ZoomPixel> &box, int area, bool is_8bpp)
+{
+	ZoomPixel result = {0, 0, 0, {0, 0, 0}};
+	if (box.size() * 2 < (size_t)area) return result;
+
+	/* Use the kind (and recolour layer) of the majority of the pixels. */
+	result.kind = 1;
+	int best_count = 0;
+	for (const ZoomPixel &zp : box) {
+		if (zp.kind == 1) best_count++;
+	}
+	for (const ZoomPixel &zp : box) {
+		if (zp.kind != 2) continue;
+		int count = 0;
+		for (const ZoomPixel &other : box) {
+			if (other.kind == 2 && other.layer == zp.layer) count++;
+		}
+		if (count > best_count) {
+			result.kind = 2;
+			result.layer = zp.layer;
+			best_count = count;
+		}
+	}
+
+	int count = 0;
+	int opacity = 0;
+	int sum[3] = {0, 0, 0};
+	int common = -1; // Most common palette index.
+	int common_count = 0;
+	for (const ZoomPixel &zp : box) {
+		if (zp.kind != result.kind || (zp.kind == 2 && zp.layer != result.layer)) continue;
+		count++;
+		opacity += zp.opacity;
+		if (is_8bpp) {
+			uint32 colour = _palette[zp.col[0]];
+			sum[0] += GetR(colour);
+			sum[1] += GetG(colour);
+			sum[2] += GetB(colour);
+
+			int index_count = 0;
+			for (const ZoomPixel &other : box) {
+				if (other.col[0] == zp.col[0]) index_count++;
+			}
+			if (index_count > common_count) {
+				common = zp.col[0];
+				common_count = index_count;
+			}
+		} else {
+			for (int i = 0; i < 3; i++) sum[i] += zp.col[i];
+		}
+	}
+	result.opacity = (opacity + count / 2) / count;
+	for (int i = 0; i < 3; i++) sum[i] = (sum[i] + count / 2) / count;
+
+	if (!is_8bpp) {
+		for (int i = 0; i < 3; i++) result.col[i] = sum[i];
+		return result;
+	}
+
+	/* Palette image, keep the pixel in the colour series of the most common index so recolouring still works,
+	 * or use one of the indices of the box if it is not in a series. */
+	result.col[0] = common;
+	int best_dist = GetPaletteDistance(common, sum);
+	if (common >= COL_SERIES_START && common < COL_SERIES_END) {
+		int first = COL_SERIES_START + (common - COL_SERIES_START) / COL_SERIES_LENGTH * COL_SERIES_LENGTH;
+		for (int i = first; i < first + COL_SERIES_LENGTH; i++) {
+			int dist = GetPaletteDistance(i, sum);
+			if (dist < best_dist) {
+				result.col[0] = i;
+				best_dist = dist;
+			}
+		}
+	} else {
+		for (const ZoomPixel &zp : box) {
+			int dist = GetPaletteDistance(zp.col[0], sum);
+			if (dist < best_dist) {
+				result.col[0] = zp.col[0];
+				best_dist = dist;
+			}
+		}
+	}
+	return result;
+}
+
+/**
+ * Encode a row of pixels as 8bpp image data.
+ * @param row Pixels of the row.
+ * @param width Number of pixels in the row.
+ * @param data [inout] Image data to append the row to.
+ * @return Whether the row has non-transparent pixels (else nothing is appended).
+ */
+static bool EncodeRow8bpp(const ZoomPixel *row, int width, std::vector<uint8> &data)
+{
+	size_t last = SIZE_MAX; // Offset of the last run in the row.
+	int x = 0;
+	int gap = 0;
+	while (x < width) {
+		if (row[x].kind == 0) {
+			gap++;
+			x++;
+			continue;
+		}
+		while (gap > 127) { // Gap too long, insert an empty run.
+			data.push_back(127);
+			data.push_back(0);
+			gap -= 127;
+		}
+		last = data.size();
+		data.push_back(gap);
+		data.push_back(0);
+		gap = 0;
+		while (x < width && row[x].kind != 0 && data[last + 1] < 255) {
+			data.push_back(row[x].col[0]);
+			data[last + 1]++;
+			x++;
+		}
+	}
+	if (last == SIZE_MAX) return false;
+	data[last] |= 128;
+	return true;
+}
+
+/**
+ * Encode a row of pixels as 32bpp image data.
+ * @param row Pixels of the row.
+ * @param width Number of pixels in the row.
+ * @param data [inout] Image data to append the row to (excluding the length word).
+ */
+static void EncodeRow32bpp(const ZoomPixel *row, int width, std::vector<uint8> &data)
+{
+	/* Trailing transparent pixels need not be stored. */
+	while (width > 0 && row[width - 1].kind == 0) width--;
+
+	int x = 0;
+	while (x < width) {
+		const ZoomPixel &first = row[x];
+		int count = 1;
+		while (x + count < width && count < 63) {
+			const ZoomPixel &zp = row[x + count];
+			if (zp.kind != first.kind) break;
+			if (zp.kind != 0 && zp.opacity != first.opacity) break;
+			if (zp.kind == 2 && zp.layer != first.layer) break;
+			count++;
+		}
+
+		switch (first.kind) {
+			case 0:
+				data.push_back((2 << 6) | count);
+				break;
+
+			case 1:
+				if (first.opacity == OPAQUE) {
+					data.push_back(count);
+				} else {
+					data.push_back((1 << 6) | count);
+					data.push_back(first.opacity);
+				}
+				for (int i = 0; i < count; i++) data.insert(data.end(), row[x + i].col, row[x + i].col + 3);
+				break;
+
+			case 2:
+				data.push_back((3 << 6) | count);
+				data.push_back(first.layer);
+				data.push_back(first.opacity);
+				for (int i = 0; i < count; i++) data.push_back(row[x + i].col[0]);
+				break;
+		}
+		x += count;
+	}
+	data.push_back(0);
+}
+
+/**
+ * Make this image a downsampled version of another image.
+ * Only the size of the image is computed here, its pixels are created when they are needed, see #RequirePixels.
+ * @param src Image to downsample.
+ * @param factor Downsampling factor, the new image is \a factor times smaller in both directions.
+ */
+void ImageData::SetDownsampled(const ImageData *src, int factor)
+{
+	this->DropPixels();
+	this->flags = src->flags;
+	this->xoffset = FloorDivide(src->xoffset, factor);
+	this->yoffset = FloorDivide(src->yoffset, factor);
+	this->width = FloorDivide(src->xoffset + src->width - 1, factor) - this->xoffset + 1;
+	this->height = FloorDivide(src->yoffset + src->height - 1, factor) - this->yoffset + 1;
+	this->source = src;
+	this->zoom_factor = factor;
+}
+
+/**
+ * Create the pixels of a downsampled image.
+ * The pixels are averaged in boxes aligned at the sprite origin, so adjacent sprites stay aligned after downsampling.
+ * @return Amount of memory in bytes used by the pixels.
+ * @pre The image is set up by #SetDownsampled, and has no pixels.
+ */
+size_t ImageData::CreateDownsampledPixels()
+{
+	const ImageData *src = this->source;
+	int factor = this->zoom_factor;
+	bool is_8bpp = GB(src->flags, IFG_IS_8BPP, 1) != 0;
+	std::vector<ZoomPixel> pixels(src->width * src->height, ZoomPixel{0, 0, 0, {0, 0, 0}});
+	if (is_8bpp) {
+		DecodeZoomPixels8bpp(src, pixels);
+	} else {
+		DecodeZoomPixels32bpp(src, pixels);
+	}
+
+	int left = this->xoffset;
+	int top = this->yoffset;
+	int width = this->width;
+	int height = this->height;
+
+	std::vector<ZoomPixel> result(width * height);
+	std::vector<ZoomPixel> box;
+	for (int y = 0; y < height; y++) {
+		int y0 = std::max((top + y) * factor - src->yoffset, 0);
+		int y1 = std::min((top + y + 1) * factor - src->yoffset, (int)src->height);
+		for (int x = 0; x < width; x++) {
+			int x0 = std::max((left + x) * factor - src->xoffset, 0);
+			int x1 = std::min((left + x + 1) * factor - src->xoffset, (int)src->width);
+			box.clear();
+			for (int sy = y0; sy < y1; sy++) {
+				for (int sx = x0; sx < x1; sx++) {
+					const ZoomPixel &zp = pixels[sy * src->width + sx];
+					if (zp.kind != 0) box.push_back(zp);
+				}
+			}
+			result[y * width + x] = FilterZoomPixels(box, factor * factor, is_8bpp);
+		}
+	}
+
+	std::vector<uint32> table;
+	std::vector<uint8> data;
+	if (is_8bpp) {
+		table.resize(height);
+		for (int y = 0; y < height; y++) {
+			size_t offset = data.size();
+			table[y] = EncodeRow8bpp(&result[y * width], width, data) ? offset : INVALID_JUMP;
+		}
+		if (data.empty()) data.push_back(0); // Completely transparent image.
+	} else {
+		for (int y = 0; y < height; y++) {
+			size_t start = data.size();
+			data.push_back(0); // Length word, filled in below.
+			data.push_back(0);
+			EncodeRow32bpp(&result[y * width], width, data);
+			if (y + 1 < height) { // The last row has length 0.
+				size_t length = data.size() - start;
+				data[start] = length & 0xFF;
+				data[start + 1] = length >> 8;
+			}
+		}
+	}
+
+	/* Store the jump table and the image data in a single allocation. */
+	size_t table_size = table.size() * sizeof(uint32);
+	this->storage = new uint8[table_size + data.size()];
+	if (is_8bpp) {
+		this->table = reinterpret_cast<uint32 *>(this->storage);
+		std::copy(table.begin(), table.end(), this->table);
+	}
+	std::copy(data.begin(), data.end(), this->storage + table_size);
+	this->data = this->storage + table_size;
+
+	return table_size + data.size();
+}
+
+/** Release the pixels of a downsampled image, they are created again when they are needed. */
+void ImageData::DropPixels()
+{
+	delete[] this->storage;
+	this->storage = nullptr;
+	this->table = nullptr;
+	this->data = nullptr;
+}
+
+/**
+ * Drop the pixels of the least recently used downsampled images.
+ * @param limit Maximal amount of memory in bytes that may remain in use.
+ * @param keep Image that must keep its pixels.
+ */
+static void EvictDownsampledImages(size_t limit, const ImageData *keep)
+{
+	/* Sort the most recently used images to the front. */
+	std::sort(_resident_downsampled.begin(), _resident_downsampled.end(),
+			[](const ResidentImage &a, const ResidentImage &b) { return a.first->last_use > b.first->last_use; });
+
+	while (_downsampled_used > limit && !_resident_downsampled.empty()) {
+		const ResidentImage &ri = _resident_downsampled.back();
+		if (ri.first == keep) break;
+
+		ri.first->DropPixels();
+		_downsampled_used -= ri.second;
+		_resident_downsampled.pop_back();
+	}
+}
+
+/** Mark a downsampled image as used, and create its pixels if it does not have them. */
+void ImageData::UseDownsampledPixels() const
+{
+	ImageData *imd = const_cast<ImageData *>(this);
+	imd->last_use = ++_downsampled_uses;
+	if (this->data != nullptr) return;
+
+	size_t size = imd->CreateDownsampledPixels();
+	_resident_downsampled.emplace_back(imd, size);
+	_downsampled_used += size;
+	if (_downsampled_used > _downsampled_budget) EvictDownsampledImages(_downsampled_budget - _downsampled_budget / 4, imd);
+}
+
+/**
+ * Change the maximal amount of memory used by the pixels of downsampled images.
+ * @param budget Maximal amount of memory in bytes, when more is needed the least recently used images drop their pixels.
+ */
+void SetDownsampledImagesBudget(size_t budget)
+{
+	_downsampled_budget = budget;
+	if (_downsampled_used > budget) EvictDownsampledImages(budget, nullptr);
+}
+
+/**
+ * Get the amount of memory used by the pixels of downsampled images.
+ * @return Memory in use by downsampled images in bytes.
+ */
+size_t GetDownsampledImagesMemory()
+{
+	return _downsampled_used;
+}
+
+/**
+ * Decode and verify an 8bpp or 32bpp sprite block from the \a rcd_file, without making it available to the program.
+ * Images of different files may be decoded at the same time.
  * @param rcd_file File being loaded.
- * @return Loaded sprite, if loading was successful, else \c nullptr.
+ * @param imd [out] Image to decode the block into.
+ * @param arena Memory of the file, for allocating the jump table of the image.
+ * @return Whether decoding was successful.
+ * @see AddImage
  */
-ImageData *LoadImage(RcdFileReader *rcd_file)
+bool DecodeImage(RcdFileReader *rcd_file, ImageData *imd, ImageArena *arena)
 {
 	bool is_8bpp = strcmp(rcd_file->name, "8PXL") == 0;
-	if (rcd_file->version != (is_8bpp ? 2 : 1)) return nullptr;
-
-	_sprites.emplace_back();
-	ImageData *imd = &_sprites.back();
-	bool loaded = is_8bpp ? imd->Load8bpp(rcd_file, rcd_file->size) : imd->Load32bpp(rcd_file, rcd_file->size);
-	if (!loaded) {
-		_sprites.pop_back();
-		return nullptr;
-	}
+	if (rcd_file->version != (is_8bpp ? 2 : 1)) return false;
+
+	bool loaded = is_8bpp ? imd->Load8bpp(rcd_file, rcd_file->size, arena) : imd->Load32bpp(rcd_file, rcd_file->size);
+	if (!loaded) return false;
 	imd->flags = is_8bpp ? (1 << IFG_IS_8BPP) : 0;
-	return imd;
+	return true;
+}
+
+/**
+ * Make a decoded image available to the program.
+ * @param imd Image decoded by #DecodeImage, its data is moved to the image storage.
+ * @param rcd_file File containing the image.
+ * @return The stored image.
+ */
+ImageData *AddImage(ImageData *imd, RcdFileReader *rcd_file)
+{
+	assert(_sprites.size() < _sprites.capacity()); // Stored images may not move.
+	_sprites.emplace_back(std::move(*imd));
+
+	/* Keep the file contents available, as long as the image exists. */
+	if (_sprite_files.empty() || _sprite_files.back() != rcd_file->GetContents()) _sprite_files.push_back(rcd_file->GetContents());
+	return &_sprites.back();
 }
 
-/** Initialize image storage. */
-void InitImageStorage()
+/**
+ * Keep the memory of the images of an RCD file.
+ * @param arena Memory used by the images of the file.
+ */
+void AddImageArena(ImageArena &&arena)
+{
+	_sprite_arenas.push_back(std::move(arena));
+}
+
+/**
+ * Create the downsampled versions of all loaded images, for displaying the world at the smaller tile widths.
+ * The pixels of the downsampled images are created when the images are used.
+ * @pre The downsampled images have not been created yet.
+ */
+void CreateZoomedImages()
+{
+	assert(_zoomed_sprites.empty());
+	_zoomed_sprites.resize(_sprites.size() * (ZOOM_COUNT - 1));
+
+	ImageData *zoomed = _zoomed_sprites.data();
+	for (ImageData &imd : _sprites) {
+		for (int level = 1; level < ZOOM_COUNT; level++) {
+			imd.zoomed[level - 1] = zoomed;
+			zoomed->SetDownsampled(&imd, 1 << level);
+			zoomed++;
+		}
+	}
+}
+
+/**
+ * Initialize image storage.
+ * @param count Number of images that will be loaded.
+ */
+void InitImageStorage(size_t count)
 {
-	_sprites.reserve(MAX_IMAGE_COUNT);
+	_sprites.reserve(count);
 }
 
 /** Clear all memory. */
 void DestroyImageStorage()
 {
+	_resident_downsampled.clear();
+	_downsampled_used = 0;
+	_zoomed_sprites.clear();
 	_sprites.clear();
+	_sprite_files.clear();
+	_sprite_arenas.clear();
 }
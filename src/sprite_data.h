@@ -12,15 +12,51 @@
 #ifndef SPRITE_DATA_H
 #define SPRITE_DATA_H
 
+#include <vector>
+#include <memory>
+
 static const uint32 INVALID_JUMP = UINT32_MAX; ///< Invalid jump destination in image data.
 
 class RcdFileReader;
 
+static const uint16 BASE_TILE_WIDTH = 64; ///< Tile width of the sprites in the RCD files.
+static const int ZOOM_COUNT = 3;          ///< Number of zoom levels, tile widths 64, 32, and 16.
+
+/**
+ * Get the zoom level of a tile width.
+ * @param tile_width Width of a tile in pixels.
+ * @return Zoom level, \c 0 is the size of the RCD files, every next level halves the size of the sprites.
+ */
+static inline int GetZoomLevel(uint16 tile_width)
+{
+	int level = 0;
+	while (level < ZOOM_COUNT - 1 && (BASE_TILE_WIDTH >> level) > tile_width) level++;
+	return level;
+}
+
 /** Flags of an image in #ImageData. */
 enum ImageFlags {
 	IFG_IS_8BPP = 0, ///< Bit number used for the image type.
 };
 
+static const size_t ARENA_BLOCK_SIZE = 16384; ///< Number of jump table entries in a block of an #ImageArena.
+
+/**
+ * Memory for the jump tables of the images of an RCD file, allocated in large blocks.
+ * @ingroup sprites_group
+ */
+class ImageArena {
+public:
+	ImageArena();
+
+	uint32 *Allocate(size_t count);
+
+private:
+	std::vector<std::unique_ptr<uint32[]>> blocks; ///< Allocated blocks of memory.
+	uint32 *next;        ///< First free entry in the last block.
+	size_t free_entries; ///< Number of free entries in the last block.
+};
+
 /**
  * Image data of 8bpp images.
  * @ingroup sprites_group
@@ -28,12 +64,39 @@ enum ImageFlags {
 class ImageData {
 public:
 	ImageData();
+	ImageData(ImageData &&other);
+	ImageData(const ImageData &) = delete;
+	ImageData &operator=(const ImageData &) = delete;
 	~ImageData();
 
-	bool Load8bpp(RcdFileReader *rcd_file, size_t length);
+	bool Load8bpp(RcdFileReader *rcd_file, size_t length, ImageArena *arena);
 	bool Load32bpp(RcdFileReader *rcd_file, size_t length);
 
 	uint32 GetPixel(uint16 xoffset, uint16 yoffset, const Recolouring *recolour = nullptr, GradientShift shift = GS_NORMAL) const;
+	void SetDownsampled(const ImageData *src, int factor);
+	void DropPixels();
+
+	/**
+	 * Make sure the pixels of the image are available, before accessing #table or #data.
+	 * Downsampled images create their pixels when they are used for the first time, and may drop them again when they are not used.
+	 * @note Only call this from the main thread.
+	 */
+	inline void RequirePixels() const
+	{
+		if (this->source != nullptr) this->UseDownsampledPixels();
+	}
+
+	/**
+	 * Get the version of the image for a tile width.
+	 * @param tile_width Width of a tile in pixels.
+	 * @return The downsampled image for the tile width, or the image itself if no smaller version exists.
+	 */
+	inline const ImageData *GetZoomed(uint16 tile_width) const
+	{
+		int level = GetZoomLevel(tile_width);
+		if (level == 0 || this->zoomed[level - 1] == nullptr) return this;
+		return this->zoomed[level - 1];
+	}
 
 	/**
 	 * Is the sprite just a single pixel?
@@ -50,12 +113,28 @@ public:
 	int16 xoffset; ///< Horizontal offset of the image.
 	int16 yoffset; ///< Vertical offset of the image.
 	uint32 *table; ///< The jump table. For missing entries, #INVALID_JUMP is used.
-	uint8 *data;   ///< The image data itself.
+	const uint8 *data; ///< The image data itself.
+	uint8 *storage;    ///< Memory allocated by the image for #table and #data, \c nullptr if they point into an #ImageArena and the contents of the RCD file.
+	ImageData *zoomed[ZOOM_COUNT - 1]; ///< Downsampled versions of the image for the smaller tile widths, \c nullptr if not available.
+
+	const ImageData *source; ///< Image that this image is a downsampled version of, \c nullptr for images of the RCD files.
+	int zoom_factor;         ///< Downsampling factor of #source.
+	uint64 last_use;         ///< Moment of the last use of the pixels of a downsampled image. @see RequirePixels
+
+private:
+	void UseDownsampledPixels() const;
+	size_t CreateDownsampledPixels();
 };
 
-ImageData *LoadImage(RcdFileReader *rcd_file);
+bool DecodeImage(RcdFileReader *rcd_file, ImageData *imd, ImageArena *arena);
+ImageData *AddImage(ImageData *imd, RcdFileReader *rcd_file);
+void AddImageArena(ImageArena &&arena);
+
+void CreateZoomedImages();
+void SetDownsampledImagesBudget(size_t budget);
+size_t GetDownsampledImagesMemory();
 
-void InitImageStorage();
+void InitImageStorage(size_t count);
 void DestroyImageStorage();
 
 #endif
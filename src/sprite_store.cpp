@@ -27,6 +27,7 @@
 #include "shop_type.h"
 #include "coaster.h"
 #include "gui_sprites.h"
+#include "worker_pool.h"
 
 SpriteManager _sprite_manager; ///< Sprite manager.
 GuiSprites _gui_sprites;       ///< GUI sprites.
@@ -1286,7 +1287,7 @@ void SpriteStorage::AddFence(Fence *fnc)
 }
 
 /** Sprite manager constructor. */
-SpriteManager::SpriteManager() : store(64)
+SpriteManager::SpriteManager() : store(64), half_store(32), quarter_store(16)
 {
 	_gui_sprites.Clear();
 	this->blocks = nullptr;
@@ -1305,16 +1306,49 @@ SpriteManager::~SpriteManager()
 	/* Sprite stores will be deleted soon as well. */
 }
 
+/** Images of an RCD file, decoded before the other blocks of the file are loaded. */
+struct RcdFileImages {
+	FileContentsPtr contents;         ///< Contents of the RCD file, \c nullptr if the file could not be read.
+	std::map<uint, ImageData> images; ///< Decoded image blocks of the file, by block number.
+	ImageArena arena;                 ///< Memory of the decoded images.
+};
+
+/**
+ * Decode the image blocks of an RCD file.
+ * Decoding stops at the first invalid image block, #SpriteManager::Load reports the error.
+ * Different files may be decoded at the same time, as nothing is stored in the program yet.
+ * @param rfi RCD file to decode, its block directory is used to find the images.
+ * @param file_images [out] Contents of the file and its decoded images.
+ */
+static void DecodeRcdImages(const RcdFileInfo &rfi, RcdFileImages *file_images)
+{
+	RcdFileReader rcd_file(rfi.path.c_str());
+	file_images->contents = rcd_file.GetContents();
+	if (!rcd_file.CheckFileHeader("RCDF", 2)) return;
+
+	for (size_t i = 0; i < rfi.blocks.size(); i++) {
+		const RcdBlockInfo &bi = rfi.blocks[i];
+		if (strcmp(bi.name, "8PXL") != 0 && strcmp(bi.name, "32PX") != 0) continue;
+
+		uint blk_num = i + 1;
+		if (!rcd_file.SetPosition(bi.offset) || !rcd_file.ReadBlockHeader() || strcmp(rcd_file.name, bi.name) != 0 ||
+				!DecodeImage(&rcd_file, &file_images->images[blk_num], &file_images->arena)) {
+			file_images->images.erase(blk_num);
+			return;
+		}
+	}
+}
+
 /**
  * Load sprites from the disk.
- * @param filename Name of the RCD file to load.
+ * @param file_images Contents of the RCD file to load, with its images decoded by #DecodeRcdImages.
  * @return Error message if load failed, else \c nullptr.
  * @todo Try to re-use already loaded blocks.
  * @todo Code will use last loaded surface as grass.
  */
-const char *SpriteManager::Load(const char *filename)
+const char *SpriteManager::Load(RcdFileImages *file_images)
 {
-	RcdFileReader rcd_file(filename);
+	RcdFileReader rcd_file(file_images->contents);
 	if (!rcd_file.CheckFileHeader("RCDF", 2)) return "Bad header";
 
 	ImageMap sprites; // Sprites loaded from this file.
@@ -1332,10 +1366,12 @@ const char *SpriteManager::Load(const char *filename)
 		}
 
 		if (strcmp(rcd_file.name, "8PXL") == 0 || strcmp(rcd_file.name, "32PX") == 0) {
-			ImageData *imd = LoadImage(&rcd_file);
-			if (imd == nullptr) {
+			auto iter = file_images->images.find(blk_num);
+			if (iter == file_images->images.end()) {
 				return "Image data loading failed";
 			}
+			if (!rcd_file.SkipBytes(rcd_file.size)) return "Image data loading failed";
+			ImageData *imd = AddImage(&iter->second, &rcd_file);
 			std::pair<uint, ImageData *> p(blk_num, imd);
 			sprites.insert(p);
 			continue;
@@ -1529,14 +1565,135 @@ SpriteStorage *SpriteManager::GetSpriteStore(uint16 width)
 	return nullptr;
 }
 
+/**
+ * Get the version of an image for a tile width.
+ * @param imd Image to convert (may be \c nullptr).
+ * @param width Tile width of the sprite storage.
+ * @return Image for the tile width, or \c nullptr if \a imd is \c nullptr.
+ */
+static ImageData *GetZoomedImage(ImageData *imd, uint16 width)
+{
+	if (imd == nullptr) return nullptr;
+	return const_cast<ImageData *>(imd->GetZoomed(width));
+}
+
+/**
+ * Replace images by their version for a tile width.
+ * @tparam N Number of images.
+ * @param images [inout] Images to replace.
+ * @param width Tile width of the sprite storage.
+ */
+template <size_t N>
+static void ZoomImages(ImageData *(&images)[N], uint16 width)
+{
+	for (size_t i = 0; i < N; i++) images[i] = GetZoomedImage(images[i], width);
+}
+
+/**
+ * Fill a sprite storage with the downsampled sprites of the sprite storage of size 64.
+ * @param dest Sprite storage to fill, its #SpriteStorage::size decides the size of the sprites.
+ * @pre The downsampled images have been created, see #CreateZoomedImages.
+ */
+void SpriteManager::FillZoomedStore(SpriteStorage *dest)
+{
+	const SpriteStorage &src = this->store;
+	uint16 width = dest->size;
+
+	for (int i = 0; i < GTP_COUNT; i++) {
+		dest->surface[i] = src.surface[i];
+		ZoomImages(dest->surface[i].surface, width);
+	}
+	for (int i = 0; i < FDT_COUNT; i++) {
+		dest->foundation[i] = src.foundation[i];
+		ZoomImages(dest->foundation[i].sprites, width);
+	}
+	dest->platform = src.platform;
+	ZoomImages(dest->platform.flat, width);
+	ZoomImages(dest->platform.ramp, width);
+	ZoomImages(dest->platform.right_ramp, width);
+	ZoomImages(dest->platform.left_ramp, width);
+	dest->support = src.support;
+	ZoomImages(dest->support.sprites, width);
+	dest->tile_select = src.tile_select;
+	ZoomImages(dest->tile_select.surface, width);
+	dest->tile_corners = src.tile_corners;
+	for (int i = 0; i < VOR_NUM_ORIENT; i++) ZoomImages(dest->tile_corners.sprites[i], width);
+	for (int i = 0; i < PAT_COUNT; i++) {
+		dest->path_sprites[i] = src.path_sprites[i];
+		ZoomImages(dest->path_sprites[i].sprites, width);
+	}
+
+	PathDecoration &pdec = dest->path_decoration;
+	pdec = src.path_decoration;
+	ZoomImages(pdec.litterbin, width);
+	ZoomImages(pdec.overflow_bin, width);
+	ZoomImages(pdec.demolished_bin, width);
+	ZoomImages(pdec.lamp_post, width);
+	ZoomImages(pdec.demolished_lamp, width);
+	ZoomImages(pdec.bench, width);
+	ZoomImages(pdec.demolished_bench, width);
+	ZoomImages(pdec.flat_litter, width);
+	ZoomImages(pdec.flat_vomit, width);
+	for (int i = 0; i < 4; i++) {
+		ZoomImages(pdec.ramp_litter[i], width);
+		ZoomImages(pdec.ramp_vomit[i], width);
+	}
+
+	dest->build_arrows = src.build_arrows;
+	ZoomImages(dest->build_arrows.sprites, width);
+
+	/* Fences and animation sprites are RCD blocks, make zoomed copies of them. */
+	for (int i = 0; i < FENCE_TYPE_COUNT; i++) {
+		if (src.fence[i] == nullptr) continue;
+
+		Fence *fnc = new Fence;
+		fnc->type = src.fence[i]->type;
+		fnc->width = width;
+		std::copy(src.fence[i]->sprites, src.fence[i]->sprites + FENCE_COUNT, fnc->sprites);
+		ZoomImages(fnc->sprites, width);
+		this->AddBlock(fnc);
+		dest->AddFence(fnc);
+	}
+	for (const auto &iter : src.animations) {
+		const AnimationSprites *src_anim = iter.second;
+		AnimationSprites *an_spr = new AnimationSprites;
+		an_spr->width = width;
+		an_spr->person_type = src_anim->person_type;
+		an_spr->anim_type = src_anim->anim_type;
+		an_spr->frame_count = src_anim->frame_count;
+		an_spr->sprites = new ImageData *[an_spr->frame_count];
+		for (uint j = 0; j < an_spr->frame_count; j++) an_spr->sprites[j] = GetZoomedImage(src_anim->sprites[j], width);
+		this->AddBlock(an_spr);
+		dest->AddAnimationSprites(an_spr);
+	}
+}
+
 /** Load all useful RCD files found by #_rcd_collection, into the program. */
 void SpriteManager::LoadRcdFiles()
 {
-	for (auto &entry : _rcd_collection.rcdfiles) {
-		const char *fname = entry.second.path.c_str();
-		const char *mesg = this->Load(fname);
-		if (mesg != nullptr) fprintf(stderr, "Error while reading \"%s\": %s\n", fname, mesg);
+	std::vector<const RcdFileInfo *> files;
+	for (const auto &entry : _rcd_collection.rcdfiles) files.push_back(&entry.second);
+
+	/* Decoding and verifying the images is done for all files at the same time.
+	 * The blocks are stored in the program one file at a time, to keep the order of loading the same. */
+	std::vector<RcdFileImages> file_images(files.size());
+	_worker_pool.Run(files.size(), [&files, &file_images](int i) { DecodeRcdImages(*files[i], &file_images[i]); });
+
+	size_t image_count = 0;
+	for (const RcdFileImages &fi : file_images) image_count += fi.images.size();
+	InitImageStorage(image_count);
+
+	for (size_t i = 0; i < files.size(); i++) {
+		const char *mesg = this->Load(&file_images[i]);
+		if (mesg != nullptr) fprintf(stderr, "Error while reading \"%s\": %s\n", files[i]->path.c_str(), mesg);
+		file_images[i].images.clear();
+		AddImageArena(std::move(file_images[i].arena));
 	}
+
+	/* Generate the sprites for the smaller tile widths. */
+	CreateZoomedImages();
+	this->FillZoomedStore(&this->half_store);
+	this->FillZoomedStore(&this->quarter_store);
 }
 
 /**
@@ -1553,12 +1710,16 @@ void SpriteManager::AddBlock(RcdBlock *block)
  * Get a sprite store of a given size.
  * @param size Requested size.
  * @return Sprite store with sprites of the requested size, if it exists, else \c nullptr.
- * @todo Add support for other sprite sizes as well.
+ * @note Only the sprites of size 64 are loaded, the other sizes are downsampled from them.
  */
 const SpriteStorage *SpriteManager::GetSprites(uint16 size) const
 {
-	if (size != 64) return nullptr;
-	return &this->store;
+	switch (size) {
+		case 64: return &this->store;
+		case 32: return &this->half_store;
+		case 16: return &this->quarter_store;
+		default: return nullptr;
+	}
 }
 
 /**
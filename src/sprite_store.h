@@ -26,6 +26,7 @@ extern const uint8 _slope_rotation[NUM_SLOPE_SPRITES][4];
 
 class RcdFileReader;
 class ImageData;
+struct RcdFileImages;
 
 /**
  * Block of data from a RCD file.
@@ -627,13 +628,15 @@ public:
 	PathStatus GetPathStatus(PathType path_type);
 
 protected:
-	const char *Load(const char *fname);
+	const char *Load(RcdFileImages *file_images);
 	SpriteStorage *GetSpriteStore(uint16 width);
 
 	RcdBlock *blocks;         ///< List of loaded RCD data blocks.
 
-	SpriteStorage store;      ///< Sprite storage of size 64.
-	AnimationsMap animations; ///< Available animations.
+	SpriteStorage store;         ///< Sprite storage of size 64.
+	SpriteStorage half_store;    ///< Sprite storage of size 32, downsampled from #store.
+	SpriteStorage quarter_store; ///< Sprite storage of size 16, downsampled from #store.
+	AnimationsMap animations;    ///< Available animations.
 
 private:
 	bool LoadSURF(RcdFileReader *rcd_file, const ImageMap &sprites);
@@ -647,6 +650,7 @@ private:
 	bool LoadSUPP(RcdFileReader *rcd_file, const ImageMap &sprites);
 
 	void SetSpriteSize(uint16 start, uint16 end, Rectangle16 &rect);
+	void FillZoomedStore(SpriteStorage *dest);
 };
 
 bool LoadSpriteFromFile(RcdFileReader *rcd_file, const ImageMap &sprites, ImageData **spr);
@@ -0,0 +1,178 @@
+/* $Id$ */
+
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file text_cache.cpp Cache of rendered texts. */
+
+#include "stdafx.h"
+#include "text_cache.h"
+
+RenderedText::RenderedText() : size_width(0), size_height(0), size_valid(false), width(0), height(0), rendered(false)
+{
+}
+
+/**
+ * Get the amount of memory used by a cache entry.
+ * @param text Text of the entry.
+ * @param data Size and rendering of the text.
+ * @return Size of the entry in bytes.
+ */
+static inline size_t GetEntrySize(const std::string &text, const RenderedText &data)
+{
+	return text.size() + data.GetMemorySize();
+}
+
+TextCache::TextCache() : hits(0), misses(0), font(nullptr), budget(DEFAULT_TEXT_CACHE_SIZE), used(0)
+{
+}
+
+TextCache::~TextCache()
+{
+	this->Clear();
+}
+
+/**
+ * Set the font to render the texts with. Drops all cached texts.
+ * @param font Font to use, \c nullptr if no font is available.
+ */
+void TextCache::SetFont(TTF_Font *font)
+{
+	this->Clear();
+	this->font = font;
+}
+
+/**
+ * Change the memory budget of the cache.
+ * @param budget New maximal amount of memory in bytes to use for the texts.
+ */
+void TextCache::SetBudget(size_t budget)
+{
+	this->budget = budget;
+	this->EvictTo(budget);
+}
+
+/** Drop all cached texts. */
+void TextCache::Clear()
+{
+	this->lookup.clear();
+	this->entries.clear();
+	this->used = 0;
+}
+
+/**
+ * Remove least recently used entries until the used memory is at most \a limit.
+ * The most recently used entry is never removed.
+ * @param limit Maximal amount of memory in bytes that may remain in use.
+ */
+void TextCache::EvictTo(size_t limit)
+{
+	while (this->used > limit && this->entries.size() > 1) {
+		const CacheEntry &ce = this->entries.back();
+		this->used -= GetEntrySize(ce.text, ce.data);
+		this->lookup.erase(ce.text);
+		this->entries.pop_back();
+	}
+}
+
+/**
+ * Find the entry of a text, creating an empty one if it does not exist.
+ * @param text Text to find.
+ * @return The entry of the text, moved to the front of the cache.
+ */
+TextCache::CacheEntry *TextCache::Lookup(const uint8 *text)
+{
+	std::string key((const char *)text);
+	CacheMap::iterator iter = this->lookup.find(key);
+	if (iter != this->lookup.end()) {
+		this->entries.splice(this->entries.begin(), this->entries, iter->second);
+		return &*iter->second;
+	}
+
+	this->entries.push_front({key, RenderedText()});
+	this->lookup.emplace(key, this->entries.begin());
+	this->used += GetEntrySize(key, this->entries.front().data);
+	return &this->entries.front();
+}
+
+/**
+ * Get the size of a text.
+ * @param text Text to measure.
+ * @return Entry with the size of the text (#RenderedText::size_valid is set). Pointer is valid until the next call.
+ */
+const RenderedText *TextCache::GetSize(const uint8 *text)
+{
+	CacheEntry *ce = this->Lookup(text);
+	if (ce->data.size_valid) {
+		this->hits++;
+		return &ce->data;
+	}
+
+	this->misses++;
+	if (this->font == nullptr || TTF_SizeUTF8(this->font, (const char *)text, &ce->data.size_width, &ce->data.size_height) != 0) {
+		ce->data.size_width = 0;
+		ce->data.size_height = 0;
+	}
+	ce->data.size_valid = true;
+	this->EvictTo(this->budget);
+	return &ce->data;
+}
+
+/**
+ * Get the rendered version of a text, rendering it if needed.
+ * @param text Text to render.
+ * @return Entry with the rendered text, or \c nullptr if rendering failed. Pointer is valid until the next call.
+ */
+const RenderedText *TextCache::GetRendered(const uint8 *text)
+{
+	CacheEntry *ce = this->Lookup(text);
+	if (ce->data.rendered) {
+		this->hits++;
+		return &ce->data;
+	}
+
+	this->misses++;
+	if (this->font == nullptr) return nullptr;
+
+	SDL_Color col = {0, 0, 0}; // Font colour does not matter as only the bitmap is used.
+	SDL_Surface *surf = TTF_RenderUTF8_Solid(this->font, (const char *)text, col);
+	if (surf == nullptr) {
+		fprintf(stderr, "Rendering text failed (%s)\n", TTF_GetError());
+		return nullptr;
+	}
+
+	if (surf->format->BitsPerPixel != 8 || surf->format->BytesPerPixel != 1) {
+		fprintf(stderr, "Rendering text failed (Wrong surface format)\n");
+		SDL_FreeSurface(surf);
+		return nullptr;
+	}
+
+	size_t old_size = GetEntrySize(ce->text, ce->data);
+	ce->data.width = surf->w;
+	ce->data.height = surf->h;
+	ce->data.spans.clear();
+	for (int y = 0; y < surf->h; y++) {
+		const uint8 *src = (const uint8 *)surf->pixels + y * surf->pitch;
+		int x = 0;
+		while (x < surf->w) {
+			if (src[x] == 0) {
+				x++;
+				continue;
+			}
+			int start = x;
+			while (x < surf->w && src[x] != 0) x++;
+			ce->data.spans.push_back({(uint16)start, (uint16)y, (uint16)(x - start)});
+		}
+	}
+	ce->data.spans.shrink_to_fit();
+	ce->data.rendered = true;
+	SDL_FreeSurface(surf);
+
+	this->used += GetEntrySize(ce->text, ce->data) - old_size;
+	this->EvictTo(this->budget);
+	return &ce->data;
+}
@@ -0,0 +1,99 @@
+/* $Id$ */
+
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file text_cache.h Cache of rendered texts. */
+
+#ifndef TEXT_CACHE_H
+#define TEXT_CACHE_H
+
+#include <list>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <SDL_ttf.h>
+
+/** A horizontal run of set pixels in a rendered text. */
+struct TextSpan {
+	uint16 x;      ///< Horizontal offset of the first pixel, relative to the left edge of the text.
+	uint16 y;      ///< Row of the span, relative to the top edge of the text.
+	uint16 length; ///< Number of pixels in the span.
+};
+
+/** Text rendered with the font, and its size. */
+class RenderedText {
+public:
+	RenderedText();
+
+	/**
+	 * Get the amount of memory used by the rendered text.
+	 * @return Size of the rendered text in bytes.
+	 */
+	inline size_t GetMemorySize() const
+	{
+		return sizeof(RenderedText) + this->spans.size() * sizeof(TextSpan);
+	}
+
+	int size_width;   ///< Width of the text as reported by the font, valid if #size_valid is set.
+	int size_height;  ///< Height of the text as reported by the font, valid if #size_valid is set.
+	bool size_valid;  ///< Whether the size of the text is known.
+
+	int width;        ///< Width of the rendered text in pixels, valid if #rendered is set.
+	int height;       ///< Height of the rendered text in pixels, valid if #rendered is set.
+	bool rendered;    ///< Whether the text has been rendered.
+	std::vector<TextSpan> spans; ///< Set pixels of the text, ordered by row.
+};
+
+/** Least recently used cache of rendered texts, limited by a memory budget. */
+class TextCache {
+public:
+	TextCache();
+	~TextCache();
+
+	void SetFont(TTF_Font *font);
+	void SetBudget(size_t budget);
+	void Clear();
+
+	const RenderedText *GetSize(const uint8 *text);
+	const RenderedText *GetRendered(const uint8 *text);
+
+	/**
+	 * Get the font used for rendering the texts.
+	 * @return The font, \c nullptr if no font is available.
+	 */
+	inline const TTF_Font *GetFont() const
+	{
+		return this->font;
+	}
+
+	uint64 hits;   ///< Number of lookups that found the text in the cache.
+	uint64 misses; ///< Number of lookups that had to use the font.
+
+private:
+	/** Entry in the cache. */
+	struct CacheEntry {
+		std::string text;  ///< Text of the entry.
+		RenderedText data; ///< Size and rendering of the text.
+	};
+
+	typedef std::list<CacheEntry> CacheList; ///< Entries of the cache, most recently used first.
+	typedef std::unordered_map<std::string, CacheList::iterator> CacheMap; ///< Lookup table of the cache entries.
+
+	CacheEntry *Lookup(const uint8 *text);
+	void EvictTo(size_t limit);
+
+	TTF_Font *font;    ///< Font to render the texts with.
+	CacheList entries; ///< Cached texts, most recently used entry first.
+	CacheMap lookup;   ///< Lookup table for finding entries in #entries.
+	size_t budget;     ///< Maximal amount of memory in bytes to use for the texts.
+	size_t used;       ///< Amount of memory in bytes currently in use by the texts.
+};
+
+static const size_t DEFAULT_TEXT_CACHE_SIZE = 1024 * 1024; ///< Default memory budget of the text cache in bytes.
+
+#endif
@@ -20,6 +20,8 @@
 #include "gamecontrol.h"
 #include "window.h"
 #include "viewport.h"
+#include "profiler.h"
+#include "minimap.h"
 #include <string>
 
 VideoSystem _video;  ///< Video sub-system.
@@ -64,7 +66,7 @@ ClippedRectangle::ClippedRectangle(uint16 x, uint16 y, uint16 w, uint16 h)
  * @param y Top-left y position.
  * @param w Width.
  * @param h Height.
- * @note %Rectangle is clipped to the old one.
+ * @note %Rectangle is clipped to the old one. If the address of \a cr is set, the new rectangle uses the same pixel buffer.
  */
 ClippedRectangle::ClippedRectangle(const ClippedRectangle &cr, uint16 x, uint16 y, uint16 w, uint16 h)
 {
@@ -83,7 +85,11 @@ ClippedRectangle::ClippedRectangle(const ClippedRectangle &cr, uint16 x, uint16
 	this->absy = cr.absy + y;
 	this->width = w;
 	this->height = h;
-	this->address = nullptr; this->pitch = 0;
+	if (cr.address != nullptr) {
+		this->address = cr.address + x + y * cr.pitch; this->pitch = cr.pitch;
+	} else {
+		this->address = nullptr; this->pitch = 0;
+	}
 }
 
 /**
@@ -120,7 +126,7 @@ ClippedRectangle &ClippedRectangle::operator=(const ClippedRectangle &cr)
 void ClippedRectangle::ValidateAddress()
 {
 	if (this->address == nullptr) {
-		this->pitch = _video.GetXSize();
+		this->pitch = _video.mem_pitch;
 		this->address = _video.mem + this->absx + this->absy * this->pitch;
 	}
 }
@@ -132,6 +138,14 @@ void ClippedRectangle::ValidateAddress()
 VideoSystem::VideoSystem()
 {
 	this->initialized = false;
+	this->interpolate = true;
+	this->show_rates = false;
+	this->direct_texture = false;
+	this->mem = nullptr;
+	this->mem_pitch = 0;
+	this->textures[0] = nullptr;
+	this->textures[1] = nullptr;
+	this->current_texture = 0;
 }
 
 /** Destructor. */
@@ -166,7 +180,7 @@ std::string VideoSystem::Initialize(const char *font_name, int font_size)
 		return err;
 	}
 
-	this->renderer = SDL_CreateRenderer(this->window, -1, SDL_RENDERER_ACCELERATED);
+	this->renderer = SDL_CreateRenderer(this->window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
 	if (this->renderer == nullptr) {
 		std::string err = "SDL renderer creation failed: ";
 		err += SDL_GetError();
@@ -200,7 +214,7 @@ std::string VideoSystem::Initialize(const char *font_name, int font_size)
 
 	if (TTF_Init() != 0) {
 		SDL_Quit();
-		delete[] this->mem;
+		if (!this->direct_texture) delete[] this->mem;
 		std::string err = "TTF font initialization failed: ";
 		err += TTF_GetError();
 		return err;
@@ -216,11 +230,12 @@ std::string VideoSystem::Initialize(const char *font_name, int font_size)
 		err += TTF_GetError();
 		TTF_Quit();
 		SDL_Quit();
-		delete[] this->mem;
+		if (!this->direct_texture) delete[] this->mem;
 		return err;
 	}
 
 	this->font_height = TTF_FontLineSkip(this->font);
+	this->text_cache.SetFont(this->font);
 	this->initialized = true;
 	this->dirty = true; // Ensure it gets painted.
 	this->missing_sprites = false;
@@ -244,28 +259,39 @@ bool VideoSystem::SetResolution(const Point32 &res)
 
 	/* Destroy old window, if it exists. */
 	if (this->initialized) {
-		delete[] mem;
+		if (!this->direct_texture) delete[] this->mem;
 		this->mem = nullptr;
-		SDL_DestroyTexture(this->texture);
-		this->texture = nullptr;
+		for (int i = 0; i < 2; i++) {
+			if (this->textures[i] != nullptr) SDL_DestroyTexture(this->textures[i]);
+			this->textures[i] = nullptr;
+		}
 	}
 
 	this->vid_width = res.x;
 	this->vid_height = res.y;
 	SDL_SetWindowSize(this->window, this->vid_width, this->vid_height);
 
-	this->texture = SDL_CreateTexture(this->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, this->vid_width, this->vid_height);
-	if (this->texture == nullptr) {
-		SDL_Quit();
-		fprintf(stderr, "Could not create texture (%s)\n", SDL_GetError());
-		return false;
+	/* When drawing directly into the textures, two of them are used alternately,
+	 * so the next frame can be drawn while the GPU may still be using the previous one. */
+	int texture_count = this->direct_texture ? 2 : 1;
+	for (int i = 0; i < texture_count; i++) {
+		this->textures[i] = SDL_CreateTexture(this->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, this->vid_width, this->vid_height);
+		if (this->textures[i] == nullptr) {
+			SDL_Quit();
+			fprintf(stderr, "Could not create texture (%s)\n", SDL_GetError());
+			return false;
+		}
 	}
+	this->current_texture = 0;
 
-	this->mem = new uint32[this->vid_width * this->vid_height];
-	if (this->mem == nullptr) {
-		SDL_Quit();
-		fprintf(stderr, "Failed to obtain window display storage.\n");
-		return false;
+	if (!this->direct_texture) {
+		this->mem = new uint32[this->vid_width * this->vid_height];
+		if (this->mem == nullptr) {
+			SDL_Quit();
+			fprintf(stderr, "Failed to obtain window display storage.\n");
+			return false;
+		}
+		this->mem_pitch = this->vid_width;
 	}
 
 	/* Update internal screen size data structures. */
@@ -291,10 +317,11 @@ void VideoSystem::GetResolutions()
 	}
 }
 
-/** Mark the entire display as being out of date (it needs the be repainted). */
+/** Mark the entire display as being out of date (it needs the be repainted), including the stored contents of all windows. */
 void VideoSystem::MarkDisplayDirty()
 {
 	this->dirty = true;
+	_window_manager.MarkAllWindowsDirty();
 }
 
 /**
@@ -356,9 +383,21 @@ static bool HandleKeyInput(WmKeyCode key_code, const uint8 *symbol)
 		GetViewport()->Rotate(-1);
 	} else if (key_code == WMKC_CURSOR_RIGHT) {
 		GetViewport()->Rotate(1);
+	} else if (key_code == WMKC_CURSOR_UP) {
+		GetViewport()->Zoom(1);
+	} else if (key_code == WMKC_CURSOR_DOWN) {
+		GetViewport()->Zoom(-1);
 	} else if (key_code == WMKC_SYMBOL) {
 		if (symbol[0] == '1') {
 			GetViewport()->ToggleUndergroundMode();
+		} else if (symbol[0] == 'f') {
+			_game_clock.SetSpeed((GameSpeed)((_game_clock.GetSpeed() + 1) % GSP_COUNT));
+		} else if (symbol[0] == 'm') {
+			ShowMinimapGui();
+#ifdef ENABLE_PROFILER
+		} else if (symbol[0] == 'p') {
+			ShowProfilerGui();
+#endif
 		} else if (symbol[0] == 'q') {
 			QuitProgram();
 			return true;
@@ -451,17 +490,51 @@ bool VideoSystem::HandleEvent()
 	}
 }
 
-/** Main loop. Loops until told not to. */
+/**
+ * Main loop. Loops until told not to.
+ * The game is simulated at a fixed rate by the #_game_clock, the display is drawn as often as possible (limited by the
+ * vertical synchronization of the display, and by #MIN_FRAME_DELAY).
+ */
 void VideoSystem::MainLoop()
 {
-	static const uint32 FRAME_DELAY = 30; // Number of milliseconds between two frames.
+	static const uint32 MIN_FRAME_DELAY = 16; // Minimal number of milliseconds between two drawn frames.
 	bool missing_sprites_check = false;
 	_finish = false;
 
+	uint32 last_time = SDL_GetTicks();
+	uint32 tick_rate = 0;
+	uint32 frame_rate = 0;
+	GameSpeed speed = _game_clock.GetSpeed();
+	_game_clock.Reset();
+	uint32 frame_number = 0;
 	while (!_finish) {
+		frame_number++;
+#ifdef ENABLE_PROFILER
+		_profiler.StartFrame();
+		if (frame_number % PROFILER_DISPLAY_INTERVAL == 0) NotifyChange(WC_PROFILER, ALL_WINDOWS_OF_TYPE, CHG_DISPLAY_OLD, 0);
+#endif
+		if (frame_number % MINIMAP_UPDATE_INTERVAL == 0) NotifyChange(WC_MINIMAP, ALL_WINDOWS_OF_TYPE, CHG_DISPLAY_OLD, 0);
 		uint32 start = SDL_GetTicks();
+		_game_clock.Advance(start - last_time); // Unsigned arithmetic handles wrap around.
+		last_time = start;
 
-		OnNewFrame(FRAME_DELAY);
+		/* Moving objects are drawn between their tick positions, so the world changes every frame. */
+		if (this->interpolate) {
+			Viewport *vp = GetViewport();
+			if (vp != nullptr) vp->MarkDirty();
+		}
+		if (this->DisplayNeedsRepaint()) _game_clock.OnFrameDrawn();
+		UpdateWindows();
+
+		if (this->show_rates && (tick_rate != _game_clock.tick_rate || frame_rate != _game_clock.frame_rate || speed != _game_clock.GetSpeed())) {
+			tick_rate = _game_clock.tick_rate;
+			frame_rate = _game_clock.frame_rate;
+			speed = _game_clock.GetSpeed();
+			std::string caption = "FreeRCT ";
+			caption += _freerct_revision;
+			caption += " (speed " + std::string(GetGameSpeedText(speed)) + ", " + std::to_string(tick_rate) + " ticks/s, " + std::to_string(frame_rate) + " frames/s)";
+			SDL_SetWindowTitle(this->window, caption.c_str());
+		}
 
 		/* Handle input events until time for the next frame has arrived. */
 		for (;;) {
@@ -469,10 +542,18 @@ void VideoSystem::MainLoop()
 		}
 		if (_finish) break;
 
+		/* Wait until the next tick, or until the next frame when interpolating.
+		 * At fast-forward speeds, ticks are shorter than a frame; the ticks between two frames run without drawing. */
+		uint32 delay = _game_clock.GetTimeToNextTick();
+		if (GetGameSpeedFactor(_game_clock.GetSpeed()) > 1) {
+			delay = MIN_FRAME_DELAY;
+		} else if (this->interpolate) {
+			delay = std::min(delay, MIN_FRAME_DELAY);
+		}
 		uint32 now = SDL_GetTicks();
 		if (now >= start) { // No wrap around.
 			now -= start;
-			if (now < FRAME_DELAY) SDL_Delay(FRAME_DELAY - now); // Too early, wait until next frame.
+			if (now < delay) SDL_Delay(delay - now); // Too early, wait until next frame.
 		}
 
 		if (!missing_sprites_check && this->missing_sprites) {
@@ -486,24 +567,61 @@ void VideoSystem::MainLoop()
 void VideoSystem::Shutdown()
 {
 	if (this->initialized) {
+		this->sprite_cache.Clear();
+		this->text_cache.SetFont(nullptr);
 		TTF_CloseFont(this->font);
 		TTF_Quit();
 		SDL_Quit();
-		delete[] this->mem;
+		if (!this->direct_texture) delete[] this->mem;
+		this->mem = nullptr;
 		this->initialized = false;
 		this->dirty = false;
 	}
 }
 
+/**
+ * Prepare for repainting the display. When drawing directly into the texture, this locks the texture to draw into.
+ * @note The entire display is repainted, the previous contents of the pixels are not used.
+ * @note SDL documents the memory of a locked texture as write-only. It may not contain the previous frame, and reading it may be
+ *       slow (for example when it is write-combined memory of the graphics card). Alpha blending of sprites and the backing stores
+ *       of the windows read back pixels that were drawn earlier in the same repaint. That gives correct pixels, but may make
+ *       drawing with #direct_texture slower than drawing into a separate buffer.
+ */
+void VideoSystem::StartRepaint()
+{
+	if (!this->direct_texture) return;
+
+	void *pixels;
+	int pitch;
+	if (SDL_LockTexture(this->textures[this->current_texture], nullptr, &pixels, &pitch) != 0) {
+		fprintf(stderr, "Could not lock texture (%s), drawing into a separate buffer instead\n", SDL_GetError());
+		this->direct_texture = false;
+		this->mem = new uint32[this->vid_width * this->vid_height];
+		this->mem_pitch = this->vid_width;
+	} else {
+		this->mem = (uint32 *)pixels;
+		this->mem_pitch = pitch / sizeof(uint32);
+	}
+	this->blit_rect = ClippedRectangle(0, 0, this->vid_width, this->vid_height); // Address of the pixels may have changed.
+}
+
 /**
  * Finish repainting, perform the final steps.
  * @todo Implement partial window repainting.
  */
 void VideoSystem::FinishRepaint()
 {
-	SDL_UpdateTexture(this->texture, nullptr, this->mem, this->GetXSize() * sizeof(uint32)); // Upload memory to the GPU.
+	PROFILE_SCOPE(PFS_FINISH_REPAINT);
+	SDL_Texture *texture = this->textures[this->current_texture];
+	if (this->direct_texture) {
+		SDL_UnlockTexture(texture); // Upload the drawn pixels to the GPU.
+		this->mem = nullptr;
+		this->current_texture = 1 - this->current_texture;
+	} else {
+		SDL_UpdateTexture(texture, nullptr, this->mem, this->mem_pitch * sizeof(uint32)); // Upload memory to the GPU.
+	}
 	SDL_RenderClear(this->renderer);
-	SDL_RenderCopy(this->renderer, this->texture, nullptr, nullptr);
+	SDL_RenderCopy(this->renderer, texture, nullptr, nullptr);
 	SDL_RenderPresent(this->renderer);
 
 	MarkDisplayClean();
@@ -568,7 +686,7 @@ static void Blit8bppImages(const ClippedRectangle &cr, int32 x_base, int32 y_bas
 			for (;;) {
 				uint8 rel_off = spr->data[offset];
 				uint8 count   = spr->data[offset + 1];
-				uint8 *pixels = &spr->data[offset + 2];
+				const uint8 *pixels = &spr->data[offset + 2];
 				offset += 2 + count;
 
 				xpos += rel_off & 127;
@@ -677,6 +795,66 @@ static void Blit32bppImages(const ClippedRectangle &cr, int32 x_base, int32 y_ba
 	}
 }
 
+/**
+ * Blit decoded images to the screen.
+ * @param cr Clipped rectangle to draw to.
+ * @param x_base Base X coordinate of the sprite data.
+ * @param y_base Base Y coordinate of the sprite data.
+ * @param spr The sprite to blit.
+ * @param decoded Decoded version of \a spr.
+ * @param numx Number of sprites to draw in horizontal direction.
+ * @param numy Number of sprites to draw in vertical direction.
+ */
+static void BlitDecodedImages(const ClippedRectangle &cr, int32 x_base, int32 y_base, const ImageData *spr, const DecodedSprite *decoded, uint16 numx, uint16 numy)
+{
+	const bool single = numx == 1 && numy == 1;
+	for (const DecodedSpan &span : decoded->spans) {
+		int32 xpos = x_base + span.x;
+		int32 ypos = y_base + span.y;
+		uint32 *src_base = cr.address + xpos + cr.pitch * ypos;
+		const uint32 *pixels = &decoded->pixels[span.first];
+
+		if (single) {
+			/* Common case of a single sprite, clip the span and copy it directly. */
+			if (ypos < 0 || ypos >= cr.height) continue;
+			int32 start = std::max(0, -xpos);
+			int32 end = std::min<int32>(span.length, cr.width - xpos);
+			if (!span.blend) {
+				if (start < end) memcpy(src_base + start, pixels + start, (end - start) * sizeof(uint32));
+				continue;
+			}
+			for (int32 i = start; i < end; i++) {
+				uint32 old_pixel = src_base[i];
+				uint32 colour = pixels[i];
+				uint opacity = GetA(colour);
+
+				uint r = GetR(colour) * opacity + GetR(old_pixel) * (256 - opacity);
+				uint g = GetG(colour) * opacity + GetG(old_pixel) * (256 - opacity);
+				uint b = GetB(colour) * opacity + GetB(old_pixel) * (256 - opacity);
+				src_base[i] = MakeRGBA(r >> 8, g >> 8, b >> 8, OPAQUE);
+			}
+			continue;
+		}
+
+		for (uint16 i = 0; i < span.length; i++) {
+			uint32 colour = pixels[i];
+			if (span.blend) {
+				/* Like the other blitters, blend with the pixel below the first sprite. */
+				uint32 old_pixel = *src_base;
+				uint opacity = GetA(colour);
+
+				uint r = GetR(colour) * opacity + GetR(old_pixel) * (256 - opacity);
+				uint g = GetG(colour) * opacity + GetG(old_pixel) * (256 - opacity);
+				uint b = GetB(colour) * opacity + GetB(old_pixel) * (256 - opacity);
+				colour = MakeRGBA(r >> 8, g >> 8, b >> 8, OPAQUE);
+			}
+			BlitPixel(cr, src_base, xpos, ypos, numx, numy, spr->width, spr->height, colour);
+			xpos++;
+			src_base++;
+		}
+	}
+}
+
 /**
  * Blit pixels from the \a spr relative to \a img_base into the area.
  * @param pt Base coordinates of the sprite data.
@@ -706,6 +884,13 @@ void VideoSystem::BlitImages(const Point32 &pt, const ImageData *spr, uint16 num
 	while (numy > 0 && y_base + (numy - 1) * spr->height >= this->blit_rect.height) numy--;
 	if (numy == 0) return;
 
+	const DecodedSprite *decoded = this->sprite_cache.Get(spr, recolour, shift);
+	if (decoded != nullptr) {
+		BlitDecodedImages(this->blit_rect, x_base, y_base, spr, decoded, numx, numy);
+		return;
+	}
+
+	spr->RequirePixels();
 	if (GB(spr->flags, IFG_IS_8BPP, 1) != 0) {
 		Blit8bppImages(this->blit_rect, x_base, y_base, spr, numx, numy, recolour.GetPalette(shift));
 	} else {
@@ -713,6 +898,26 @@ void VideoSystem::BlitImages(const Point32 &pt, const ImageData *spr, uint16 num
 	}
 }
 
+/**
+ * Blit a decoded sprite into a clipped rectangle. Unlike the other blit functions, it does not use the state of the video system, and
+ * may be called from several threads at the same time as long as they draw in different rectangles.
+ * @param cr Clipped rectangle to draw to. Its address must be valid.
+ * @param pt Base coordinates of the sprite data, relative to \a cr.
+ * @param spr The sprite to blit.
+ * @param decoded Decoded version of \a spr.
+ */
+void VideoSystem::BlitDecodedImage(const ClippedRectangle &cr, const Point32 &pt, const ImageData *spr, const DecodedSprite *decoded)
+{
+	assert(cr.address != nullptr);
+
+	int x_base = pt.x + spr->xoffset;
+	int y_base = pt.y + spr->yoffset;
+	if (x_base + spr->width < 0 || x_base >= cr.width) return;
+	if (y_base + spr->height < 0 || y_base >= cr.height) return;
+
+	BlitDecodedImages(cr, x_base, y_base, spr, decoded, 1, 1);
+}
+
 /**
  * Get the text-size of a string.
  * @param text Text to calculate.
@@ -721,10 +926,9 @@ void VideoSystem::BlitImages(const Point32 &pt, const ImageData *spr, uint16 num
  */
 void VideoSystem::GetTextSize(const uint8 *text, int *width, int *height)
 {
-	if (TTF_SizeUTF8(this->font, (const char *)text, width, height) != 0) {
-		*width = 0;
-		*height = 0;
-	}
+	const RenderedText *rt = this->text_cache.GetSize(text);
+	*width = rt->size_width;
+	*height = rt->size_height;
 }
 
 /**
@@ -776,19 +980,10 @@ void VideoSystem::GetNumberRangeSize(int64 smallest, int64 biggest, int *width,
  */
 void VideoSystem::BlitText(const uint8 *text, uint32 colour, int xpos, int ypos, int width, Alignment align)
 {
-	SDL_Color col = {0, 0, 0}; // Font colour does not matter as only the bitmap is used.
-	SDL_Surface *surf = TTF_RenderUTF8_Solid(this->font, (const char *)text, col);
-	if (surf == nullptr) {
-		fprintf(stderr, "Rendering text failed (%s)\n", TTF_GetError());
-		return;
-	}
-
-	if (surf->format->BitsPerPixel != 8 || surf->format->BytesPerPixel != 1) {
-		fprintf(stderr, "Rendering text failed (Wrong surface format)\n");
-		return;
-	}
+	const RenderedText *rt = this->text_cache.GetRendered(text);
+	if (rt == nullptr) return;
 
-	int real_w = std::min(surf->w, width);
+	int real_w = std::min(rt->width, width);
 	switch (align) {
 		case ALG_LEFT:
 			break;
@@ -806,43 +1001,20 @@ void VideoSystem::BlitText(const uint8 *text, uint32 colour, int xpos, int ypos,
 
 	this->blit_rect.ValidateAddress();
 
-	uint8 *src = ((uint8 *)surf->pixels);
-	uint32 *dest = this->blit_rect.address + xpos + ypos * this->blit_rect.pitch;
-	int h = surf->h;
-	if (ypos < 0) {
-		h += ypos;
-		src  -= ypos * surf->pitch;
-		dest -= ypos * this->blit_rect.pitch;
-		ypos = 0;
-	}
-	while (h > 0) {
-		if (ypos >= this->blit_rect.height) break;
-		uint8 *src2 = src;
-		uint32 *dest2 = dest;
-		int w = real_w;
-		int x = xpos;
-		if (x < 0) {
-			w += x;
-			if (w <= 0) break;
-			dest2 -= x;
-			src2 -= x;
-			x = 0;
-		}
-		while (w > 0) {
-			if (x >= this->blit_rect.width) break;
-			if (*src2 != 0) *dest2 = colour;
-			src2++;
-			dest2++;
-			x++;
-			w--;
-		}
-		ypos++;
-		src  += surf->pitch;
-		dest += this->blit_rect.pitch;
-		h--;
-	}
+	int left = std::max(xpos, 0);
+	int right = std::min(xpos + real_w, (int)this->blit_rect.width);
+	if (left >= right) return;
 
-	SDL_FreeSurface(surf);
+	for (const TextSpan &span : rt->spans) {
+		int y = ypos + span.y;
+		if (y < 0) continue;
+		if (y >= this->blit_rect.height) break;
+
+		int x = std::max(xpos + span.x, left);
+		int end = std::min(xpos + span.x + span.length, right);
+		uint32 *dest = this->blit_rect.address + y * this->blit_rect.pitch;
+		for (; x < end; x++) dest[x] = colour;
+	}
 }
 
 /**
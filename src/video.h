@@ -17,6 +17,8 @@
 #include <SDL_ttf.h>
 #include "geometry.h"
 #include "palette.h"
+#include "sprite_cache.h"
+#include "text_cache.h"
 
 void QuitProgram();
 
@@ -140,7 +142,9 @@ public:
 	}
 
 	void BlitImages(const Point32 &pt, const ImageData *spr, uint16 numx, uint16 numy, const Recolouring &recolour, GradientShift shift = GS_NORMAL);
+	static void BlitDecodedImage(const ClippedRectangle &cr, const Point32 &pt, const ImageData *spr, const DecodedSprite *decoded);
 
+	void StartRepaint();
 	void FinishRepaint();
 
 	/**
@@ -160,6 +164,11 @@ public:
 	void FillRectangle(const Rectangle32 &rect, uint32 colour);
 
 	bool missing_sprites; ///< Indicates that some sprites cannot be drawn.
+	bool interpolate;     ///< Draw moving objects between their positions at the ticks, and draw the world at every frame.
+	bool show_rates;      ///< Display the tick rate and frame rate in the window title.
+	bool direct_texture;  ///< Draw directly into the GPU texture instead of a separate buffer (see #StartRepaint for reading the pixels back). Must be set before #Initialize.
+	SpriteCache sprite_cache;      ///< Decoded sprites, for faster blitting.
+	TextCache text_cache;          ///< Sizes and renderings of texts, for faster text drawing.
 	std::set<Point32> resolutions; ///< Set (for automatic sorting) of available resolutions.
 
 private:
@@ -172,8 +181,10 @@ private:
 	TTF_Font *font;             ///< Opened text font.
 	SDL_Window *window;         ///< %Window of the application.
 	SDL_Renderer *renderer;     ///< GPU renderer to the application window.
-	SDL_Texture *texture;       ///< GPU Texture storage of the application window.
-	uint32 *mem;                ///< Memory used for blitting the application display.
+	SDL_Texture *textures[2];   ///< GPU Texture storage of the application window (second texture is only used with #direct_texture).
+	int current_texture;        ///< Index in #textures of the texture to draw the next frame in.
+	uint32 *mem;                ///< Memory used for blitting the application display (the locked texture with #direct_texture, valid only while repainting).
+	int mem_pitch;              ///< Number of pixels in a row of #mem.
 	ClippedRectangle blit_rect; ///< %Rectangle to blit in.
 	Point16 digit_size;         ///< Size of largest digit (initially a zero-size).
 
@@ -32,8 +32,11 @@
 #include "weather.h"
 #include "fence.h"
 #include "fence_build.h"
+#include "worker_pool.h"
+#include "gamecontrol.h"
+#include "profiler.h"
 
-#include <set>
+#include <vector>
 
 /**
  * \page the_world_page World
@@ -158,6 +161,7 @@ static inline int32 ComputeYFunction(int32 x, int32 y, int32 z, ViewOrientation
 class VoxelCollector {
 public:
 	VoxelCollector(Viewport *vp, bool draw_above_stack);
+	VoxelCollector(const XYZPoint32 &view_pos, uint16 tile_width, ViewOrientation orient);
 	virtual ~VoxelCollector();
 
 	void SetWindowSize(int16 xpos, int16 ypos, uint16 width, uint16 height);
@@ -187,14 +191,27 @@ public:
 		return ComputeYFunction(x, y, z, this->orient, this->tile_width, this->tile_height);
 	}
 
+	/**
+	 * Get the position of a voxel object inside its voxel, as it should be drawn.
+	 * @param vo Voxel object to examine.
+	 * @return Position of the object inside its voxel, including its movement since the last tick if interpolating.
+	 */
+	inline XYZPoint16 GetObjectPosition(const VoxelObject *vo) const
+	{
+		if (!this->interpolate) return vo->pix_pos;
+		return vo->pix_pos + vo->GetRenderOffset(this->tick_progress);
+	}
+
 	XYZPoint32 view_pos;          ///< Position of the centre point of the display.
 	uint16 tile_width;            ///< Width of a tile.
 	uint16 tile_height;           ///< Height of a tile.
 	ViewOrientation orient;       ///< Direction of view.
 	const SpriteStorage *sprites; ///< Sprite collection of the right size.
-	Viewport *vp;                 ///< Parent viewport for accessing the cursors if not \c nullptr.
+	Viewport *vp;                 ///< Parent viewport for accessing the cursors, \c nullptr when drawing off-screen.
 	bool draw_above_stack;        ///< Also draw voxels above the voxel stack (for cursors).
 	bool underground_mode;        ///< Whether to draw underground mode sprites (else draw normal surface sprites).
+	bool interpolate;             ///< Whether to draw voxel objects between their positions at the ticks.
+	uint32 tick_progress;         ///< Game time since the last tick in milliseconds, for interpolating.
 
 	Rectangle32 rect; ///< Screen area of interest.
 
@@ -251,7 +268,18 @@ inline bool operator<(const DrawData &dd1, const DrawData &dd2)
  * Collection of sprites to render to the screen.
  * @ingroup viewport_group
  */
-typedef std::multiset<DrawData> DrawImages;
+typedef std::vector<DrawData> DrawImages;
+
+/**
+ * Parts of the world collected by a #SpriteCollector.
+ * @ingroup viewport_group
+ */
+enum SpriteCollectParts {
+	SCP_STATIC  = 1 << 0, ///< Ground, foundations, paths, rides, fences, supports, and cursors.
+	SCP_OBJECTS = 1 << 1, ///< %Voxel objects (persons, ride cars, etc).
+
+	SCP_ALL = SCP_STATIC | SCP_OBJECTS, ///< Everything.
+};
 
 /**
  * Collect sprites to draw in a viewport.
@@ -259,20 +287,25 @@ typedef std::multiset<DrawData> DrawImages;
  */
 class SpriteCollector : public VoxelCollector {
 public:
-	SpriteCollector(Viewport *vp, bool enable_cursors);
+	SpriteCollector(Viewport *vp, bool enable_cursors, uint8 parts = SCP_ALL);
+	SpriteCollector(const XYZPoint32 &view_pos, uint16 tile_width, ViewOrientation orient);
 	~SpriteCollector();
 
 	void SetXYOffset(int16 xoffset, int16 yoffset);
+	void Collect(bool use_additions);
 
-	DrawImages draw_images; ///< Sprites to draw ordered by viewing distance.
+	DrawImages draw_images; ///< Sprites to draw, ordered by viewing distance after collecting.
 	int16 xoffset; ///< Horizontal offset of the top-left coordinate to the top-left of the display.
 	int16 yoffset; ///< Vertical offset of the top-left coordinate to the top-left of the display.
 	bool enable_cursors; ///< Enable cursor drawing.
+	uint8 parts; ///< Parts of the world to collect. @see SpriteCollectParts
 
 protected:
 	void CollectVoxel(const Voxel *vx, const XYZPoint16 &voxel_pos, int32 xnorth, int32 ynorth) override;
+	void CollectVoxelObjects(const Voxel *vx, int32 slice, const XYZPoint16 &voxel_pos, int32 xnorth, int32 ynorth);
 	void SetupSupports(const VoxelStack *stack, uint xpos, uint ypos) override;
 	const ImageData *GetCursorSpriteAtPos(const XYZPoint16 &voxel_pos, uint8 tslope, uint8 &yoffset);
+	void SetupNorthOffsets();
 
 	/** For each orientation the location of the real northern corner of a tile relative to the northern displayed corner. */
 	Point16 north_offsets[4];
@@ -287,7 +320,7 @@ protected:
  */
 class PixelFinder : public VoxelCollector {
 public:
-	PixelFinder(Viewport *vp, FinderData *fdata);
+	PixelFinder(Viewport *vp, FinderData *fdata, PickBuffer *buffer = nullptr);
 	~PixelFinder();
 
 	ClickableSprite allowed; ///< Sprite types looking for.
@@ -295,9 +328,79 @@ public:
 	DrawData data;           ///< Drawing data of the match found so far.
 	uint32 pixel;            ///< Pixel colour of the closest sprite.
 	FinderData *fdata;       ///< Finder data to return.
+	PickBuffer *buffer;      ///< If not \c nullptr, fill this buffer for the entire collect window instead of finding a single pixel.
 
 protected:
 	void CollectVoxel(const Voxel *vx, const XYZPoint16 &voxel_pos, int32 xnorth, int32 ynorth) override;
+	void CheckSprite(const DrawData &dd, const ImageData *spr, const XYZPoint16 &voxel_pos, uint16 ride, const Person *person);
+};
+
+/**
+ * Clickable sprite at a pixel of the #PickBuffer.
+ * @ingroup viewport_group
+ */
+struct PickData {
+	DrawData data;        ///< Drawing data of the sprite, with the position relative to the top-left of the buffer (as the #PixelFinder would compute it).
+	XYZPoint16 voxel_pos; ///< Position of the voxel of the sprite.
+	uint16 ride;          ///< Ride instance of the sprite, if any.
+};
+
+static const uint32 PICK_INDEX_MASK = 0xFFFFFF; ///< Bits of a #PickBuffer pixel containing the index of the #PickData (plus one, \c 0 means nothing found).
+static const int PICK_COLOUR_SHIFT = 24;        ///< Start bit of the colour class of a #PickBuffer pixel. @see GetPickColour
+
+/**
+ * Buffer with the clickable sprite of each pixel of a viewport, for finding the sprite under the mouse cursor with a single lookup.
+ * It contains the static parts of the world only (ground, ground edges, paths, and rides), persons are still found by the #PixelFinder.
+ * @ingroup viewport_group
+ */
+struct PickBuffer {
+	PickBuffer();
+
+	bool IsValid(const Viewport *vp, ClickableSprite allowed) const;
+	void Rebuild(Viewport *vp, FinderData *fdata);
+	void AddSprite(const DrawData &dd, const ImageData *spr, const XYZPoint16 &voxel_pos, uint16 ride);
+
+	bool valid;              ///< Whether the buffer has been filled.
+	XYZPoint32 view_pos;     ///< Position of the centre point of the viewport.
+	uint16 tile_width;       ///< Width of a tile.
+	ViewOrientation orient;  ///< Direction of view.
+	uint16 width;            ///< Width of the buffer.
+	uint16 height;           ///< Height of the buffer.
+	uint32 change_count;     ///< Value of VoxelWorld::GetChangeCount at the time of filling the buffer.
+	ClickableSprite allowed; ///< Sprite types in the buffer.
+
+	std::vector<uint32> pixels;   ///< Index of the #picks entry (plus one) and colour class of each pixel.
+	std::vector<PickData> picks;  ///< Sprites found in the buffer.
+};
+
+static const int STATIC_ROW_HEIGHT = 64; ///< Height of a row of the #StaticLayer in pixels.
+
+/**
+ * Cached rendering of the static parts of the world (everything except voxel objects) in a viewport.
+ * Voxel objects are drawn on top by redrawing the rows of the layer that contain them, interleaving
+ * the static sprites of the row with the voxel objects in the normal drawing order.
+ * @ingroup viewport_group
+ */
+struct StaticLayer {
+	StaticLayer();
+
+	bool IsValid(const Viewport *vp, GradientShift gs) const;
+	void Rebuild(Viewport *vp, GradientShift gs);
+
+	bool valid;                   ///< Whether the layer has been rendered.
+	XYZPoint32 view_pos;          ///< Position of the centre point of the viewport.
+	uint16 tile_width;            ///< Width of a tile.
+	ViewOrientation orient;       ///< Direction of view.
+	bool underground_mode;        ///< Whether underground mode sprites are drawn.
+	uint16 width;                 ///< Width of the layer.
+	uint16 height;                ///< Height of the layer.
+	GradientShift gs;             ///< Gradient shift of the sprites.
+	uint32 change_count;          ///< Value of VoxelWorld::GetChangeCount at the time of rendering.
+	std::vector<std::pair<const Recolouring *, uint64>> recolours; ///< Recolourings used by the sprites, with their colours at the time of rendering.
+
+	std::vector<uint32> pixels;           ///< Rendered static sprites.
+	std::vector<DrawData> images;         ///< Static sprites, in drawing order.
+	std::vector<std::vector<uint32>> rows; ///< Indices of the #images overlapping each row of #STATIC_ROW_HEIGHT pixels.
 };
 
 /**
@@ -315,6 +418,31 @@ VoxelCollector::VoxelCollector(Viewport *vp, bool draw_above_stack)
 	this->orient = vp->orientation;
 	this->draw_above_stack = draw_above_stack;
 	this->underground_mode = vp->underground_mode;
+	this->interpolate = _video.interpolate;
+	this->tick_progress = _game_clock.GetTickProgress();
+
+	this->sprites = _sprite_manager.GetSprites(this->tile_width);
+	assert(this->sprites != nullptr);
+}
+
+/**
+ * Constructor for collecting voxels without a viewport, for drawing the world off-screen.
+ * No cursors are visited, and voxel objects are at their position of the last tick.
+ * @param view_pos Position of the centre point of the display.
+ * @param tile_width Width of a tile.
+ * @param orient Direction of view.
+ */
+VoxelCollector::VoxelCollector(const XYZPoint32 &view_pos, uint16 tile_width, ViewOrientation orient)
+{
+	this->vp = nullptr;
+	this->view_pos = view_pos;
+	this->tile_width = tile_width;
+	this->tile_height = tile_width / 4;
+	this->orient = orient;
+	this->draw_above_stack = false;
+	this->underground_mode = false;
+	this->interpolate = false;
+	this->tick_progress = 0;
 
 	this->sprites = _sprite_manager.GetSprites(this->tile_width);
 	assert(this->sprites != nullptr);
@@ -349,6 +477,7 @@ void VoxelCollector::SetWindowSize(int16 xpos, int16 ypos, uint16 width, uint16
  */
 void VoxelCollector::Collect(bool use_additions)
 {
+	PROFILE_SCOPE(PFS_COLLECT);
 	for (uint xpos = 0; xpos < _world.GetXSize(); xpos++) {
 		int32 world_x = (xpos + ((this->orient == VOR_SOUTH || this->orient == VOR_WEST) ? 1 : 0)) * 256;
 		for (uint ypos = 0; ypos < _world.GetYSize(); ypos++) {
@@ -436,14 +565,37 @@ void Viewport::TimeoutCallback()
  * Constructor of sprites collector.
  * @param vp %Viewport that needs the sprites.
  * @param enable_cursors Also collect cursors.
+ * @param parts Parts of the world to collect. @see SpriteCollectParts
  */
-SpriteCollector::SpriteCollector(Viewport *vp, bool enable_cursors) : VoxelCollector(vp, true)
+SpriteCollector::SpriteCollector(Viewport *vp, bool enable_cursors, uint8 parts) : VoxelCollector(vp, (parts & SCP_STATIC) != 0)
 {
 	this->draw_images.clear();
 	this->xoffset = 0;
 	this->yoffset = 0;
 	this->enable_cursors = enable_cursors;
+	this->parts = parts;
+	this->SetupNorthOffsets();
+}
+
+/**
+ * Constructor of a sprites collector for drawing the entire world off-screen, without cursors.
+ * @param view_pos Position of the centre point of the display.
+ * @param tile_width Width of a tile.
+ * @param orient Direction of view.
+ */
+SpriteCollector::SpriteCollector(const XYZPoint32 &view_pos, uint16 tile_width, ViewOrientation orient) : VoxelCollector(view_pos, tile_width, orient)
+{
+	this->draw_images.clear();
+	this->xoffset = 0;
+	this->yoffset = 0;
+	this->enable_cursors = false;
+	this->parts = SCP_ALL;
+	this->SetupNorthOffsets();
+}
 
+/** Compute the offsets of the north corner of a tile for each view orientation. */
+void SpriteCollector::SetupNorthOffsets()
+{
 	this->north_offsets[VOR_NORTH].x = 0;                     this->north_offsets[VOR_NORTH].y = 0;
 	this->north_offsets[VOR_EAST].x  = -this->tile_width / 2; this->north_offsets[VOR_EAST].y  = this->tile_width / 4;
 	this->north_offsets[VOR_SOUTH].x = 0;                     this->north_offsets[VOR_SOUTH].y = this->tile_width / 2;
@@ -454,6 +606,18 @@ SpriteCollector::~SpriteCollector()
 {
 }
 
+/**
+ * Collect the sprites to draw, and sort them in drawing order.
+ * @param use_additions Use the #_additions voxels for drawing.
+ */
+void SpriteCollector::Collect(bool use_additions)
+{
+	this->VoxelCollector::Collect(use_additions);
+
+	PROFILE_SCOPE(PFS_SORT);
+	std::stable_sort(this->draw_images.begin(), this->draw_images.end()); // Keeps sprites that compare equal in the order of collecting.
+}
+
 /**
  * Set the offset of the top-left coordinate of the collect window to the top-left of the display.
  * @param xoffset Horizontal offset.
@@ -497,7 +661,7 @@ Cursor::Cursor(Viewport *vp) : BaseCursor(vp)
 
 void Cursor::MarkDirty()
 {
-	if (this->type != CUR_TYPE_INVALID) this->vp->MarkVoxelDirty(this->cursor_pos);
+	if (this->type != CUR_TYPE_INVALID) this->vp->MarkVoxelDirty(this->cursor_pos, 0, false);
 }
 
 /**
@@ -591,7 +755,7 @@ void MultiCursor::MarkDirty()
 	for (uint x = 0; x < this->rect.width; x++) {
 		for (uint y = 0; y < this->rect.height; y++) {
 			this->vp->MarkVoxelDirty(XYZPoint16(this->rect.base.x + x, this->rect.base.y + y,
-					this->GetZpos(this->rect.base.x + x, this->rect.base.y + y)));
+					this->GetZpos(this->rect.base.x + x, this->rect.base.y + y)), 0, false);
 		}
 	}
 }
@@ -667,7 +831,7 @@ EdgeCursor::EdgeCursor(Viewport *vp) : BaseCursor(vp)
 
 void EdgeCursor::MarkDirty()
 {
-	if (this->type != CUR_TYPE_INVALID) this->vp->MarkVoxelDirty(this->cursor_pos);
+	if (this->type != CUR_TYPE_INVALID) this->vp->MarkVoxelDirty(this->cursor_pos, 0, false);
 }
 
 /**
@@ -799,6 +963,8 @@ const ImageData *SpriteCollector::GetCursorSpriteAtPos(const XYZPoint16 &voxel_p
 
 void SpriteCollector::SetupSupports(const VoxelStack *stack, uint xpos, uint ypos)
 {
+	if ((this->parts & SCP_STATIC) == 0) return;
+
 	for (uint i = 0; i < stack->height; i++) {
 		const Voxel *v = &stack->voxels[i];
 		if (v->GetGroundType() == GTP_INVALID) continue;
@@ -820,13 +986,14 @@ void SpriteCollector::SetupSupports(const VoxelStack *stack, uint xpos, uint ypo
  * @param basex X position of the sprite in the screen.
  * @param basey Y position of the sprite in the screen.
  * @param orient View orientation.
+ * @param tile_width Width of a tile in pixels.
  * @param number Ride instance number.
  * @param voxel_number Number of the voxel.
  * @param dd [out] Data to draw (4 entries).
  * @param platform [out] Shape of the support platform, if needed. @see PathSprites
  * @return The number of \a dd entries filled.
  */
-static int DrawRide(int32 slice, int zpos, int32 basex, int32 basey, ViewOrientation orient, uint16 number, uint16 voxel_number, DrawData *dd, uint8 *platform)
+static int DrawRide(int32 slice, int zpos, int32 basex, int32 basey, ViewOrientation orient, uint16 tile_width, uint16 number, uint16 voxel_number, DrawData *dd, uint8 *platform)
 {
 	const RideInstance *ri = _rides_manager.GetRideInstance(number);
 	if (ri == nullptr) return 0;
@@ -844,7 +1011,7 @@ static int DrawRide(int32 slice, int zpos, int32 basex, int32 basey, ViewOrienta
 		dd[idx].level = slice;
 		dd[idx].z_height = zpos;
 		dd[idx].order = sprite_numbers[i];
-		dd[idx].sprite = sprites[i];
+		dd[idx].sprite = sprites[i]->GetZoomed(tile_width);
 		dd[idx].base.x = basex;
 		dd[idx].base.y = basey;
 		dd[idx].recolour = &ri->recolours;
@@ -884,11 +1051,16 @@ void SpriteCollector::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_p
 			dd.base.x = this->xoffset + xnorth - this->rect.base.x;
 			dd.base.y = this->yoffset + ynorth - this->rect.base.y + yoffset;
 			dd.recolour = nullptr;
-			this->draw_images.insert(dd);
+			this->draw_images.push_back(dd);
 		}
 		return;
 	}
 
+	if ((this->parts & SCP_STATIC) == 0) {
+		this->CollectVoxelObjects(voxel, slice, voxel_pos, xnorth, ynorth);
+		return;
+	}
+
 	uint8 platform_shape = PATH_INVALID;
 	SmallRideInstance sri = voxel->GetInstance();
 	uint16 instance_data = voxel->GetInstanceData();
@@ -902,13 +1074,13 @@ void SpriteCollector::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_p
 		dd.base.x = this->xoffset + xnorth - this->rect.base.x;
 		dd.base.y = this->yoffset + ynorth - this->rect.base.y;
 		dd.recolour = nullptr;
-		this->draw_images.insert(dd);
+		this->draw_images.push_back(dd);
 	} else if (sri >= SRI_FULL_RIDES) { // A normal ride.
 		DrawData dd[4];
 		int count = DrawRide(slice, voxel_pos.z,
 				this->xoffset + xnorth - this->rect.base.x, this->yoffset + ynorth - this->rect.base.y,
-				this->orient, sri, instance_data, dd, &platform_shape);
-		for (int i = 0; i < count; i++) this->draw_images.insert(dd[i]);
+				this->orient, this->tile_width, sri, instance_data, dd, &platform_shape);
+		for (int i = 0; i < count; i++) this->draw_images.push_back(dd[i]);
 	}
 
 	/* Foundations. */
@@ -934,7 +1106,7 @@ void SpriteCollector::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_p
 				dd.base.x = this->xoffset + xnorth - this->rect.base.x;
 				dd.base.y = this->yoffset + ynorth - this->rect.base.y;
 				dd.recolour = nullptr;
-				this->draw_images.insert(dd);
+				this->draw_images.push_back(dd);
 			}
 		}
 		if (se != 0) {
@@ -948,7 +1120,7 @@ void SpriteCollector::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_p
 				dd.base.x = this->xoffset + xnorth - this->rect.base.x;
 				dd.base.y = this->yoffset + ynorth - this->rect.base.y;
 				dd.recolour = nullptr;
-				this->draw_images.insert(dd);
+				this->draw_images.push_back(dd);
 			}
 		}
 	}
@@ -966,7 +1138,7 @@ void SpriteCollector::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_p
 		dd.base.x = this->xoffset + xnorth - this->rect.base.x;
 		dd.base.y = this->yoffset + ynorth - this->rect.base.y;
 		dd.recolour = nullptr;
-		this->draw_images.insert(dd);
+		this->draw_images.push_back(dd);
 		switch (slope) {
 			// XXX There are no sprites for partial support of a platform.
 			case SL_FLAT:
@@ -1020,7 +1192,7 @@ void SpriteCollector::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_p
 			dd.base.x = this->xoffset + xnorth - this->rect.base.x;
 			dd.base.y = this->yoffset + ynorth - this->rect.base.y + extra_y;
 			dd.recolour = nullptr;
-			this->draw_images.insert(dd);
+			this->draw_images.push_back(dd);
 		}
 	}
 
@@ -1036,7 +1208,7 @@ void SpriteCollector::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_p
 		dd.base.x = this->xoffset + xnorth - this->rect.base.x;
 		dd.base.y = this->yoffset + ynorth - this->rect.base.y + cursor_yoffset;
 		dd.recolour = nullptr;
-		this->draw_images.insert(dd);
+		this->draw_images.push_back(dd);
 	}
 
 	/* Add platforms. */
@@ -1059,7 +1231,7 @@ void SpriteCollector::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_p
 			dd.base.x = this->xoffset + xnorth - this->rect.base.x;
 			dd.base.y = this->yoffset + ynorth - this->rect.base.y;
 			dd.recolour = nullptr;
-			this->draw_images.insert(dd);
+			this->draw_images.push_back(dd);
 		}
 
 		/* XXX Use the shape to draw handle bars. */
@@ -1069,7 +1241,7 @@ void SpriteCollector::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_p
 		this->ground_height = -1;
 		uint8 slope = this->ground_slope;
 		while (height < voxel_pos.z) {
-			int yoffset = (voxel_pos.z - height) * this->vp->tile_height; // Compensate y position of support.
+			int yoffset = (voxel_pos.z - height) * this->tile_height; // Compensate y position of support.
 			uint sprnum;
 			if (slope == SL_FLAT) {
 				if (height + 1 < voxel_pos.z) {
@@ -1099,26 +1271,39 @@ void SpriteCollector::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_p
 				dd.base.x = this->xoffset + xnorth - this->rect.base.x;
 				dd.base.y = this->yoffset + ynorth - this->rect.base.y + yoffset;
 				dd.recolour = nullptr;
-				this->draw_images.insert(dd);
+				this->draw_images.push_back(dd);
 			}
 		}
 	}
 
-	/* Add voxel objects (persons, ride cars, etc). */
+	if ((this->parts & SCP_OBJECTS) != 0) this->CollectVoxelObjects(voxel, slice, voxel_pos, xnorth, ynorth);
+}
+
+/**
+ * Add the voxel objects (persons, ride cars, etc) of the voxel to the set of sprites to draw.
+ * @param voxel %Voxel containing the objects.
+ * @param slice Depth of the voxel.
+ * @param voxel_pos World position.
+ * @param xnorth X coordinate of the north corner at the display.
+ * @param ynorth y coordinate of the north corner at the display.
+ */
+void SpriteCollector::CollectVoxelObjects(const Voxel *voxel, int32 slice, const XYZPoint16 &voxel_pos, int32 xnorth, int32 ynorth)
+{
 	const VoxelObject *vo = voxel->voxel_objects;
 	while (vo != nullptr) {
 		DrawData dd;
 		const ImageData *anim_spr = vo->GetSprite(this->sprites, this->orient, &dd.recolour);
 		if (anim_spr != nullptr) {
-			int x_off = ComputeX(vo->pix_pos.x, vo->pix_pos.y);
-			int y_off = ComputeY(vo->pix_pos.x, vo->pix_pos.y, vo->pix_pos.z);
+			XYZPoint16 pix_pos = this->GetObjectPosition(vo);
+			int x_off = ComputeX(pix_pos.x, pix_pos.y);
+			int y_off = ComputeY(pix_pos.x, pix_pos.y, pix_pos.z);
 			dd.level = slice;
 			dd.z_height = voxel_pos.z;
 			dd.order = SO_PERSON;
 			dd.sprite = anim_spr;
 			dd.base.x = this->xoffset + this->north_offsets[this->orient].x + xnorth - this->rect.base.x + x_off;
 			dd.base.y = this->yoffset + this->north_offsets[this->orient].y + ynorth - this->rect.base.y + y_off;
-			this->draw_images.insert(dd);
+			this->draw_images.push_back(dd);
 		}
 		vo = vo->next_object;
 	}
@@ -1148,13 +1333,15 @@ FinderData::FinderData(ClickableSprite allowed, GroundTilePart select)
  * Constructor of the tile position finder.
  * @param vp %Viewport that needs the tile position.
  * @param fdata Finder data.
+ * @param buffer If not \c nullptr, buffer to fill for the entire collect window.
  */
-PixelFinder::PixelFinder(Viewport *vp, FinderData *fdata) : VoxelCollector(vp, false)
+PixelFinder::PixelFinder(Viewport *vp, FinderData *fdata, PickBuffer *buffer) : VoxelCollector(vp, false)
 {
 	this->allowed = fdata->allowed;
 	this->found = false;
 	this->pixel = _palette[0]; // 0 is transparent, and is not used in sprites.
 	this->fdata = fdata;
+	this->buffer = buffer;
 
 	fdata->voxel_pos = XYZPoint16(0, 0, 0);
 	fdata->person = nullptr;
@@ -1165,6 +1352,34 @@ PixelFinder::~PixelFinder()
 {
 }
 
+/**
+ * Check whether a sprite is closer than the match found so far.
+ * @param dd Drawing data of the sprite, with the position of the pixel to examine relative to the base of the sprite.
+ * @param spr %Sprite to examine.
+ * @param voxel_pos Position of the voxel of the sprite.
+ * @param ride Ride instance of the sprite, if any.
+ * @param person Person of the sprite, if any.
+ */
+void PixelFinder::CheckSprite(const DrawData &dd, const ImageData *spr, const XYZPoint16 &voxel_pos, uint16 ride, const Person *person)
+{
+	if (this->buffer != nullptr) {
+		assert(person == nullptr);
+		this->buffer->AddSprite(dd, spr, voxel_pos, ride);
+		return;
+	}
+	if (this->found && !(this->data < dd)) return;
+
+	uint32 pixel = spr->GetPixel(dd.base.x - spr->xoffset, dd.base.y - spr->yoffset);
+	if (GetA(pixel) == TRANSPARENT) return;
+
+	this->found = true;
+	this->data = dd;
+	this->fdata->voxel_pos = voxel_pos;
+	this->pixel = pixel;
+	if (ride != INVALID_RIDE_INSTANCE) this->fdata->ride = ride;
+	if (person != nullptr) this->fdata->person = person;
+}
+
 /**
  * Find the closest sprite.
  * @param voxel %Voxel to examine, \c nullptr means 'cursor above stack'.
@@ -1193,15 +1408,7 @@ void PixelFinder::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_pos,
 		dd.base.x = this->rect.base.x - xnorth;
 		dd.base.y = this->rect.base.y - ynorth;
 		dd.recolour = nullptr;
-		if (spr != nullptr && (!this->found || this->data < dd)) {
-			uint32 pixel = spr->GetPixel(dd.base.x - spr->xoffset, dd.base.y - spr->yoffset);
-			if (pixel != 0) {
-				this->found = true;
-				this->data = dd;
-				this->fdata->voxel_pos = voxel_pos;
-				this->pixel = pixel;
-			}
-		}
+		if (spr != nullptr) this->CheckSprite(dd, spr, voxel_pos, INVALID_RIDE_INSTANCE, nullptr);
 	}
 
 	if (voxel == nullptr) return; // Ignore cursors, they are not clickable.
@@ -1211,20 +1418,8 @@ void PixelFinder::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_pos,
 		/* Looking for a ride? */
 		DrawData dd[4];
 		int count = DrawRide(slice, voxel_pos.z, this->rect.base.x - xnorth, this->rect.base.y - ynorth,
-				this->orient, number, voxel->GetInstanceData(), dd, nullptr);
-		for (int i = 0; i < count; i++) {
-			if (!this->found || this->data < dd[i]) {
-				const ImageData *img = dd[i].sprite;
-				uint32 pixel = img->GetPixel(dd[i].base.x - img->xoffset, dd[i].base.y - img->yoffset);
-				if (GetA(pixel) != TRANSPARENT) {
-					this->found = true;
-					this->data = dd[i];
-					this->fdata->voxel_pos = voxel_pos;
-					this->pixel = pixel;
-					this->fdata->ride = number;
-				}
-			}
-		}
+				this->orient, this->tile_width, number, voxel->GetInstanceData(), dd, nullptr);
+		for (int i = 0; i < count; i++) this->CheckSprite(dd[i], dd[i].sprite, voxel_pos, number, nullptr);
 	} else if ((this->allowed & CS_PATH) != 0 && HasValidPath(voxel)) {
 		/* Looking for a path? */
 		uint16 instance_data = voxel->GetInstanceData();
@@ -1237,15 +1432,7 @@ void PixelFinder::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_pos,
 		dd.base.x = this->rect.base.x - xnorth;
 		dd.base.y = this->rect.base.y - ynorth;
 		dd.recolour = nullptr;
-		if (img != nullptr && (!this->found || this->data < dd)) {
-			uint32 pixel = img->GetPixel(dd.base.x - img->xoffset, dd.base.y - img->yoffset);
-			if (GetA(pixel) != TRANSPARENT) {
-				this->found = true;
-				this->data = dd;
-				this->fdata->voxel_pos = voxel_pos;
-				this->pixel = pixel;
-			}
-		}
+		if (img != nullptr) this->CheckSprite(dd, img, voxel_pos, INVALID_RIDE_INSTANCE, nullptr);
 	} else if ((this->allowed & CS_GROUND) != 0 && voxel->GetGroundType() != GTP_INVALID) {
 		/* Looking for surface? */
 		const ImageData *spr = this->sprites->GetSurfaceSprite(GTP_CURSOR_TEST, voxel->GetGroundSlope(), this->orient);
@@ -1257,15 +1444,7 @@ void PixelFinder::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_pos,
 		dd.base.x = this->rect.base.x - xnorth;
 		dd.base.y = this->rect.base.y - ynorth;
 		dd.recolour = nullptr;
-		if (spr != nullptr && (!this->found || this->data < dd)) {
-			uint32 pixel = spr->GetPixel(dd.base.x - spr->xoffset, dd.base.y - spr->yoffset);
-			if (GetA(pixel) != TRANSPARENT) {
-				this->found = true;
-				this->data = dd;
-				this->fdata->voxel_pos = voxel_pos;
-				this->pixel = pixel;
-			}
-		}
+		if (spr != nullptr) this->CheckSprite(dd, spr, voxel_pos, INVALID_RIDE_INSTANCE, nullptr);
 	} else if ((this->allowed & CS_PERSON) != 0) {
 		/* Looking for persons? */
 		const VoxelObject *vo = voxel->voxel_objects;
@@ -1274,8 +1453,9 @@ void PixelFinder::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_pos,
 			assert(pers != nullptr && pers->walk != nullptr);
 			AnimationType anim_type = pers->walk->anim_type;
 			const ImageData *anim_spr = this->sprites->GetAnimationSprite(anim_type, pers->frame_index, pers->type, this->orient);
-			int x_off = ComputeX(pers->pix_pos.x, pers->pix_pos.y);
-			int y_off = ComputeY(pers->pix_pos.x, pers->pix_pos.y, pers->pix_pos.z);
+			XYZPoint16 pix_pos = this->GetObjectPosition(pers);
+			int x_off = ComputeX(pix_pos.x, pix_pos.y);
+			int y_off = ComputeY(pix_pos.x, pix_pos.y, pix_pos.z);
 			DrawData dd;
 			dd.level = slice;
 			dd.z_height = voxel_pos.z;
@@ -1284,21 +1464,117 @@ void PixelFinder::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_pos,
 			dd.base.x = this->rect.base.x - xnorth - x_off;
 			dd.base.y = this->rect.base.y - ynorth - y_off;
 			dd.recolour = nullptr;
-			if (anim_spr && (!this->found || this->data < dd)) {
-				uint32 pixel = anim_spr->GetPixel(dd.base.x - anim_spr->xoffset, dd.base.y - anim_spr->yoffset);
-				if (GetA(pixel) != TRANSPARENT) {
-					this->found = true;
-					this->data = dd;
-					this->fdata->voxel_pos = voxel_pos;
-					this->pixel = pixel;
-					this->fdata->person = pers;
-				}
-			}
+			if (anim_spr != nullptr) this->CheckSprite(dd, anim_spr, voxel_pos, INVALID_RIDE_INSTANCE, pers);
 			vo = vo->next_object;
 		}
 	}
 }
 
+/** Palette indices of the colours in the cursor test sprites that denote a corner or an edge of a tile. */
+static const uint8 _pick_colours[] = {181, 182, 184, 185};
+
+/**
+ * Get the colour class of a pixel for the #PickBuffer.
+ * @param colour Colour of the pixel.
+ * @return \c 0 for a pixel without special meaning, else \c 1 plus the index of the colour in #_pick_colours.
+ */
+static uint32 GetPickColour(uint32 colour)
+{
+	for (uint i = 0; i < lengthof(_pick_colours); i++) {
+		if (colour == _palette[_pick_colours[i]]) return i + 1;
+	}
+	return 0;
+}
+
+PickBuffer::PickBuffer() : valid(false)
+{
+}
+
+/**
+ * Can the buffer be used to find a sprite in the viewport?
+ * @param vp %Viewport to search.
+ * @param allowed Sprite types looking for.
+ * @return Whether the buffer is still up to date.
+ */
+bool PickBuffer::IsValid(const Viewport *vp, ClickableSprite allowed) const
+{
+	if (!this->valid || this->change_count != _world.GetChangeCount() || this->allowed != allowed) return false;
+	if (this->view_pos != vp->view_pos || this->tile_width != vp->tile_width || this->orient != vp->orientation) return false;
+	return this->width == vp->rect.width && this->height == vp->rect.height;
+}
+
+/**
+ * Fill the buffer for the entire viewport.
+ * @param vp %Viewport to search.
+ * @param fdata Finder data with the sprite types to look for.
+ */
+void PickBuffer::Rebuild(Viewport *vp, FinderData *fdata)
+{
+	assert((fdata->allowed & CS_PERSON) == 0); // Persons move too often to cache them.
+
+	this->valid = true;
+	this->view_pos = vp->view_pos;
+	this->tile_width = vp->tile_width;
+	this->orient = vp->orientation;
+	this->width = vp->rect.width;
+	this->height = vp->rect.height;
+	this->change_count = _world.GetChangeCount();
+	this->allowed = fdata->allowed;
+
+	this->pixels.assign((size_t)this->width * this->height, 0);
+	this->picks.clear();
+
+	PixelFinder finder(vp, fdata, this);
+	finder.SetWindowSize(-(int16)this->width / 2, -(int16)this->height / 2, this->width, this->height);
+	finder.Collect(false);
+}
+
+/**
+ * Add a sprite to the buffer, at the pixels where it is closer than the sprite found so far.
+ * @param dd Drawing data of the sprite, with the position of the top-left of the buffer relative to the base of the sprite.
+ * @param spr %Sprite to add.
+ * @param voxel_pos Position of the voxel of the sprite.
+ * @param ride Ride instance of the sprite, if any.
+ */
+void PickBuffer::AddSprite(const DrawData &dd, const ImageData *spr, const XYZPoint16 &voxel_pos, uint16 ride)
+{
+	static const Recolouring recolour;
+
+	int32 x_base = spr->xoffset - dd.base.x;
+	int32 y_base = spr->yoffset - dd.base.y;
+	if (x_base >= this->width || x_base + spr->width <= 0) return;
+	if (y_base >= this->height || y_base + spr->height <= 0) return;
+
+	DecodedSprite local;
+	const DecodedSprite *decoded = _video.sprite_cache.Get(spr, recolour, GS_NORMAL);
+	if (decoded == nullptr) {
+		local.Decode(spr, recolour, GS_NORMAL);
+		decoded = &local;
+	}
+
+	uint32 index = 0; // Index of the sprite in #picks plus one, \c 0 means not added yet.
+	for (const DecodedSpan &span : decoded->spans) {
+		int32 y = y_base + span.y;
+		if (y < 0 || y >= this->height) continue;
+
+		int32 x = x_base + span.x;
+		const uint32 *colour = &decoded->pixels[span.first];
+		uint32 *row = &this->pixels[y * this->width];
+		for (int i = 0; i < span.length; i++, x++, colour++) {
+			if (x < 0 || x >= this->width || GetA(*colour) == TRANSPARENT) continue;
+
+			uint32 current = row[x] & PICK_INDEX_MASK;
+			if (current != 0 && !(this->picks[current - 1].data < dd)) continue; // Existing sprite is closer.
+
+			if (index == 0) {
+				this->picks.push_back({dd, voxel_pos, ride});
+				index = this->picks.size();
+			}
+			row[x] = index | (GetPickColour(*colour) << PICK_COLOUR_SHIFT);
+		}
+	}
+}
+
 /**
  * %Viewport constructor.
  * @param view_pos Pixel position of the center viewpoint of the main display.
@@ -1317,6 +1593,8 @@ Viewport::Viewport(const XYZPoint32 &view_pos) : Window(WC_MAINDISPLAY, ALL_WIND
 	this->additions_enabled = false;
 	this->additions_displayed = false;
 	this->underground_mode = false;
+	this->static_layer = new StaticLayer;
+	this->pick_buffer = new PickBuffer;
 
 	uint16 width  = _video.GetXSize();
 	uint16 height = _video.GetYSize();
@@ -1329,6 +1607,8 @@ Viewport::Viewport(const XYZPoint32 &view_pos) : Window(WC_MAINDISPLAY, ALL_WIND
 Viewport::~Viewport()
 {
 	_mouse_modes.main_display = nullptr;
+	delete this->static_layer;
+	delete this->pick_buffer;
 }
 
 /**
@@ -1371,6 +1651,252 @@ int32 Viewport::ComputeX(int32 xpos, int32 ypos)
 	return ComputeXFunction(xpos, ypos, this->orientation, this->tile_width);
 }
 
+/** A sprite to draw in a band of the viewport. */
+struct BandedImage {
+	Point32 base;                 ///< Base position of the sprite.
+	const ImageData *sprite;      ///< Sprite to draw.
+	const DecodedSprite *decoded; ///< Decoded version of #sprite.
+};
+
+static const int MIN_BAND_HEIGHT = 32; ///< Minimal height of a band of the viewport in pixels.
+
+/**
+ * Draw the collected sprites in horizontal bands, using all threads of the #_worker_pool.
+ * Each band gets the sprites that overlap with it in the same order as the single-threaded drawing, so the result is the same.
+ * @tparam C Container of #DrawData, in drawing order.
+ * @param draw_images Sprites to draw.
+ * @param draw_rect Area to draw in.
+ * @param gs Gradient shift to apply.
+ * @return Whether the sprites were drawn. If not, the caller should draw them.
+ */
+template <typename C>
+static bool DrawImagesInBands(const C &draw_images, ClippedRectangle draw_rect, GradientShift gs)
+{
+	static const Recolouring recolour;
+
+	int band_count = std::min(_worker_pool.GetThreadCount() * 2, draw_rect.height / MIN_BAND_HEIGHT);
+	if (band_count < 2) return false;
+	int band_height = (draw_rect.height + band_count - 1) / band_count;
+
+	/* Decode all sprites beforehand, the sprite cache cannot be used from several threads. */
+	std::vector<BandedImage> images;
+	images.reserve(draw_images.size());
+	_video.sprite_cache.StartBatch();
+	for (const DrawData &dd : draw_images) {
+		const Recolouring &rec = (dd.recolour == nullptr) ? recolour : *dd.recolour;
+		const DecodedSprite *decoded = _video.sprite_cache.Get(dd.sprite, rec, gs);
+		if (decoded == nullptr) {
+			_video.sprite_cache.EndBatch();
+			return false;
+		}
+		images.push_back({dd.base, dd.sprite, decoded});
+	}
+
+	/* Distribute the sprites over the bands. */
+	std::vector<std::vector<uint32>> bands(band_count);
+	for (uint32 i = 0; i < images.size(); i++) {
+		const BandedImage &bi = images[i];
+		int32 top = bi.base.y + bi.sprite->yoffset;
+		int32 bottom = top + bi.sprite->height;
+		if (bottom <= 0 || top >= draw_rect.height) continue;
+
+		int first = std::max(top, 0) / band_height;
+		int last = std::min((bottom - 1) / band_height, band_count - 1);
+		for (int b = first; b <= last; b++) bands[b].push_back(i);
+	}
+
+	_worker_pool.Run(band_count, [&](int b) {
+		int32 ypos = b * band_height;
+		ClippedRectangle band_rect(draw_rect, 0, ypos, draw_rect.width, band_height);
+		if (band_rect.height == 0) return;
+
+		band_rect.ValidateAddress();
+		for (uint32 index : bands[b]) {
+			const BandedImage &bi = images[index];
+			VideoSystem::BlitDecodedImage(band_rect, {bi.base.x, bi.base.y - ypos}, bi.sprite, bi.decoded);
+		}
+	});
+
+	_video.sprite_cache.EndBatch();
+	return true;
+}
+
+StaticLayer::StaticLayer() : valid(false)
+{
+}
+
+/**
+ * Get the colours of a recolouring, for detecting changes in it.
+ * @param recolour Recolouring to examine.
+ * @return Value that changes when the colours of \a recolour change.
+ */
+static inline uint64 GetRecolourKey(const Recolouring &recolour)
+{
+	return SpriteCacheKey(nullptr, recolour, GS_NORMAL).recolour;
+}
+
+/**
+ * Can the layer be used to draw the viewport?
+ * @param vp %Viewport to draw.
+ * @param gs Gradient shift of the sprites.
+ * @return Whether the rendered layer is still up to date.
+ */
+bool StaticLayer::IsValid(const Viewport *vp, GradientShift gs) const
+{
+	if (!this->valid || this->change_count != _world.GetChangeCount()) return false;
+	if (this->view_pos != vp->view_pos || this->tile_width != vp->tile_width || this->orient != vp->orientation) return false;
+	if (this->underground_mode != vp->underground_mode || this->gs != gs) return false;
+	if (this->width != vp->rect.width || this->height != vp->rect.height) return false;
+
+	for (const auto &rec : this->recolours) {
+		if (GetRecolourKey(*rec.first) != rec.second) return false;
+	}
+	return true;
+}
+
+/**
+ * Collect and render the static sprites of the viewport.
+ * @param vp %Viewport to draw.
+ * @param gs Gradient shift of the sprites.
+ */
+void StaticLayer::Rebuild(Viewport *vp, GradientShift gs)
+{
+	static const Recolouring recolour;
+
+	this->valid = true;
+	this->view_pos = vp->view_pos;
+	this->tile_width = vp->tile_width;
+	this->orient = vp->orientation;
+	this->underground_mode = vp->underground_mode;
+	this->width = vp->rect.width;
+	this->height = vp->rect.height;
+	this->gs = gs;
+	this->change_count = _world.GetChangeCount();
+
+	SpriteCollector collector(vp, false, SCP_STATIC);
+	collector.SetWindowSize(-(int16)this->width / 2, -(int16)this->height / 2, this->width, this->height);
+	collector.Collect(false);
+
+	this->images.swap(collector.draw_images);
+	this->recolours.clear();
+	for (const DrawData &dd : this->images) {
+		if (dd.recolour == nullptr) continue;
+
+		bool found = false;
+		for (const auto &rec : this->recolours) {
+			if (rec.first == dd.recolour) {
+				found = true;
+				break;
+			}
+		}
+		if (!found) this->recolours.emplace_back(dd.recolour, GetRecolourKey(*dd.recolour));
+	}
+
+	/* Render the sprites into the layer. */
+	PROFILE_SCOPE(PFS_BLIT);
+	this->pixels.assign((size_t)this->width * this->height, MakeRGBA(0, 0, 0, OPAQUE)); // Black background.
+	ClippedRectangle layer_rect(0, 0, this->width, this->height);
+	layer_rect.address = this->pixels.data();
+	layer_rect.pitch = this->width;
+
+	if (!DrawImagesInBands(this->images, layer_rect, gs)) {
+		ClippedRectangle cr = _video.GetClippedRectangle();
+		_video.SetClippedRectangle(layer_rect);
+		for (const DrawData &dd : this->images) {
+			const Recolouring &rec = (dd.recolour == nullptr) ? recolour : *dd.recolour;
+			_video.BlitImage(dd.base, dd.sprite, rec, gs);
+		}
+		_video.SetClippedRectangle(cr);
+	}
+
+	/* Distribute the sprites over the rows. */
+	int row_count = (this->height + STATIC_ROW_HEIGHT - 1) / STATIC_ROW_HEIGHT;
+	this->rows.assign(row_count, std::vector<uint32>());
+	for (uint32 i = 0; i < this->images.size(); i++) {
+		const DrawData &dd = this->images[i];
+		int32 top = dd.base.y + dd.sprite->yoffset;
+		int32 bottom = top + dd.sprite->height;
+		if (bottom <= 0 || top >= this->height) continue;
+
+		int first = std::max(top, 0) / STATIC_ROW_HEIGHT;
+		int last = std::min((bottom - 1) / STATIC_ROW_HEIGHT, row_count - 1);
+		for (int r = first; r <= last; r++) this->rows[r].push_back(i);
+	}
+}
+
+/**
+ * Draw the viewport from its static layer, and draw the voxel objects on top of it.
+ * @param draw_rect Area of the viewport at the screen.
+ * @param gs Gradient shift to apply.
+ * @pre The clipped rectangle of the video system is \a draw_rect.
+ */
+void Viewport::DrawStaticLayer(const ClippedRectangle &draw_rect, GradientShift gs)
+{
+	static const Recolouring recolour;
+
+	StaticLayer *sl = this->static_layer;
+	if (!sl->IsValid(this, gs)) sl->Rebuild(this, gs);
+
+	SpriteCollector collector(this, false, SCP_OBJECTS);
+	collector.SetWindowSize(-(int16)this->rect.width / 2, -(int16)this->rect.height / 2, this->rect.width, this->rect.height);
+	collector.Collect(false);
+
+	PROFILE_SCOPE(PFS_BLIT);
+	ClippedRectangle screen_rect = draw_rect;
+	screen_rect.ValidateAddress();
+	for (int y = 0; y < screen_rect.height; y++) {
+		memcpy(screen_rect.address + y * screen_rect.pitch, &sl->pixels[y * sl->width], screen_rect.width * sizeof(uint32));
+	}
+	if (collector.draw_images.empty()) return;
+
+	/* Find the rows with voxel objects, and their horizontal extent. */
+	int row_count = sl->rows.size();
+	std::vector<std::vector<const DrawData *>> objects(row_count);
+	std::vector<int32> left(row_count, INT32_MAX);
+	std::vector<int32> right(row_count, INT32_MIN);
+	for (const DrawData &dd : collector.draw_images) {
+		int32 top = dd.base.y + dd.sprite->yoffset;
+		int32 bottom = top + dd.sprite->height;
+		int32 xleft = dd.base.x + dd.sprite->xoffset;
+		int32 xright = xleft + dd.sprite->width;
+		if (bottom <= 0 || top >= sl->height || xright <= 0 || xleft >= sl->width) continue;
+
+		int first = std::max(top, 0) / STATIC_ROW_HEIGHT;
+		int last = std::min((bottom - 1) / STATIC_ROW_HEIGHT, row_count - 1);
+		for (int r = first; r <= last; r++) {
+			objects[r].push_back(&dd);
+			left[r] = std::min(left[r], std::max(xleft, 0));
+			right[r] = std::max(right[r], std::min(xright, (int32)sl->width));
+		}
+	}
+
+	/* Redraw the part of each row with voxel objects, merging static sprites and voxel objects in drawing order. */
+	for (int r = 0; r < row_count; r++) {
+		if (objects[r].empty()) continue;
+
+		int32 ypos = r * STATIC_ROW_HEIGHT;
+		ClippedRectangle row_rect(screen_rect, left[r], ypos, right[r] - left[r], STATIC_ROW_HEIGHT);
+		_video.SetClippedRectangle(row_rect);
+		_video.FillRectangle(Rectangle32(0, 0, row_rect.width, row_rect.height), MakeRGBA(0, 0, 0, OPAQUE));
+
+		const std::vector<uint32> &statics = sl->rows[r];
+		const std::vector<const DrawData *> &dynamics = objects[r];
+		uint32 si = 0;
+		uint32 di = 0;
+		while (si < statics.size() || di < dynamics.size()) {
+			const DrawData *dd;
+			if (di == dynamics.size() || (si < statics.size() && !(*dynamics[di] < sl->images[statics[si]]))) {
+				dd = &sl->images[statics[si++]];
+			} else {
+				dd = dynamics[di++];
+			}
+			const Recolouring &rec = (dd->recolour == nullptr) ? recolour : *dd->recolour;
+			_video.BlitImage(Point32(dd->base.x - left[r], dd->base.y - ypos), dd->sprite, rec, gs);
+		}
+	}
+	_video.SetClippedRectangle(draw_rect);
+}
+
 /**
  * Get relative Y position of a point in the world (used for marking window parts dirty).
  * @param xpos X world position.
@@ -1383,37 +1909,143 @@ int32 Viewport::ComputeY(int32 xpos, int32 ypos, int32 zpos)
 	return ComputeYFunction(xpos, ypos, zpos, this->orientation, this->tile_width, this->tile_height);
 }
 
+/**
+ * The viewport always paints its entire area, the static layer or a black background covers it.
+ * @return The viewport is opaque.
+ */
+bool Viewport::IsOpaque() const
+{
+	return true;
+}
+
 void Viewport::OnDraw()
 {
-	SpriteCollector collector(this, _mouse_modes.current->EnableCursors());
+	ClippedRectangle cr = _video.GetClippedRectangle();
+	assert(this->rect.base.x >= 0 && this->rect.base.y >= 0);
+	ClippedRectangle draw_rect(cr, this->rect.base.x, this->rect.base.y, this->rect.width, this->rect.height);
+	GradientShift gs = static_cast<GradientShift>(GS_LIGHT - _weather.GetWeatherType());
+
+	bool enable_cursors = _mouse_modes.current->EnableCursors();
+	if (!this->additions_enabled && !enable_cursors) {
+		/* Nothing but the voxel objects changes often, draw from the static layer. */
+		_video.SetClippedRectangle(draw_rect);
+		this->DrawStaticLayer(draw_rect, gs);
+		_video.SetClippedRectangle(cr);
+		return;
+	}
+
+	SpriteCollector collector(this, enable_cursors);
 	collector.SetWindowSize(-(int16)this->rect.width / 2, -(int16)this->rect.height / 2, this->rect.width, this->rect.height);
 	collector.Collect(this->additions_enabled && this->additions_displayed);
 	static const Recolouring recolour;
 
+	PROFILE_SCOPE(PFS_BLIT);
 	_video.FillRectangle(this->rect, MakeRGBA(0, 0, 0, OPAQUE)); // Black background.
-
-	ClippedRectangle cr = _video.GetClippedRectangle();
-	assert(this->rect.base.x >= 0 && this->rect.base.y >= 0);
-	ClippedRectangle draw_rect(cr, this->rect.base.x, this->rect.base.y, this->rect.width, this->rect.height);
 	_video.SetClippedRectangle(draw_rect);
 
-	GradientShift gs = static_cast<GradientShift>(GS_LIGHT - _weather.GetWeatherType());
-	for (const auto &iter : collector.draw_images) {
-		const DrawData &dd = iter;
-		const Recolouring &rec = (dd.recolour == nullptr) ? recolour : *dd.recolour;
-		_video.BlitImage(dd.base, dd.sprite, rec, gs);
+	if (!DrawImagesInBands(collector.draw_images, draw_rect, gs)) {
+		for (const auto &iter : collector.draw_images) {
+			const DrawData &dd = iter;
+			const Recolouring &rec = (dd.recolour == nullptr) ? recolour : *dd.recolour;
+			_video.BlitImage(dd.base, dd.sprite, rec, gs);
+		}
 	}
 
 	_video.SetClippedRectangle(cr);
 }
 
+static const uint16 WORLD_RENDER_TILE_SIZE = 1024; ///< Maximal width and height in pixels of a tile of an off-screen world image.
+
+/**
+ * Draw the entire world off-screen, without cursors and world additions.
+ * The image is drawn in tiles of at most #WORLD_RENDER_TILE_SIZE pixels, which limits the number of sprites collected at the same time.
+ * @param orient Direction of view.
+ * @param tile_width Width of a voxel tile in pixels, which selects the zoom level.
+ * @param image [out] Image of the world, empty if the world has nothing to draw.
+ * @param banded Draw the sprites in bands with the threads of the #_worker_pool, else draw them one by one in this thread.
+ * @return Whether sprites with the requested tile width are available.
+ */
+bool RenderWorld(ViewOrientation orient, uint16 tile_width, WorldImage *image, bool banded)
+{
+	static const Recolouring recolour;
+
+	image->pixels.clear();
+	image->width = 0;
+	image->height = 0;
+	image->tile_count = 0;
+	image->banded_tile_count = 0;
+	image->sprite_count = 0;
+	if (_sprite_manager.GetSprites(tile_width) == nullptr) return false;
+
+	GradientShift gs = static_cast<GradientShift>(GS_LIGHT - _weather.GetWeatherType());
+	XYZPoint32 origin(0, 0, 0); // Sprite positions are relative to the display position of the origin.
+
+	/* Find the area covered by the sprites of the world. */
+	int32 left = INT32_MAX;
+	int32 top = INT32_MAX;
+	int32 right = INT32_MIN;
+	int32 bottom = INT32_MIN;
+	{
+		SpriteCollector collector(origin, tile_width, orient);
+		collector.rect = Rectangle32(-(1 << 24), -(1 << 24), 1 << 25, 1 << 25);
+		collector.Collect(false);
+		for (const DrawData &dd : collector.draw_images) {
+			int32 xpos = collector.rect.base.x + dd.base.x + dd.sprite->xoffset;
+			int32 ypos = collector.rect.base.y + dd.base.y + dd.sprite->yoffset;
+			left = std::min(left, xpos);
+			top = std::min(top, ypos);
+			right = std::max(right, xpos + dd.sprite->width);
+			bottom = std::max(bottom, ypos + dd.sprite->height);
+		}
+	}
+	if (left >= right || top >= bottom) return true;
+
+	image->width = right - left;
+	image->height = bottom - top;
+	image->pixels.assign((size_t)image->width * image->height, MakeRGBA(0, 0, 0, OPAQUE)); // Black background.
+
+	for (uint32 ty = 0; ty < image->height; ty += WORLD_RENDER_TILE_SIZE) {
+		for (uint32 tx = 0; tx < image->width; tx += WORLD_RENDER_TILE_SIZE) {
+			uint16 width = std::min<uint32>(WORLD_RENDER_TILE_SIZE, image->width - tx);
+			uint16 height = std::min<uint32>(WORLD_RENDER_TILE_SIZE, image->height - ty);
+
+			SpriteCollector collector(origin, tile_width, orient);
+			collector.rect = Rectangle32(left + tx, top + ty, width, height);
+			collector.Collect(false);
+			image->tile_count++;
+			image->sprite_count += collector.draw_images.size();
+
+			PROFILE_SCOPE(PFS_BLIT);
+			ClippedRectangle tile_rect(0, 0, width, height);
+			tile_rect.address = image->pixels.data() + tx + (size_t)ty * image->width;
+			tile_rect.pitch = image->width;
+
+			if (banded && DrawImagesInBands(collector.draw_images, tile_rect, gs)) {
+				image->banded_tile_count++;
+			} else {
+				ClippedRectangle cr = _video.GetClippedRectangle();
+				_video.SetClippedRectangle(tile_rect);
+				for (const DrawData &dd : collector.draw_images) {
+					const Recolouring &rec = (dd.recolour == nullptr) ? recolour : *dd.recolour;
+					_video.BlitImage(dd.base, dd.sprite, rec, gs);
+				}
+				_video.SetClippedRectangle(cr);
+			}
+		}
+	}
+	return true;
+}
+
 /**
  * Mark a voxel as in need of getting painted.
  * @param voxel_pos Position of the voxel.
  * @param height Number of voxels to mark above the specified coordinate (\c 0 means inspect the voxel itself).
+ * @param world_changed Whether the static contents of the voxel changed (else only voxel objects moved), which invalidates the cached static layer.
  */
-void Viewport::MarkVoxelDirty(const XYZPoint16 &voxel_pos, int16 height)
+void Viewport::MarkVoxelDirty(const XYZPoint16 &voxel_pos, int16 height, bool world_changed)
 {
+	if (world_changed) _world.NotifyChange(voxel_pos.x, voxel_pos.y);
+
 	if (height <= 0) {
 		const Voxel *v = _world.GetVoxel(voxel_pos);
 		if (v == nullptr) {
@@ -1474,41 +2106,65 @@ void Viewport::MarkVoxelDirty(const XYZPoint16 &voxel_pos, int16 height)
  */
 ClickableSprite Viewport::ComputeCursorPosition(FinderData *fdata)
 {
-	int16 xp = this->mouse_pos.x - this->rect.width / 2;
-	int16 yp = this->mouse_pos.y - this->rect.height / 2;
-	PixelFinder collector(this, fdata);
-	collector.SetWindowSize(xp, yp, 1, 1);
-	collector.Collect(false);
-	if (!collector.found) return CS_NONE;
+	SpriteOrder order;
+	uint32 pixel;
+	if ((fdata->allowed & CS_PERSON) == 0) {
+		/* Only static sprites are wanted, look them up in the pick buffer. */
+		if (!this->pick_buffer->IsValid(this, fdata->allowed)) this->pick_buffer->Rebuild(this, fdata);
+		if (this->mouse_pos.x < 0 || this->mouse_pos.x >= this->pick_buffer->width) return CS_NONE;
+		if (this->mouse_pos.y < 0 || this->mouse_pos.y >= this->pick_buffer->height) return CS_NONE;
+
+		uint32 value = this->pick_buffer->pixels[this->mouse_pos.y * this->pick_buffer->width + this->mouse_pos.x];
+		uint32 index = value & PICK_INDEX_MASK;
+		if (index == 0) return CS_NONE;
+
+		const PickData &pd = this->pick_buffer->picks[index - 1];
+		fdata->voxel_pos = pd.voxel_pos;
+		fdata->person = nullptr;
+		fdata->ride = pd.ride;
+		order = pd.data.order;
+		uint32 colour = value >> PICK_COLOUR_SHIFT;
+		pixel = (colour == 0) ? _palette[0] : _palette[_pick_colours[colour - 1]];
+	} else {
+		int16 xp = this->mouse_pos.x - this->rect.width / 2;
+		int16 yp = this->mouse_pos.y - this->rect.height / 2;
+		PixelFinder collector(this, fdata);
+		collector.SetWindowSize(xp, yp, 1, 1);
+		collector.Collect(false);
+		if (!collector.found) return CS_NONE;
+
+		order = collector.data.order;
+		pixel = collector.pixel;
+	}
 
 	fdata->cursor = fdata->select == FW_EDGE ? CUR_TYPE_EDGE_NE : CUR_TYPE_TILE;
-	if (fdata->select == FW_CORNER && (collector.data.order & CS_MASK) == CS_GROUND) {
-		if (collector.pixel == _palette[181]) {
+	if (fdata->select == FW_CORNER && (order & CS_MASK) == CS_GROUND) {
+		if (pixel == _palette[181]) {
 			fdata->cursor = (CursorType)AddOrientations(VOR_NORTH, this->orientation);
-		} else if (collector.pixel == _palette[182]) {
+		} else if (pixel == _palette[182]) {
 			fdata->cursor = (CursorType)AddOrientations(VOR_EAST,  this->orientation);
-		} else if (collector.pixel == _palette[184]) {
+		} else if (pixel == _palette[184]) {
 			fdata->cursor = (CursorType)AddOrientations(VOR_WEST,  this->orientation);
-		} else if (collector.pixel == _palette[185]) {
+		} else if (pixel == _palette[185]) {
 			fdata->cursor = (CursorType)AddOrientations(VOR_SOUTH, this->orientation);
 		}
 	}
-	else if (fdata->select == FW_EDGE && (collector.data.order & CS_MASK) == CS_GROUND_EDGE) {
+	else if (fdata->select == FW_EDGE && (order & CS_MASK) == CS_GROUND_EDGE) {
 		uint8 base_edge = EDGE_COUNT;
-		if (collector.pixel == _palette[181]) {
+		if (pixel == _palette[181]) {
 			base_edge = (uint8)EDGE_NE;
-		} else if (collector.pixel == _palette[182]) {
+		} else if (pixel == _palette[182]) {
 			base_edge = (uint8)EDGE_SE;
-		} else if (collector.pixel == _palette[184]) {
+		} else if (pixel == _palette[184]) {
 			base_edge = (uint8)EDGE_NW;
-		} else if (collector.pixel == _palette[185]) {
+		} else if (pixel == _palette[185]) {
 			base_edge = (uint8)EDGE_SW;
 		}
 		if (base_edge < EDGE_COUNT) {
 			fdata->cursor = (CursorType)((base_edge + (uint8)this->orientation) % 4 + (uint8)CUR_TYPE_EDGE_NE);
 		}
 	}
-	return (ClickableSprite)(collector.data.order & CS_MASK);
+	return (ClickableSprite)(order & CS_MASK);
 }
 
 /**
@@ -1523,6 +2179,23 @@ void Viewport::Rotate(int direction)
 	this->MarkDirty();
 
 	NotifyChange(WC_PATH_BUILDER, ALL_WINDOWS_OF_TYPE, CHG_VIEWPORT_ROTATED, direction);
+	NotifyChange(WC_BOTTOM_TOOLBAR, ALL_WINDOWS_OF_TYPE, CHG_DISPLAY_OLD, 0); // Update the compass.
+}
+
+/**
+ * Zoom in or out, by switching to the sprites of a larger or smaller tile width. The centre of the view stays at the same position.
+ * @param direction Direction of zooming (positive means zoom in).
+ */
+void Viewport::Zoom(int direction)
+{
+	uint16 width = (direction > 0) ? this->tile_width * 2 : this->tile_width / 2;
+	if (_sprite_manager.GetSprites(width) == nullptr) return; // No sprites of that size.
+
+	this->tile_width = width;
+	this->tile_height = width / 4;
+	Point16 pt = this->mouse_pos;
+	this->OnMouseMoveEvent(pt);
+	this->MarkDirty();
 }
 
 /**
@@ -1657,6 +2330,11 @@ void DefaultMouseMode::LeaveMode()
 {
 }
 
+void DefaultMouseMode::OnMouseWheelEvent(Viewport *vp, int direction)
+{
+	vp->Zoom(direction);
+}
+
 bool DefaultMouseMode::EnableCursors()
 {
 	return false;
@@ -1694,11 +2372,12 @@ Viewport *GetViewport()
  * Mark a voxel as in need of getting painted.
  * @param voxel_pos Position of the voxel.
  * @param height Number of voxels to mark above the specified coordinate (\c 0 means inspect the voxel itself).
+ * @param world_changed Whether the static contents of the voxel changed (else only voxel objects moved).
  */
-void MarkVoxelDirty(const XYZPoint16 &voxel_pos, int16 height)
+void MarkVoxelDirty(const XYZPoint16 &voxel_pos, int16 height, bool world_changed)
 {
 	Viewport *vp = GetViewport();
-	if (vp != nullptr) vp->MarkVoxelDirty(voxel_pos, height);
+	if (vp != nullptr) vp->MarkVoxelDirty(voxel_pos, height, world_changed);
 }
 
 /**
@@ -17,6 +17,8 @@
 class Viewport;
 class Person;
 class RideInstance;
+struct StaticLayer;
+struct PickBuffer;
 
 /**
  * Known mouse modes.
@@ -220,10 +222,12 @@ public:
 	Viewport(const XYZPoint32 &view_pos);
 	~Viewport();
 
-	void MarkVoxelDirty(const XYZPoint16 &voxel_pos, int16 height = 0);
+	void MarkVoxelDirty(const XYZPoint16 &voxel_pos, int16 height = 0, bool world_changed = true);
+	bool IsOpaque() const override;
 	void OnDraw() override;
 
 	void Rotate(int direction);
+	void Zoom(int direction);
 	void MoveViewport(int dx, int dy);
 
 	ClickableSprite ComputeCursorPosition(FinderData *fdata);
@@ -256,6 +260,10 @@ public:
 
 private:
 	bool additions_displayed;    ///< Additions in #_additions are displayed to the user.
+	StaticLayer *static_layer;   ///< Cached rendering of the static parts of the world.
+	PickBuffer *pick_buffer;     ///< Clickable sprites of the static parts of the world, for finding the sprite under the mouse cursor.
+
+	void DrawStaticLayer(const ClippedRectangle &draw_rect, GradientShift gs);
 
 	void OnMouseMoveEvent(const Point16 &pos) override;
 	WmMouseEvent OnMouseButtonEvent(uint8 state) override;
@@ -308,6 +316,7 @@ public:
 	bool MayActivateMode() override;
 	void ActivateMode(const Point16 &pos) override;
 	void LeaveMode() override;
+	void OnMouseWheelEvent(Viewport *vp, int direction) override;
 	bool EnableCursors() override;
 };
 
@@ -337,6 +346,21 @@ void EnableWorldAdditions();
 void DisableWorldAdditions();
 Viewport *GetViewport();
 
-void MarkVoxelDirty(const XYZPoint16 &voxel_pos, int16 height = 0);
+/**
+ * Image of the entire world, drawn off-screen by #RenderWorld.
+ * @ingroup viewport_group
+ */
+struct WorldImage {
+	std::vector<uint32> pixels; ///< Pixels of the image, row by row.
+	uint32 width;               ///< Width of the image in pixels.
+	uint32 height;              ///< Height of the image in pixels.
+	uint32 tile_count;          ///< Number of tiles the image was drawn in.
+	uint32 banded_tile_count;   ///< Number of tiles drawn in bands by several threads.
+	uint64 sprite_count;        ///< Number of sprites collected for drawing, summed over all tiles.
+};
+
+bool RenderWorld(ViewOrientation orient, uint16 tile_width, WorldImage *image, bool banded = true);
+
+void MarkVoxelDirty(const XYZPoint16 &voxel_pos, int16 height = 0, bool world_changed = true);
 
 #endif
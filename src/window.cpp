@@ -29,6 +29,7 @@
 #include "sprite_store.h"
 #include "ride_type.h"
 #include "viewport.h"
+#include "profiler.h"
 
 /**
  * %Window manager.
@@ -225,9 +226,28 @@ Point32 Window::OnInitialPosition()
  */
 void Window::MarkDirty()
 {
+	this->flags |= WF_REPAINT;
 	_video.MarkDisplayDirty(this->rect);
 }
 
+/**
+ * Put the window at the screen while the window manager repaints the display.
+ * By default, the window is drawn each time.
+ */
+void Window::Paint()
+{
+	this->OnDraw();
+}
+
+/**
+ * Does the window cover its entire #rect when painted? Windows below an opaque window need not be painted where it covers them.
+ * @return The window is known to be opaque.
+ */
+bool Window::IsOpaque() const
+{
+	return false;
+}
+
 /**
  * Paint the window to the screen.
  * @note The window manager already locked the surface.
@@ -323,6 +343,9 @@ GuiWindow::GuiWindow(WindowTypes wtype, WindowNumber wnumber) : Window(wtype, wn
 	this->SetHighlight(true);
 	this->ride_type = nullptr;
 	this->initialized = false;
+	this->backing_valid = false;
+	this->backing_opaque = true;
+	this->opacity_known = false;
 }
 
 GuiWindow::~GuiWindow()
@@ -370,6 +393,7 @@ void GuiWindow::ResetSize()
 
 	Rectangle16 min_rect(0, 0, this->tree->min_x, this->tree->min_y);
 	this->tree->SetSmallestSizePosition(min_rect);
+	this->opacity_known = false; // The widgets may cover a different area.
 }
 
 /**
@@ -445,6 +469,144 @@ void GuiWindow::DrawWidget(WidgetNumber wid_num, const BaseWidget *wid) const
 	/* Do nothing by default. */
 }
 
+/**
+ * Copy an area of the screen to a buffer.
+ * @param cr Screen area.
+ * @param area Area to copy, inside \a cr.
+ * @param buffer Destination buffer, with \a area width pixels in a row.
+ */
+static void CopyFromScreen(const ClippedRectangle &cr, const Rectangle32 &area, uint32 *buffer)
+{
+	const uint32 *src = cr.address + area.base.x + area.base.y * cr.pitch;
+	for (uint y = 0; y < area.height; y++) {
+		memcpy(buffer, src, area.width * sizeof(uint32));
+		buffer += area.width;
+		src += cr.pitch;
+	}
+}
+
+/**
+ * Copy a buffer to an area of the screen.
+ * @param cr Screen area.
+ * @param area Area to copy to, inside \a cr.
+ * @param buffer Source buffer, with \a area width pixels in a row.
+ */
+static void CopyToScreen(const ClippedRectangle &cr, const Rectangle32 &area, const uint32 *buffer)
+{
+	uint32 *dest = cr.address + area.base.x + area.base.y * cr.pitch;
+	for (uint y = 0; y < area.height; y++) {
+		memcpy(dest, buffer, area.width * sizeof(uint32));
+		buffer += area.width;
+		dest += cr.pitch;
+	}
+}
+
+/**
+ * Compare an area of the screen with a buffer.
+ * @param cr Screen area.
+ * @param area Area to compare, inside \a cr.
+ * @param buffer Buffer to compare with, with \a area width pixels in a row.
+ * @return Whether the area of the screen has the same pixels as the buffer.
+ */
+static bool IsScreenEqual(const ClippedRectangle &cr, const Rectangle32 &area, const uint32 *buffer)
+{
+	const uint32 *src = cr.address + area.base.x + area.base.y * cr.pitch;
+	for (uint y = 0; y < area.height; y++) {
+		if (memcmp(buffer, src, area.width * sizeof(uint32)) != 0) return false;
+		buffer += area.width;
+		src += cr.pitch;
+	}
+	return true;
+}
+
+/**
+ * Get the part of the window that is inside the screen area.
+ * @param w %Window to examine.
+ * @param cr Screen area.
+ * @return The visible part of the window (may be empty).
+ */
+static Rectangle32 GetVisibleRect(const Window *w, const ClippedRectangle &cr)
+{
+	Rectangle32 visible(w->rect);
+	visible.RestrictTo(0, 0, cr.width, cr.height);
+	return visible;
+}
+
+/**
+ * Put the window at the screen. Unless the window changed, its pixels are copied from the backing store.
+ * Otherwise, the window is drawn once, and its pixels are stored again if it covers its entire area.
+ * Whether it does is found once by #DetermineOpacity, until the widgets or the visible part of the window change.
+ */
+void GuiWindow::Paint()
+{
+	ClippedRectangle cr = _video.GetClippedRectangle();
+	Rectangle32 visible = GetVisibleRect(this, cr);
+	if (visible.width == 0 || visible.height == 0) return;
+
+	if ((this->flags & WF_REPAINT) == 0 && this->backing_valid && this->backing_rect == visible) {
+		CopyToScreen(cr, visible, this->backing.data());
+		return;
+	}
+
+	this->flags &= ~WF_REPAINT;
+	this->backing_valid = false;
+	Rectangle32 area(visible.base.x - this->rect.base.x, visible.base.y - this->rect.base.y, visible.width, visible.height);
+	if (!this->opacity_known || !(this->opacity_area == area)) {
+		this->opacity_area = area;
+		this->opacity_known = true;
+		this->DetermineOpacity();
+		return;
+	}
+
+	this->OnDraw();
+	if (!this->backing_opaque) return; // Window is transparent at some pixels, it cannot be stored.
+
+	this->backing.resize(visible.width * visible.height);
+	CopyFromScreen(cr, visible, this->backing.data());
+	this->backing_rect = visible;
+	this->backing_valid = true;
+}
+
+/**
+ * Draw the window at the screen, and find out whether it covers its entire area by drawing it onto two different backgrounds.
+ * If it does, its pixels are stored in the #backing store.
+ */
+void GuiWindow::DetermineOpacity()
+{
+	ClippedRectangle cr = _video.GetClippedRectangle();
+	Rectangle32 visible = GetVisibleRect(this, cr);
+	size_t count = visible.width * visible.height;
+
+	std::vector<uint32> below(count);
+	CopyFromScreen(cr, visible, below.data());
+
+	this->backing.resize(count);
+	_video.FillRectangle(visible, MakeRGBA(0, 0, 0, OPAQUE));
+	this->OnDraw();
+	CopyFromScreen(cr, visible, this->backing.data());
+
+	_video.FillRectangle(visible, MakeRGBA(255, 255, 255, OPAQUE));
+	this->OnDraw();
+
+	this->backing_rect = visible;
+	this->backing_opaque = IsScreenEqual(cr, visible, this->backing.data());
+	if (this->backing_opaque) {
+		this->backing_valid = true;
+		return;
+	}
+
+	/* Some pixels of the display below show through, draw the window normally. */
+	this->backing.clear();
+	this->backing.shrink_to_fit();
+	CopyToScreen(cr, visible, below.data());
+	this->OnDraw();
+}
+
+bool GuiWindow::IsOpaque() const
+{
+	return this->backing_opaque && this->backing_valid;
+}
+
 void GuiWindow::OnDraw()
 {
 	this->tree->Draw(this);
@@ -654,6 +816,12 @@ void WindowManager::CloseAllWindows()
 	while (this->top != nullptr) delete this->top;
 }
 
+/** Mark the stored contents of all windows as being out of date. */
+void WindowManager::MarkAllWindowsDirty()
+{
+	for (Window *w = this->top; w != nullptr; w = w->lower) w->flags |= WF_REPAINT;
+}
+
 /** Reinitialize all windows in the display. */
 void WindowManager::ResetAllWindows()
 {
@@ -831,6 +999,7 @@ void WindowManager::MouseMoveEvent(const Point16 &pos)
 			Point16 pos2;
 			pos2.x = pos.x - this->current_window->rect.base.x;
 			pos2.y = pos.y - this->current_window->rect.base.y;
+			this->current_window->flags |= WF_REPAINT; // Input may change the contents of the window.
 			this->current_window->OnMouseMoveEvent(pos2);
 			break;
 		}
@@ -863,10 +1032,16 @@ void WindowManager::UpdateCurrentWindow()
 	if (w == this->current_window) return;
 
 	/* Windows are different, send mouse leave/enter events. */
-	if (this->current_window != nullptr && this->HasWindow(this->current_window)) this->current_window->OnMouseLeaveEvent();
+	if (this->current_window != nullptr && this->HasWindow(this->current_window)) {
+		this->current_window->flags |= WF_REPAINT;
+		this->current_window->OnMouseLeaveEvent();
+	}
 
 	this->current_window = w;
-	if (this->current_window != nullptr) this->current_window->OnMouseEnterEvent();
+	if (this->current_window != nullptr) {
+		this->current_window->flags |= WF_REPAINT;
+		this->current_window->OnMouseEnterEvent();
+	}
 }
 
 /**
@@ -923,6 +1098,7 @@ void WindowManager::MouseButtonEvent(MouseButtons button, bool pressed)
 	switch (this->mouse_mode) {
 		case WMMM_PASS_THROUGH:
 			if (newstate != this->mouse_state) {
+				this->current_window->flags |= WF_REPAINT;
 				WmMouseEvent me = this->current_window->OnMouseButtonEvent((this->mouse_state << 4) | newstate);
 				switch (me) {
 					case WMME_NONE:
@@ -959,7 +1135,10 @@ void WindowManager::MouseButtonEvent(MouseButtons button, bool pressed)
 void WindowManager::MouseWheelEvent(int direction)
 {
 	this->UpdateCurrentWindow();
-	if (this->current_window != nullptr) this->current_window->OnMouseWheelEvent(direction);
+	if (this->current_window != nullptr) {
+		this->current_window->flags |= WF_REPAINT;
+		this->current_window->OnMouseWheelEvent(direction);
+	}
 }
 
 /**
@@ -973,43 +1152,128 @@ bool WindowManager::KeyEvent(WmKeyCode key_code, const uint8 *symbol)
 	return false; // \todo Perform key processing in window mouse modes.
 }
 
+/**
+ * Is a rectangle entirely inside another rectangle?
+ * @param inner %Rectangle that may be covered.
+ * @param outer %Rectangle that may cover \a inner.
+ * @return Whether \a outer covers all of \a inner.
+ */
+static bool IsCoveredBy(const Rectangle32 &inner, const Rectangle32 &outer)
+{
+	return inner.base.x >= outer.base.x && inner.base.x + inner.width <= outer.base.x + outer.width &&
+			inner.base.y >= outer.base.y && inner.base.y + inner.height <= outer.base.y + outer.height;
+}
+
+/**
+ * Notify the window of the given type of the change with the specified number.
+ * Notifications of #CHG_DISPLAY_OLD only cause a repaint, they are collected in the #WF_DISPLAY_OLD flag of the window and
+ * delivered once before the next repaint (there may be many game ticks between two repaints). Their parameter is not used.
+ * @param wtype %Window type to look for.
+ * @param wnumber %Window number to look for (use #ALL_WINDOWS_OF_TYPE for any window of type \a wtype).
+ * @param code Unique change number.
+ * @param parameter Parameter of the change number
+ */
+void NotifyChange(WindowTypes wtype, WindowNumber wnumber, ChangeCode code, uint32 parameter)
+{
+	Window *w = GetWindowByType(wtype, wnumber);
+	if (w == nullptr) return;
+
+	if (code == CHG_DISPLAY_OLD) {
+		w->flags |= WF_DISPLAY_OLD;
+		return;
+	}
+	w->flags |= WF_REPAINT;
+	w->OnChange(code, parameter);
+}
+
+/** Deliver the collected #CHG_DISPLAY_OLD notifications of #NotifyChange. */
+static void DeliverDisplayChanges()
+{
+	for (Window *w = _window_manager.top; w != nullptr; w = w->lower) {
+		if ((w->flags & WF_DISPLAY_OLD) == 0) continue;
+
+		w->flags = (w->flags & ~WF_DISPLAY_OLD) | WF_REPAINT;
+		w->OnChange(CHG_DISPLAY_OLD, 0);
+	}
+}
+
 /**
  * Redraw (parts of) the windows.
- * @todo [medium/difficult] Do this much less stupid.
+ * Windows that are completely covered by a single opaque window above them are not painted, other windows are painted
+ * from bottom to top. Gui windows copy their pixels from their backing store when they did not change.
  * @ingroup window_group
  */
 void UpdateWindows()
 {
+	DeliverDisplayChanges();
 	if (!_video.DisplayNeedsRepaint()) return;
+	PROFILE_SCOPE(PFS_UPDATE_WINDOWS);
+	_video.StartRepaint();
+
+	ClippedRectangle cr = _video.GetClippedRectangle();
+	Rectangle32 screen(0, 0, cr.width, cr.height);
+
+	/* Decide which windows to paint, from top to bottom. */
+	std::vector<Window *> painted;
+	std::vector<Rectangle32> opaque; // Visible parts of the opaque windows above the current window.
+	bool background = true; // Whether the background shows through somewhere.
+	for (Window *w = _window_manager.top; w != nullptr; w = w->lower) {
+		Rectangle32 visible = GetVisibleRect(w, cr);
+		if (visible.width == 0 || visible.height == 0) continue;
+
+		bool covered = false;
+		for (const Rectangle32 &r : opaque) {
+			if (IsCoveredBy(visible, r)) {
+				covered = true;
+				break;
+			}
+		}
+		if (covered) continue;
+
+		painted.push_back(w);
+		if (w->IsOpaque()) {
+			opaque.push_back(visible);
+			if (IsCoveredBy(screen, visible)) {
+				background = false;
+				break;
+			}
+		}
+	}
 
 	/* Until the entire background is covered by the main display, clean the entire display to ensure deleted
 	 * windows truly disappear (even if there is no other window behind it).
 	 */
-	Rectangle32 rect(0, 0, _video.GetXSize(), _video.GetYSize());
-	_video.FillRectangle(rect, MakeRGBA(0, 0, 0, OPAQUE));
-
-	Window *w = _window_manager.bottom;
-	while (w != nullptr) {
-		w->OnDraw();
-		w = w->higher;
+	if (background) _video.FillRectangle(screen, MakeRGBA(0, 0, 0, OPAQUE));
+
+	bool repaint = false; // Whether a window turned out not to be opaque, and windows below it may be missing.
+	for (auto iter = painted.rbegin(); iter != painted.rend(); ++iter) {
+		Window *w = *iter;
+		bool was_opaque = w->IsOpaque();
+		w->Paint();
+		if (was_opaque && !w->IsOpaque()) repaint = true;
 	}
 
 	_video.FinishRepaint();
+	if (repaint) _video.MarkDisplayDirty(screen);
 }
 
-/** A tick has passed, update whatever must be updated. */
+/**
+ * A tick has passed, update whatever must be updated.
+ * @note Painting the windows is done separately, see #UpdateWindows.
+ */
 void WindowManager::Tick()
 {
 	Window *w = _window_manager.top;
 	while (w != nullptr) {
 		if (w->timeout > 0) {
 			w->timeout--;
-			if (w->timeout == 0) w->TimeoutCallback();
+			if (w->timeout == 0) {
+				w->flags |= WF_REPAINT;
+				w->TimeoutCallback();
+			}
 		}
 		w = w->lower;
 	}
-
-	UpdateWindows();
 }
 
 /**
@@ -1029,19 +1293,6 @@ Window *GetWindowByType(WindowTypes wtype, WindowNumber wnumber)
 	return nullptr;
 }
 
-/**
- * Notify the window of the given type of the change with the specified number.
- * @param wtype %Window type to look for.
- * @param wnumber %Window number to look for (use #ALL_WINDOWS_OF_TYPE for any window of type \a wtype).
- * @param code Unique change number.
- * @param parameter Parameter of the change number
- */
-void NotifyChange(WindowTypes wtype, WindowNumber wnumber, ChangeCode code, uint32 parameter)
-{
-	Window *w = GetWindowByType(wtype, wnumber);
-	if (w != nullptr) w->OnChange(code, parameter);
-}
-
 /**
  * Highlight and raise a window of a given type.
  * @param wtype %Window type to look for.
@@ -54,6 +54,8 @@ enum WindowTypes {
 	WC_FINANCES,        ///< Finance management window.
 	WC_SETTING,         ///< Setting window.
 	WC_DROPDOWN,        ///< Dropdown window.
+	WC_PROFILER,        ///< Profiler window.
+	WC_MINIMAP,         ///< Minimap window.
 
 	WC_NONE,            ///< Invalid window type.
 };
@@ -63,14 +65,16 @@ enum ChangeCode {
 	CHG_UPDATE_BUTTONS,   ///< Recompute the state of the buttons.
 	CHG_VIEWPORT_ROTATED, ///< Viewport rotated.
 	CHG_MOUSE_MODE_LOST,  ///< Lost the mouse mode.
-	CHG_DISPLAY_OLD,      ///< Displayed data is old.
+	CHG_DISPLAY_OLD,      ///< Displayed data is old (the parameter is not used, and always \c 0).
 	CHG_PIECE_POSITIONED, ///< The track piece is at the correct position.
 	CHG_DROPDOWN_RESULT,  ///< The selection of a dropdown window.
 };
 
 /** Various state flags of the %Window. */
 enum WindowFlags {
-	WF_HIGHLIGHT = 1 << 0, ///< %Window edge is highlighted.
+	WF_HIGHLIGHT   = 1 << 0, ///< %Window edge is highlighted.
+	WF_REPAINT     = 1 << 1, ///< Contents of the window changed, a stored copy of its pixels is out of date.
+	WF_DISPLAY_OLD = 1 << 2, ///< %Window has been notified of #CHG_DISPLAY_OLD, which is delivered before the next repaint.
 };
 
 /**
@@ -156,6 +160,8 @@ public:
 
 	void MarkDirty();
 
+	virtual void Paint();
+	virtual bool IsOpaque() const;
 	virtual void OnDraw();
 	virtual void OnMouseMoveEvent(const Point16 &pos);
 	virtual WmMouseEvent OnMouseButtonEvent(uint8 state);
@@ -177,6 +183,8 @@ class GuiWindow : public Window {
 public:
 	GuiWindow(WindowTypes wtype, WindowNumber wnumber);
 	virtual ~GuiWindow();
+	virtual void Paint() override;
+	virtual bool IsOpaque() const override;
 	virtual void OnDraw() override;
 
 	virtual void UpdateWidgetSize(WidgetNumber wid_num, BaseWidget *wid);
@@ -252,6 +260,15 @@ private:
 	BaseWidget *tree;     ///< Tree of widgets.
 	BaseWidget **widgets; ///< Array of widgets with a non-negative index (use #GetWidget to get the widgets from this array).
 	uint16 num_widgets;   ///< Number of widgets in #widgets.
+
+	std::vector<uint32> backing; ///< Backing store, copy of the pixels of the window at the screen.
+	Rectangle32 backing_rect;    ///< Screen area stored in #backing (the visible part of #rect when it was stored).
+	bool backing_valid;          ///< Whether #backing holds the current contents of the window.
+	bool backing_opaque;         ///< Whether the window covers its entire #opacity_area (valid if #opacity_known).
+	bool opacity_known;          ///< Whether #backing_opaque was determined for the current widgets and #opacity_area.
+	Rectangle32 opacity_area;    ///< Visible part of the window (relative to its top-left corner) where #backing_opaque was determined.
+
+	void DetermineOpacity();
 };
 
 /**
@@ -312,6 +329,7 @@ inline void GuiWindow::MarkWidgetDirty(WidgetNumber wnum)
 {
 	BaseWidget *bw = this->GetWidget<BaseWidget>(wnum);
 	bw->MarkDirty(this->rect.base);
+	this->flags |= WF_REPAINT;
 }
 
 /**
@@ -330,6 +348,7 @@ public:
 
 	void CloseAllWindows();
 	void ResetAllWindows();
+	void MarkAllWindowsDirty();
 	void RepositionAllWindows();
 
 	void MouseMoveEvent(const Point16 &pos);
@@ -0,0 +1,109 @@
+/* $Id$ */
+
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file worker_pool.cpp Pool of worker threads. */
+
+#include "stdafx.h"
+#include "worker_pool.h"
+#include "math_func.h"
+
+WorkerPool _worker_pool; ///< Worker threads of the program.
+
+WorkerPool::WorkerPool() : job(nullptr), job_count(0), next_job(0), finished_jobs(0), run_number(0), stop(false)
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+	this->StopThreads();
+}
+
+/**
+ * Set the number of threads that perform jobs.
+ * @param count Number of threads, including the thread calling #Run. Use \c 0 to select a count from the available hardware.
+ */
+void WorkerPool::SetThreadCount(int count)
+{
+	if (count <= 0) count = Clamp((int)std::thread::hardware_concurrency(), 1, 8);
+
+	this->StopThreads();
+	this->stop = false;
+	for (int i = 1; i < count; i++) this->threads.emplace_back(&WorkerPool::WorkerMain, this);
+}
+
+/** Stop and remove all worker threads. */
+void WorkerPool::StopThreads()
+{
+	{
+		std::lock_guard<std::mutex> guard(this->lock);
+		this->stop = true;
+	}
+	this->work_available.notify_all();
+	for (std::thread &t : this->threads) t.join();
+	this->threads.clear();
+}
+
+/**
+ * Perform the next job of the current run, if one is available.
+ * @param guard Lock on #lock, temporarily released while performing the job.
+ * @return Whether a job was performed.
+ */
+bool WorkerPool::PerformJob(std::unique_lock<std::mutex> &guard)
+{
+	if (this->next_job >= this->job_count) return false;
+
+	int number = this->next_job++;
+	const JobFunction *func = this->job;
+	guard.unlock();
+	(*func)(number);
+	guard.lock();
+
+	this->finished_jobs++;
+	if (this->finished_jobs == this->job_count) this->work_done.notify_all();
+	return true;
+}
+
+/** Main function of a worker thread. */
+void WorkerPool::WorkerMain()
+{
+	std::unique_lock<std::mutex> guard(this->lock);
+	uint32 last_run = this->run_number;
+	for (;;) {
+		this->work_available.wait(guard, [this, last_run]() { return this->stop || this->run_number != last_run; });
+		if (this->stop) return;
+
+		last_run = this->run_number;
+		while (this->PerformJob(guard)) {}
+	}
+}
+
+/**
+ * Perform a number of jobs, and wait until all of them have finished.
+ * @param job_count Number of jobs to perform.
+ * @param job Function performing a job. It is called once for every job number from \c 0 up to \a job_count, possibly from several threads at the same time.
+ */
+void WorkerPool::Run(int job_count, const JobFunction &job)
+{
+	if (this->threads.empty() || job_count <= 1) {
+		for (int i = 0; i < job_count; i++) job(i);
+		return;
+	}
+
+	std::unique_lock<std::mutex> guard(this->lock);
+	this->job = &job;
+	this->job_count = job_count;
+	this->next_job = 0;
+	this->finished_jobs = 0;
+	this->run_number++;
+	this->work_available.notify_all();
+
+	while (this->PerformJob(guard)) {}
+	this->work_done.wait(guard, [this]() { return this->finished_jobs == this->job_count; });
+	this->job = nullptr;
+}
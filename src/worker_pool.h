@@ -0,0 +1,64 @@
+/* $Id$ */
+
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file worker_pool.h Pool of worker threads. */
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/**
+ * Pool of worker threads for performing a number of independent jobs in parallel.
+ * The thread calling #Run takes part in performing the jobs.
+ */
+class WorkerPool {
+public:
+	typedef std::function<void(int)> JobFunction; ///< Function performing a job, the parameter is the job number.
+
+	WorkerPool();
+	~WorkerPool();
+
+	void SetThreadCount(int count);
+	void Run(int job_count, const JobFunction &job);
+
+	/**
+	 * Get the number of threads performing jobs (including the thread calling #Run).
+	 * @return Number of threads performing jobs.
+	 */
+	inline int GetThreadCount() const
+	{
+		return this->threads.size() + 1;
+	}
+
+private:
+	void WorkerMain();
+	bool PerformJob(std::unique_lock<std::mutex> &guard);
+	void StopThreads();
+
+	std::vector<std::thread> threads; ///< Worker threads.
+	std::mutex lock;                  ///< Lock protecting the data below.
+	std::condition_variable work_available; ///< Signalled when new jobs are available, or the threads should stop.
+	std::condition_variable work_done;      ///< Signalled when the last job has finished.
+
+	const JobFunction *job; ///< Function performing the jobs of the current run.
+	int job_count;     ///< Number of jobs in the current run.
+	int next_job;      ///< Number of the next job to hand out.
+	int finished_jobs; ///< Number of finished jobs in the current run.
+	uint32 run_number; ///< Number of the current run.
+	bool stop;         ///< Worker threads should stop.
+};
+
+extern WorkerPool _worker_pool;
+
+#endif